@@ -41,6 +41,17 @@
 -(id)initWithArray:(CGPDFArrayRef)parr;
 
 
+/** Creates a new instance of PDFArray whose elements are already parsed.
+ 
+ @param elements The elements of the array.
+ @param range The range of data spanned by the array, including its delimiters.
+ @param data The ISO Latin 1 encoded PDF code containing the array.
+ @param parentDocument The parent document containing the array.
+ @return A new PDFArray object. PDFObjectParser uses this initializer so that nested arrays are never parsed a second time.
+ */
+-(id)initWithElements:(NSArray*)elements PDFRepresentationRange:(NSRange)range OfData:(NSData*)data Document:(PDFDocument*)parentDocument;
+
+
 
 /**---------------------------------------------------------------------------------------
  * @name Getting Object Type
@@ -5,6 +5,7 @@
 #import "PDFUtility.h"
 #import "PDFDocument.h"
 #import "PDFObjectParser.h"
+#import "PDFNameTable.h"
 
 @interface PDFArray()
     -(PDFStream*)streamAtIndex:(NSUInteger)index;
@@ -38,6 +39,18 @@
     return self;
 }
 
+-(id)initWithElements:(NSArray*)elements PDFRepresentationRange:(NSRange)range OfData:(NSData*)data Document:(PDFDocument*)parentDocument
+{
+    self = [super initWithPDFRepresentationRange:range OfData:data Document:parentDocument];
+    
+    if(self != nil)
+    {
+        _nsa = elements;
+    }
+    
+    return self;
+}
+
 -(CGPDFObjectType)typeAtIndex:(NSUInteger)aIndex
 {
     CGPDFObjectRef obj = NULL;
@@ -209,7 +222,7 @@
     const char* targ = NULL;
     if(CGPDFArrayGetName(_arr, index, &targ))
     {
-        return @(targ);
+        return [[PDFNameTable tableForDocument:nil] atomForCString:targ];
     }
     
     return nil;
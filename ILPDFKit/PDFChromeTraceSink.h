@@ -0,0 +1,35 @@
+#import <Foundation/Foundation.h>
+#import "PDFTrace.h"
+
+
+/** The PDFChromeTraceSink class collects spans and counters in the Chrome trace event format.
+ The written file can be opened in chrome://tracing or any viewer of the format. Each span becomes a complete event and the counters are sampled at the end of each span in which one of them changed, so they are drawn as tracks above the spans.
+
+     PDFChromeTraceSink* sink = [[PDFChromeTraceSink alloc] init];
+     [PDFTrace setSink:sink];
+     // Work with documents.
+     [PDFTrace setSink:nil];
+     [sink writeToPath:[NSTemporaryDirectory() stringByAppendingPathComponent:@"trace.json"]];
+ */
+@interface PDFChromeTraceSink : NSObject<PDFTraceSink>
+
+
+/** The number of spans collected.
+ */
+@property(nonatomic,readonly) NSUInteger numberOfSpans;
+
+
+/** Writes the collected events.
+
+ @param path The destination path.
+ @return YES if successful, NO if failed.
+ */
+-(BOOL)writeToPath:(NSString*)path;
+
+
+/** Discards the collected events.
+ */
+-(void)removeAllEvents;
+
+
+@end
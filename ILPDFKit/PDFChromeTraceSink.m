@@ -0,0 +1,68 @@
+#import "PDFChromeTraceSink.h"
+
+
+@implementation PDFChromeTraceSink
+{
+    NSMutableArray* _events;
+    int64_t _counterValues[PDFTraceNumberOfCounters];
+}
+
+
+-(id)init
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _events = [[NSMutableArray alloc] init];
+    }
+    return self;
+}
+
+
+-(void)traceSpanWithName:(NSString*)name Start:(uint64_t)start Duration:(uint64_t)duration Thread:(uint64_t)thread
+{
+    NSDictionary* span = @{@"name":(name?name:@""),@"cat":@"ILPDFKit",@"ph":@"X",@"ts":@(start),@"dur":@(duration),@"pid":@1,@"tid":@(thread)};
+
+    @synchronized(self)
+    {
+        [_events addObject:span];
+        _numberOfSpans++;
+
+        // Counters are only sampled when they change, which keeps long traces small.
+        NSMutableDictionary* counters = nil;
+        for(NSUInteger i = 0 ; i < PDFTraceNumberOfCounters ; i++)
+        {
+            int64_t value = [PDFTrace valueOfCounter:(PDFTraceCounter)i];
+            if(value == _counterValues[i])continue;
+            _counterValues[i] = value;
+            if(counters == nil)counters = [NSMutableDictionary dictionary];
+            counters[[PDFTrace nameOfCounter:(PDFTraceCounter)i]] = @(value);
+        }
+        if(counters)[_events addObject:@{@"name":@"counters",@"ph":@"C",@"ts":@(start+duration),@"pid":@1,@"args":counters}];
+    }
+}
+
+
+-(BOOL)writeToPath:(NSString*)path
+{
+    NSData* data = nil;
+    @synchronized(self)
+    {
+        data = [NSJSONSerialization dataWithJSONObject:@{@"traceEvents":_events,@"displayTimeUnit":@"ms"} options:0 error:NULL];
+    }
+    return [data writeToFile:path atomically:YES];
+}
+
+
+-(void)removeAllEvents
+{
+    @synchronized(self)
+    {
+        [_events removeAllObjects];
+        _numberOfSpans = 0;
+        memset(_counterValues, 0, sizeof(_counterValues));
+    }
+}
+
+
+@end
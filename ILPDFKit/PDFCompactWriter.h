@@ -0,0 +1,75 @@
+#import <Foundation/Foundation.h>
+
+@class PDFDocument;
+
+
+/** The PDFCompactWriter class writes a compacted copy of a PDFDocument.
+ Documents that are filled and saved repeatedly accumulate incremental updates, each with its own cross-reference section, along with superseded and unreachable objects. PDFCompactWriter walks the live object graph from the trailer. It writes each reachable object once, renumbered densely from 1 with generation number 0, and finishes with a single cross-reference section. The resulting file is read in one pass.
+ 
+     PDFCompactWriter* writer = [[PDFCompactWriter alloc] initWithDocument:document];
+     writer.usesObjectStreams = YES;
+     if([writer writeToPath:path])
+     {
+        NSUInteger catalogNumber = [writer newObjectNumberForObjectNumber:oldCatalogNumber];
+     }
+ 
+ Objects are read from the document one at a time and written through a PDFFileWriter, so memory use is bounded by the largest object rather than by the file. Encrypted documents cannot be compacted, because their strings and streams are encrypted with keys derived from the original object numbers.
+ 
+ The compacted file may also be linearized, in which case the objects are laid out page by page and indexed by hint tables, as described in Annex F of the PDF specification.
+ */
+@interface PDFCompactWriter : NSObject
+
+
+/** The document to compact.
+ */
+@property(nonatomic,readonly) PDFDocument* document;
+
+/** If YES, every object that is not a stream is packed into compressed object streams and the cross-reference section is written as a cross-reference stream, which requires PDF 1.5. The default is NO.
+ */
+@property(nonatomic) BOOL usesObjectStreams;
+
+/** If YES, the file is linearized for fast web view. The catalog, the page tree, the objects of the first page and a primary hint stream come first, followed by the objects of each other page in page order, so a viewer can show the first page, and find any other, before the rest of the file has arrived. The default is NO.
+ @discussion A page owns every object reachable from it without passing through the catalog or the page tree, so its widget annotations, their fields and their appearances follow it. Objects reachable from several pages other than the first are written together after the last page. A linearized file uses classic cross-reference tables, so usesObjectStreams is ignored. Its objects are read from the document three times: to find the pages that use them, to measure them and to write them.
+ */
+@property(nonatomic) BOOL linearized;
+
+/** Code that replaces the code of some objects of the document, keyed by object number. Used to include unsaved changes, such as modified form fields, in the compacted file.
+ */
+@property(nonatomic,strong) NSDictionary* replacementCodes;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Creating a PDFCompactWriter
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Creates a new instance of PDFCompactWriter.
+ 
+ @param document The document to compact.
+ @return A new PDFCompactWriter.
+ */
+-(id)initWithDocument:(PDFDocument*)document;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Writing
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Writes the compacted document.
+ 
+ @param path The destination path. It may be the path the document was loaded from.
+ @return YES if successful, NO if failed.
+ */
+-(BOOL)writeToPath:(NSString*)path;
+
+
+/** Maps an object number of the document to its number in the compacted file.
+ 
+ @param objectNumber The object number in the document.
+ @return The object number in the last file written, or NSNotFound if the object was not written.
+ */
+-(NSUInteger)newObjectNumberForObjectNumber:(NSUInteger)objectNumber;
+
+
+@end
@@ -0,0 +1,911 @@
+#import "PDFCompactWriter.h"
+#import "PDFDocument.h"
+#import "PDFDictionary.h"
+#import "PDFObject.h"
+#import "PDFLexer.h"
+#import "PDFFileWriter.h"
+#import "PDFUtility.h"
+
+// The number of objects packed into each object stream.
+#define PDFCompactWriterObjectsPerStream 100
+
+// The owner of an object reachable from more than one page other than the first, in a linearized file.
+#define PDFCompactWriterSharedOwner (NSNotFound-1)
+
+
+/* A reference 'n g R' found in the code of an object.
+
+ - range: The span of the reference in the code.
+ - objectNumber: The object number referenced.
+ - generationNumber: The generation number referenced.
+ */
+typedef struct
+{
+    NSRange range;
+    NSUInteger objectNumber;
+    NSUInteger generationNumber;
+}
+PDFCompactWriterReference;
+
+
+/* An entry of the cross-reference section of the compacted file, with the fields of a cross-reference stream entry.
+ */
+typedef struct
+{
+    NSUInteger type;
+    NSUInteger field2;
+    NSUInteger field3;
+}
+PDFCompactWriterEntry;
+
+
+/* The parts of a linearized file an object may be assigned to before its page is known.
+ */
+enum
+{
+    PDFCompactWriterPartNone = 0,
+    PDFCompactWriterPartDocument,
+    PDFCompactWriterPartPage
+};
+
+
+/* Bits pending in a hint table, written most significant first.
+ */
+typedef struct
+{
+    unsigned long long buffer;
+    NSUInteger count;
+}
+PDFCompactWriterBits;
+
+
+static void PDFCompactWriterWriteBits(NSMutableData* data, PDFCompactWriterBits* bits, NSUInteger value, NSUInteger width)
+{
+    for(NSUInteger i = width ; i > 0 ; i--)
+    {
+        bits->buffer = (bits->buffer << 1)|((value >> (i-1)) & 1);
+        if(++bits->count == 8)
+        {
+            unsigned char byte = (unsigned char)bits->buffer;
+            [data appendBytes:&byte length:1];
+            bits->buffer = 0;
+            bits->count = 0;
+        }
+    }
+}
+
+
+// Each item of a hint table starts on a byte boundary, so the last byte of the previous item is padded with zero bits.
+static void PDFCompactWriterFlushBits(NSMutableData* data, PDFCompactWriterBits* bits)
+{
+    if(bits->count > 0)PDFCompactWriterWriteBits(data, bits, 0, 8-bits->count);
+}
+
+
+// The number of bits needed to write value, which is 0 for 0.
+static NSUInteger PDFCompactWriterBitWidth(NSUInteger value)
+{
+    NSUInteger ret = 0;
+    while(value != 0)
+    {
+        ret++;
+        value >>= 1;
+    }
+    return ret;
+}
+
+
+@interface PDFCompactWriter()
+    -(NSData*)codeForObjectWithNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber;
+    -(NSData*)referencesInCode:(NSData*)code IsStream:(BOOL*)isStream IsExcluded:(BOOL*)isExcluded;
+    -(NSData*)renumberedCode:(NSData*)code References:(NSData*)references;
+    -(BOOL)collectObjects;
+    -(NSData*)trailerEntries;
+    -(BOOL)writeObjectStream;
+    -(NSString*)renumberedTrailerEntries;
+    -(BOOL)writeIndirectObjectWithNumber:(NSUInteger)objectNumber Code:(NSData*)code;
+    -(BOOL)writeClassicCrossReferenceSection;
+    -(BOOL)writeCrossReferenceStream;
+    -(NSData*)fileHeader;
+    -(BOOL)writeLinearizedToPath:(NSString*)path;
+    -(BOOL)orderObjectsForLinearization;
+    -(NSUInteger)indexOfObjectWithNumber:(NSUInteger)objectNumber;
+    -(NSData*)codeForObjectAtIndex:(NSUInteger)index;
+    -(NSRange)rangeOfEntry:(const char*)key InCode:(NSData*)code;
+    -(NSData*)hintStreamObjectWithNumber:(NSUInteger)objectNumber Lengths:(const NSUInteger*)lengths Offsets:(const NSUInteger*)offsets;
+    -(NSUInteger)lengthOfIndirectObjectWithNumber:(NSUInteger)objectNumber Code:(NSData*)code;
+@end
+
+
+@implementation PDFCompactWriter
+{
+    PDFFileWriter* _writer;
+    NSMutableArray* _objectNumbers;
+    NSMutableArray* _generationNumbers;
+    NSMutableDictionary* _newObjectNumbers;
+    NSMutableData* _entries;
+    NSMutableData* _packedHeader;
+    NSMutableData* _packedCode;
+    NSUInteger _packedCount;
+    NSUInteger _packedStreamNumber;
+    NSMutableArray* _objectReferences;
+    NSMutableData* _order;
+    NSUInteger _documentObjectCount;
+    NSMutableData* _pageObjectCounts;
+    NSUInteger _sharedObjectCount;
+    NSMutableArray* _sharedIdentifiers;
+}
+
+
+-(id)initWithDocument:(PDFDocument*)document
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _document = document;
+    }
+    return self;
+}
+
+
+-(BOOL)writeToPath:(NSString*)path
+{
+    // Strings and streams of encrypted documents are keyed on their object numbers, so they cannot be renumbered.
+    if([self.document.trailer objectForKey:@"Encrypt"] != nil)return NO;
+    if(self.linearized)return [self writeLinearizedToPath:path];
+    if([self collectObjects] == NO)return NO;
+
+    _writer = [[PDFFileWriter alloc] initWithPath:path];
+    if(_writer == nil)return NO;
+
+    NSUInteger count = [_objectNumbers count];
+    _entries = [NSMutableData dataWithLength:(count+1)*sizeof(PDFCompactWriterEntry)];
+    PDFCompactWriterEntry* entries = [_entries mutableBytes];
+    entries[0].type = 0;
+    entries[0].field3 = 65535;
+    _packedHeader = [NSMutableData data];
+    _packedCode = [NSMutableData data];
+    _packedCount = 0;
+    _packedStreamNumber = count+1;
+
+    BOOL ret = [_writer appendData:[self fileHeader]];
+
+    for(NSUInteger i = 0 ; ret && i < count ; i++)
+    {
+        NSData* code = [self codeForObjectWithNumber:[_objectNumbers[i] unsignedIntegerValue] GenerationNumber:[_generationNumbers[i] unsignedIntegerValue]];
+        if(code == nil)
+        {
+            ret = NO;
+            break;
+        }
+        
+        BOOL isStream = NO, isExcluded = NO;
+        NSData* references = [self referencesInCode:code IsStream:&isStream IsExcluded:&isExcluded];
+        NSData* newCode = [self renumberedCode:code References:references];
+        entries = [_entries mutableBytes];
+
+        if(self.usesObjectStreams && isStream == NO)
+        {
+            entries[i+1].type = 2;
+            entries[i+1].field2 = _packedStreamNumber;
+            entries[i+1].field3 = _packedCount;
+            [_packedHeader appendData:[[NSString stringWithFormat:@"%u %u ",(unsigned int)(i+1),(unsigned int)[_packedCode length]] dataUsingEncoding:NSISOLatin1StringEncoding]];
+            [_packedCode appendData:newCode];
+            [_packedCode appendBytes:"\n" length:1];
+            _packedCount++;
+            if(_packedCount == PDFCompactWriterObjectsPerStream)ret = [self writeObjectStream];
+        }
+        else
+        {
+            entries[i+1].type = 1;
+            entries[i+1].field2 = _writer.length;
+            ret = [self writeIndirectObjectWithNumber:i+1 Code:newCode];
+        }
+    }
+
+    if(ret && _packedCount > 0)ret = [self writeObjectStream];
+    if(ret)ret = (self.usesObjectStreams?[self writeCrossReferenceStream]:[self writeClassicCrossReferenceSection]);
+    if(ret)ret = [_writer commit];
+    if(ret == NO)[_writer cancel];
+
+    _writer = nil;
+    _entries = nil;
+    _packedHeader = nil;
+    _packedCode = nil;
+    return ret;
+}
+
+
+-(NSUInteger)newObjectNumberForObjectNumber:(NSUInteger)objectNumber
+{
+    NSNumber* ret = _newObjectNumbers[@(objectNumber)];
+    return (ret?[ret unsignedIntegerValue]:NSNotFound);
+}
+
+
+#pragma mark - Hidden
+
+
+-(NSData*)codeForObjectWithNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber
+{
+    NSString* code = self.replacementCodes[@(objectNumber)];
+    if(code == nil)code = [self.document codeForObjectWithNumber:objectNumber GenerationNumber:generationNumber];
+    return [PDFUtility dataWithObjectCode:code];
+}
+
+
+// Only the tokens before a 'stream' keyword are searched, so stream data is never tokenized.
+
+-(NSData*)referencesInCode:(NSData*)code IsStream:(BOOL*)isStream IsExcluded:(BOOL*)isExcluded
+{
+    NSMutableData* ret = [NSMutableData data];
+    PDFLexer* lexer = [[PDFLexer alloc] initWithData:code];
+    BOOL afterType = NO;
+
+    while(YES)
+    {
+        PDFToken token = [lexer nextToken];
+        if(token.type == PDFTokenTypeEnd)break;
+
+        if([lexer token:token IsKeyword:"stream"])
+        {
+            if(isStream)*isStream = YES;
+            break;
+        }
+
+        // Object streams and cross-reference streams of the source describe its layout, so they are not copied.
+        if(token.type == PDFTokenTypeName && afterType)
+        {
+            NSString* type = [lexer stringWithRange:NSMakeRange(token.offset+1, token.length-1)];
+            if(isExcluded && ([type isEqualToString:@"ObjStm"] || [type isEqualToString:@"XRef"]))*isExcluded = YES;
+        }
+        afterType = (token.type == PDFTokenTypeName && token.length == 5 && memcmp(lexer.bytes+token.offset, "/Type", 5) == 0);
+
+        if(token.type == PDFTokenTypeNumber)
+        {
+            NSUInteger afterNumber = lexer.position;
+            PDFToken generationToken = [lexer nextToken];
+            PDFToken referenceToken = [lexer nextToken];
+            if(generationToken.type == PDFTokenTypeNumber && [lexer token:referenceToken IsKeyword:"R"])
+            {
+                PDFCompactWriterReference reference;
+                reference.range = NSMakeRange(token.offset, referenceToken.offset+referenceToken.length-token.offset);
+                reference.objectNumber = [lexer integerValueOfToken:token];
+                reference.generationNumber = [lexer integerValueOfToken:generationToken];
+                [ret appendBytes:&reference length:sizeof(reference)];
+            }
+            else lexer.position = afterNumber;
+        }
+    }
+
+    return ret;
+}
+
+
+-(NSData*)renumberedCode:(NSData*)code References:(NSData*)references
+{
+    NSMutableData* ret = [NSMutableData dataWithCapacity:[code length]];
+    const PDFCompactWriterReference* reference = [references bytes];
+    NSUInteger count = [references length]/sizeof(PDFCompactWriterReference);
+    NSUInteger location = 0;
+
+    for(NSUInteger i = 0 ; i < count ; i++)
+    {
+        [ret appendBytes:(const char*)[code bytes]+location length:reference[i].range.location-location];
+
+        // A reference to an object that does not exist is equivalent to null.
+        NSUInteger newNumber = [self newObjectNumberForObjectNumber:reference[i].objectNumber];
+        NSString* replacement = (newNumber == NSNotFound?@"null":[NSString stringWithFormat:@"%u 0 R",(unsigned int)newNumber]);
+        [ret appendData:[replacement dataUsingEncoding:NSISOLatin1StringEncoding]];
+        location = NSMaxRange(reference[i].range);
+    }
+
+    [ret appendBytes:(const char*)[code bytes]+location length:[code length]-location];
+    return ret;
+}
+
+
+// Objects are numbered in the order they are reached from the trailer, breadth first, so the catalog is object 1 and related objects end up close together.
+
+-(BOOL)collectObjects
+{
+    _objectNumbers = [NSMutableArray array];
+    _generationNumbers = [NSMutableArray array];
+    _newObjectNumbers = [NSMutableDictionary dictionary];
+    _objectReferences = (self.linearized?[NSMutableArray array]:nil);
+
+    NSData* trailer = [self trailerEntries];
+    if(trailer == nil)return NO;
+
+    NSMutableArray* queue = [NSMutableArray array];
+    NSMutableSet* queued = [NSMutableSet set];
+    NSData* references = [self referencesInCode:trailer IsStream:NULL IsExcluded:NULL];
+    NSUInteger head = 0;
+
+    while(references != nil)
+    {
+        const PDFCompactWriterReference* reference = [references bytes];
+        for(NSUInteger i = 0 ; i < [references length]/sizeof(PDFCompactWriterReference) ; i++)
+        {
+            if([queued containsObject:@(reference[i].objectNumber)])continue;
+            [queued addObject:@(reference[i].objectNumber)];
+            [queue addObject:@[@(reference[i].objectNumber),@(reference[i].generationNumber)]];
+        }
+
+        references = nil;
+        while(references == nil && head < [queue count])
+        {
+            NSNumber* objectNumber = queue[head][0];
+            NSNumber* generationNumber = queue[head][1];
+            head++;
+
+            NSData* code = [self codeForObjectWithNumber:[objectNumber unsignedIntegerValue] GenerationNumber:[generationNumber unsignedIntegerValue]];
+            if(code == nil)continue;
+
+            BOOL isExcluded = NO;
+            NSData* found = [self referencesInCode:code IsStream:NULL IsExcluded:&isExcluded];
+            if(isExcluded)continue;
+
+            [_objectNumbers addObject:objectNumber];
+            [_generationNumbers addObject:generationNumber];
+            _newObjectNumbers[objectNumber] = @([_objectNumbers count]);
+            [_objectReferences addObject:found];
+            references = found;
+        }
+    }
+
+    return [_objectNumbers count] > 0;
+}
+
+
+// The entries of the source trailer that still apply to the compacted file.
+
+-(NSData*)trailerEntries
+{
+    NSString* trailer = [self.document.trailer pdfFileRepresentation];
+    if(trailer == nil)return nil;
+
+    NSData* data = [trailer dataUsingEncoding:NSISOLatin1StringEncoding allowLossyConversion:YES];
+    PDFLexer* lexer = [[PDFLexer alloc] initWithData:data];
+    if([lexer nextToken].type != PDFTokenTypeDictionaryOpen)return nil;
+
+    NSMutableData* ret = [NSMutableData data];
+    while(YES)
+    {
+        PDFToken key = [lexer nextToken];
+        if(key.type != PDFTokenTypeName)break;
+        NSRange range = [lexer skipObject];
+        if(range.location == NSNotFound)break;
+
+        NSString* name = [lexer stringWithRange:NSMakeRange(key.offset+1, key.length-1)];
+        if([name isEqualToString:@"Root"] || [name isEqualToString:@"Info"] || [name isEqualToString:@"ID"])
+        {
+            [ret appendData:[data subdataWithRange:NSMakeRange(key.offset, NSMaxRange(range)-key.offset)]];
+            [ret appendBytes:"\n" length:1];
+        }
+    }
+
+    return ret;
+}
+
+
+-(BOOL)writeObjectStream
+{
+    NSMutableData* content = [NSMutableData dataWithData:_packedHeader];
+    NSUInteger first = [content length];
+    [content appendData:_packedCode];
+
+    NSData* encoded = [PDFUtility flateEncodedData:content];
+    if(encoded == nil)return NO;
+
+    NSMutableData* code = [NSMutableData data];
+    [code appendData:[[NSString stringWithFormat:@"<</Type /ObjStm /N %u /First %u /Filter /FlateDecode /Length %u>>\nstream\n",(unsigned int)_packedCount,(unsigned int)first,(unsigned int)[encoded length]] dataUsingEncoding:NSISOLatin1StringEncoding]];
+    [code appendData:encoded];
+    [code appendBytes:"\nendstream" length:10];
+
+    NSUInteger objectNumber = _packedStreamNumber;
+    [_entries increaseLengthBy:sizeof(PDFCompactWriterEntry)];
+    PDFCompactWriterEntry* entry = (PDFCompactWriterEntry*)[_entries mutableBytes]+objectNumber;
+    entry->type = 1;
+    entry->field2 = _writer.length;
+
+    [_packedHeader setLength:0];
+    [_packedCode setLength:0];
+    _packedCount = 0;
+    _packedStreamNumber++;
+
+    return [self writeIndirectObjectWithNumber:objectNumber Code:code];
+}
+
+
+-(NSString*)renumberedTrailerEntries
+{
+    NSData* trailer = [self trailerEntries];
+    NSData* references = [self referencesInCode:trailer IsStream:NULL IsExcluded:NULL];
+    return [[NSString alloc] initWithData:[self renumberedCode:trailer References:references] encoding:NSISOLatin1StringEncoding];
+}
+
+
+-(BOOL)writeIndirectObjectWithNumber:(NSUInteger)objectNumber Code:(NSData*)code
+{
+    NSData* header = [[NSString stringWithFormat:@"%u 0 obj\n",(unsigned int)objectNumber] dataUsingEncoding:NSISOLatin1StringEncoding];
+    return [_writer appendData:header] && [_writer appendData:code] && [_writer appendData:[NSData dataWithBytes:"\nendobj\n" length:8]];
+}
+
+
+-(BOOL)writeClassicCrossReferenceSection
+{
+    NSUInteger xrefOffset = _writer.length;
+    NSUInteger count = [_entries length]/sizeof(PDFCompactWriterEntry);
+    const PDFCompactWriterEntry* entries = [_entries bytes];
+
+    NSMutableString* xref = [NSMutableString stringWithFormat:@"xref\n0 %u\n0000000000 65535 f\r\n",(unsigned int)count];
+    for(NSUInteger i = 1 ; i < count ; i++)[xref appendFormat:@"%010u 00000 n\r\n",(unsigned int)entries[i].field2];
+
+    [xref appendFormat:@"trailer\n<</Size %u\n%@>>\nstartxref\n%u\n%%%%EOF\n",(unsigned int)count,[self renumberedTrailerEntries],(unsigned int)xrefOffset];
+    return [_writer appendData:[xref dataUsingEncoding:NSISOLatin1StringEncoding allowLossyConversion:YES]];
+}
+
+
+-(BOOL)writeCrossReferenceStream
+{
+    // The cross-reference stream is the last object and lists itself.
+    NSUInteger xrefOffset = _writer.length;
+    [_entries increaseLengthBy:sizeof(PDFCompactWriterEntry)];
+    NSUInteger count = [_entries length]/sizeof(PDFCompactWriterEntry);
+    PDFCompactWriterEntry* entries = [_entries mutableBytes];
+    entries[count-1].type = 1;
+    entries[count-1].field2 = xrefOffset;
+
+    NSUInteger offsetWidth = 1;
+    while(offsetWidth < sizeof(NSUInteger) && (xrefOffset >> (8*offsetWidth)) != 0)offsetWidth++;
+
+    NSMutableData* content = [NSMutableData dataWithCapacity:count*(offsetWidth+3)];
+    for(NSUInteger i = 0 ; i < count ; i++)
+    {
+        unsigned char row[sizeof(NSUInteger)+3];
+        row[0] = (unsigned char)entries[i].type;
+        for(NSUInteger j = 0 ; j < offsetWidth ; j++)row[1+j] = (unsigned char)(entries[i].field2 >> (8*(offsetWidth-1-j)));
+        row[1+offsetWidth] = (unsigned char)(entries[i].field3 >> 8);
+        row[2+offsetWidth] = (unsigned char)entries[i].field3;
+        [content appendBytes:row length:offsetWidth+3];
+    }
+
+    NSData* encoded = [PDFUtility flateEncodedData:content];
+    if(encoded == nil)return NO;
+
+    NSMutableData* code = [NSMutableData data];
+    [code appendData:[[NSString stringWithFormat:@"%u 0 obj\n<</Type /XRef /Size %u /W [1 %u 2] /Filter /FlateDecode /Length %u\n%@>>\nstream\n",(unsigned int)(count-1),(unsigned int)count,(unsigned int)offsetWidth,(unsigned int)[encoded length],[self renumberedTrailerEntries]] dataUsingEncoding:NSISOLatin1StringEncoding allowLossyConversion:YES]];
+    [code appendData:encoded];
+    [code appendData:[[NSString stringWithFormat:@"\nendstream\nendobj\nstartxref\n%u\n%%%%EOF\n",(unsigned int)xrefOffset] dataUsingEncoding:NSISOLatin1StringEncoding]];
+    return [_writer appendData:code];
+}
+
+
+// The comment of bytes above 127 following the header marks the file as binary.
+
+-(NSData*)fileHeader
+{
+    // Object streams and cross-reference streams need PDF 1.5.
+    int major = 1, minor = 4;
+    if(self.document.document)CGPDFDocumentGetVersion(self.document.document, &major, &minor);
+    if(self.usesObjectStreams && self.linearized == NO && major == 1 && minor < 5)minor = 5;
+    
+    NSMutableData* ret = [NSMutableData dataWithData:[[NSString stringWithFormat:@"%%PDF-%d.%d\n",major,minor] dataUsingEncoding:NSISOLatin1StringEncoding]];
+    const unsigned char binaryComment[] = {'%',0xE2,0xE3,0xCF,0xD3,'\n'};
+    [ret appendBytes:binaryComment length:sizeof(binaryComment)];
+    return ret;
+}
+
+
+#pragma mark - Linearization
+
+
+// The file is laid out as the header, the linearization dictionary, the cross-reference section of the first page, the catalog and page tree, the primary hint stream, the first page, the other pages, the shared objects, the remaining objects and the main cross-reference section. Every offset is computed from measured object lengths before anything is written, so nothing has to be patched afterwards.
+
+-(BOOL)writeLinearizedToPath:(NSString*)path
+{
+    if([self collectObjects] == NO || [self orderObjectsForLinearization] == NO)return NO;
+
+    NSUInteger count = [_objectNumbers count];
+    NSUInteger pageCount = [_pageObjectCounts length]/sizeof(NSUInteger);
+    const NSUInteger* order = [_order bytes];
+    NSUInteger firstPageEnd = _documentObjectCount+((const NSUInteger*)[_pageObjectCounts bytes])[0];
+    NSUInteger remainingCount = count-firstPageEnd;
+    NSUInteger linearizationNumber = remainingCount+1;
+    NSUInteger hintNumber = remainingCount+2+firstPageEnd;
+
+    NSMutableData* lengthData = [NSMutableData dataWithLength:count*sizeof(NSUInteger)];
+    NSMutableData* offsetData = [NSMutableData dataWithLength:count*sizeof(NSUInteger)];
+    NSUInteger* lengths = [lengthData mutableBytes];
+    NSUInteger* offsets = [offsetData mutableBytes];
+
+    for(NSUInteger k = 0 ; k < count ; k++)
+    {
+        NSData* code = [self codeForObjectAtIndex:order[k]];
+        if(code == nil)return NO;
+        NSData* newCode = [self renumberedCode:code References:[self referencesInCode:code IsStream:NULL IsExcluded:NULL]];
+        lengths[k] = [self lengthOfIndirectObjectWithNumber:[self newObjectNumberForObjectNumber:[_objectNumbers[order[k]] unsignedIntegerValue]] Code:newCode];
+    }
+
+    // The linearization dictionary and the first cross-reference section have fixed widths, so they are measured with placeholder values.
+    NSData* header = [self fileHeader];
+    NSString* trailerEntries = [self renumberedTrailerEntries];
+    NSString* linearizationFormat = @"%u 0 obj\n<</Linearized 1 /L %010u /H [%010u %010u] /O %u /E %010u /N %u /T %010u>>\nendobj\n";
+    NSUInteger firstPageNumber = remainingCount+2+_documentObjectCount;
+    NSUInteger linearizationLength = [[NSString stringWithFormat:linearizationFormat,(unsigned int)linearizationNumber,0,0,0,(unsigned int)firstPageNumber,0,(unsigned int)pageCount,0] length];
+    NSUInteger firstTableOffset = [header length]+linearizationLength;
+    NSUInteger firstTableLength = [[NSString stringWithFormat:@"xref\n%u %u\n",(unsigned int)linearizationNumber,(unsigned int)(firstPageEnd+2)] length]+20*(firstPageEnd+2);
+    firstTableLength += [[NSString stringWithFormat:@"trailer\n<</Size %u /Prev %010u\n%@>>\nstartxref\n0\n%%%%EOF\n",(unsigned int)(hintNumber+1),0,trailerEntries] length];
+
+    // Hint tables give every location as if the hint stream were absent, so they are built from these offsets before its length is known.
+    NSUInteger position = firstTableOffset+firstTableLength;
+    for(NSUInteger k = 0 ; k < count ; k++)
+    {
+        offsets[k] = position;
+        position += lengths[k];
+    }
+
+    NSUInteger hintOffset = offsets[_documentObjectCount];
+    NSData* hintObject = [self hintStreamObjectWithNumber:hintNumber Lengths:lengths Offsets:offsets];
+    if(hintObject == nil)return NO;
+    NSUInteger hintLength = [hintObject length];
+    for(NSUInteger k = _documentObjectCount ; k < count ; k++)offsets[k] += hintLength;
+
+    NSUInteger firstPageEndOffset = offsets[firstPageEnd-1]+lengths[firstPageEnd-1];
+    NSUInteger mainTableOffset = position+hintLength;
+
+    NSMutableString* mainTable = [NSMutableString stringWithFormat:@"xref\n0 %u\n0000000000 65535 f\r\n",(unsigned int)(remainingCount+1)];
+    NSUInteger mainEntriesOffset = mainTableOffset+[[NSString stringWithFormat:@"xref\n0 %u",(unsigned int)(remainingCount+1)] length];
+    for(NSUInteger k = firstPageEnd ; k < count ; k++)[mainTable appendFormat:@"%010u 00000 n\r\n",(unsigned int)offsets[k]];
+    [mainTable appendFormat:@"trailer\n<</Size %u>>\nstartxref\n%u\n%%%%EOF\n",(unsigned int)(remainingCount+1),(unsigned int)firstTableOffset];
+    NSUInteger fileLength = mainTableOffset+[mainTable length];
+
+    NSString* linearization = [NSString stringWithFormat:linearizationFormat,(unsigned int)linearizationNumber,(unsigned int)fileLength,(unsigned int)hintOffset,(unsigned int)hintLength,(unsigned int)firstPageNumber,(unsigned int)firstPageEndOffset,(unsigned int)pageCount,(unsigned int)mainEntriesOffset];
+
+    // The first section lists the linearization dictionary, the catalog and page tree, the first page and the hint stream, whose numbers follow the numbers of every other object.
+    NSMutableString* firstTable = [NSMutableString stringWithFormat:@"xref\n%u %u\n%010u 00000 n\r\n",(unsigned int)linearizationNumber,(unsigned int)(firstPageEnd+2),(unsigned int)[header length]];
+    for(NSUInteger k = 0 ; k < firstPageEnd ; k++)[firstTable appendFormat:@"%010u 00000 n\r\n",(unsigned int)offsets[k]];
+    [firstTable appendFormat:@"%010u 00000 n\r\n",(unsigned int)hintOffset];
+    [firstTable appendFormat:@"trailer\n<</Size %u /Prev %010u\n%@>>\nstartxref\n0\n%%%%EOF\n",(unsigned int)(hintNumber+1),(unsigned int)mainTableOffset,trailerEntries];
+
+    _writer = [[PDFFileWriter alloc] initWithPath:path];
+    if(_writer == nil)return NO;
+
+    BOOL ret = [_writer appendData:header];
+    if(ret)ret = [_writer appendData:[linearization dataUsingEncoding:NSISOLatin1StringEncoding]];
+    if(ret)ret = [_writer appendData:[firstTable dataUsingEncoding:NSISOLatin1StringEncoding allowLossyConversion:YES]];
+    if(ret)ret = (_writer.length == firstTableOffset+firstTableLength);
+
+    for(NSUInteger k = 0 ; ret && k < count ; k++)
+    {
+        if(k == _documentObjectCount)ret = [_writer appendData:hintObject];
+
+        // Objects are written from the same code they were measured from, so a different offset means the document changed in between.
+        NSData* code = [self codeForObjectAtIndex:order[k]];
+        if(ret == NO || code == nil || _writer.length != offsets[k])
+        {
+            ret = NO;
+            break;
+        }
+
+        NSData* newCode = [self renumberedCode:code References:[self referencesInCode:code IsStream:NULL IsExcluded:NULL]];
+        ret = [self writeIndirectObjectWithNumber:[self newObjectNumberForObjectNumber:[_objectNumbers[order[k]] unsignedIntegerValue]] Code:newCode];
+    }
+
+    if(ret)ret = (_writer.length == mainTableOffset) && [_writer appendData:[mainTable dataUsingEncoding:NSISOLatin1StringEncoding]];
+    if(ret)ret = [_writer commit];
+    if(ret == NO)[_writer cancel];
+
+    _writer = nil;
+    _objectReferences = nil;
+    _order = nil;
+    _pageObjectCounts = nil;
+    _sharedIdentifiers = nil;
+    return ret;
+}
+
+
+// Sorts the collected objects into the parts of a linearized file and numbers them. Pages are claimed in page order, so an object the first page reaches always stays with the first page.
+
+-(BOOL)orderObjectsForLinearization
+{
+    NSUInteger count = [_objectNumbers count];
+    PDFObject* root = [self.document.trailer objectForKey:@"Root"];
+    if([root isMemberOfClass:[PDFObject class]] == NO)return NO;
+    NSUInteger catalog = [self indexOfObjectWithNumber:root.objectNumber];
+    if(catalog == NSNotFound)return NO;
+
+    NSMutableData* partData = [NSMutableData dataWithLength:count];
+    unsigned char* parts = [partData mutableBytes];
+    parts[catalog] = PDFCompactWriterPartDocument;
+
+    NSData* catalogCode = [self codeForObjectAtIndex:catalog];
+    NSRange pagesRange = [self rangeOfEntry:"Pages" InCode:catalogCode];
+    NSRange acroFormRange = [self rangeOfEntry:"AcroForm" InCode:catalogCode];
+    if(pagesRange.location == NSNotFound)return NO;
+
+    NSData* found = nil;
+    if(acroFormRange.location != NSNotFound)
+    {
+        found = [self referencesInCode:[catalogCode subdataWithRange:acroFormRange] IsStream:NULL IsExcluded:NULL];
+        NSUInteger acroForm = ([found length] > 0?[self indexOfObjectWithNumber:((const PDFCompactWriterReference*)[found bytes])->objectNumber]:NSNotFound);
+        if(acroForm != NSNotFound)parts[acroForm] = PDFCompactWriterPartDocument;
+    }
+
+    // The page tree is walked depth first, so leaves are found in page order. Marked nodes are not walked twice.
+    NSMutableArray* leaves = [NSMutableArray array];
+    NSMutableArray* stack = [NSMutableArray array];
+    found = [self referencesInCode:[catalogCode subdataWithRange:pagesRange] IsStream:NULL IsExcluded:NULL];
+    if([found length] > 0)[stack addObject:@([self indexOfObjectWithNumber:((const PDFCompactWriterReference*)[found bytes])->objectNumber])];
+
+    while([stack count] > 0)
+    {
+        NSUInteger node = [[stack lastObject] unsignedIntegerValue];
+        [stack removeLastObject];
+        if(node == NSNotFound || parts[node] != PDFCompactWriterPartNone)continue;
+
+        NSData* code = [self codeForObjectAtIndex:node];
+        NSRange kidsRange = [self rangeOfEntry:"Kids" InCode:code];
+        if(kidsRange.location == NSNotFound)
+        {
+            parts[node] = PDFCompactWriterPartPage;
+            [leaves addObject:@(node)];
+            continue;
+        }
+
+        parts[node] = PDFCompactWriterPartDocument;
+        NSData* kids = [self referencesInCode:[code subdataWithRange:kidsRange] IsStream:NULL IsExcluded:NULL];
+        const PDFCompactWriterReference* kid = [kids bytes];
+        for(NSUInteger i = [kids length]/sizeof(PDFCompactWriterReference) ; i > 0 ; i--)[stack addObject:@([self indexOfObjectWithNumber:kid[i-1].objectNumber])];
+    }
+
+    NSUInteger pageCount = [leaves count];
+    if(pageCount == 0)return NO;
+
+    // Each page claims what it reaches without passing through the catalog, the form dictionary or the page tree, so a 'Parent' or 'P' entry does not lead to the other pages.
+    NSMutableData* ownerData = [NSMutableData dataWithLength:count*sizeof(NSUInteger)];
+    NSMutableData* stampData = [NSMutableData dataWithLength:count*sizeof(NSUInteger)];
+    NSUInteger* owners = [ownerData mutableBytes];
+    NSUInteger* stamps = [stampData mutableBytes];
+    for(NSUInteger i = 0 ; i < count ; i++)owners[i] = NSNotFound;
+    NSMutableArray* reached = [NSMutableArray arrayWithCapacity:pageCount];
+
+    for(NSUInteger p = 0 ; p < pageCount ; p++)
+    {
+        NSUInteger leaf = [leaves[p] unsignedIntegerValue];
+        NSMutableData* visited = [NSMutableData dataWithBytes:&leaf length:sizeof(NSUInteger)];
+        stamps[leaf] = p+1;
+
+        for(NSUInteger head = 0 ; head < [visited length]/sizeof(NSUInteger) ; head++)
+        {
+            NSData* references = _objectReferences[((const NSUInteger*)[visited bytes])[head]];
+            const PDFCompactWriterReference* reference = [references bytes];
+            for(NSUInteger i = 0 ; i < [references length]/sizeof(PDFCompactWriterReference) ; i++)
+            {
+                NSUInteger target = [self indexOfObjectWithNumber:reference[i].objectNumber];
+                if(target == NSNotFound || stamps[target] == p+1 || parts[target] != PDFCompactWriterPartNone)continue;
+                stamps[target] = p+1;
+                [visited appendBytes:&target length:sizeof(NSUInteger)];
+            }
+        }
+
+        const NSUInteger* visit = [visited bytes];
+        for(NSUInteger i = 0 ; i < [visited length]/sizeof(NSUInteger) ; i++)
+        {
+            if(owners[visit[i]] == NSNotFound)owners[visit[i]] = p;
+            else if(owners[visit[i]] != p && owners[visit[i]] != 0)owners[visit[i]] = PDFCompactWriterSharedOwner;
+        }
+        [reached addObject:visited];
+    }
+
+    // The catalog comes first, then the rest of the page tree and the form dictionary in the order they were reached.
+    _order = [NSMutableData dataWithCapacity:count*sizeof(NSUInteger)];
+    [_order appendBytes:&catalog length:sizeof(NSUInteger)];
+    for(NSUInteger i = 0 ; i < count ; i++)
+    {
+        if(i != catalog && parts[i] == PDFCompactWriterPartDocument)[_order appendBytes:&i length:sizeof(NSUInteger)];
+    }
+    _documentObjectCount = [_order length]/sizeof(NSUInteger);
+
+    // Each page starts with its page object.
+    NSMutableArray* pageObjects = [NSMutableArray arrayWithCapacity:pageCount];
+    for(NSUInteger p = 0 ; p < pageCount ; p++)
+    {
+        NSUInteger leaf = [leaves[p] unsignedIntegerValue];
+        [pageObjects addObject:[NSMutableData dataWithBytes:&leaf length:sizeof(NSUInteger)]];
+    }
+    NSMutableData* shared = [NSMutableData data];
+    NSMutableData* others = [NSMutableData data];
+    for(NSUInteger i = 0 ; i < count ; i++)
+    {
+        if(parts[i] != PDFCompactWriterPartNone)continue;
+        if(owners[i] == PDFCompactWriterSharedOwner)[shared appendBytes:&i length:sizeof(NSUInteger)];
+        else if(owners[i] == NSNotFound)[others appendBytes:&i length:sizeof(NSUInteger)];
+        else [pageObjects[owners[i]] appendBytes:&i length:sizeof(NSUInteger)];
+    }
+
+    // Shared object groups are identified by their position: the objects of the first page, then the shared objects.
+    NSMutableData* identifierData = [NSMutableData dataWithLength:count*sizeof(NSUInteger)];
+    NSUInteger* identifiers = [identifierData mutableBytes];
+    NSUInteger identifier = 0;
+    _pageObjectCounts = [NSMutableData dataWithLength:pageCount*sizeof(NSUInteger)];
+    for(NSUInteger p = 0 ; p < pageCount ; p++)
+    {
+        NSData* objects = pageObjects[p];
+        ((NSUInteger*)[_pageObjectCounts mutableBytes])[p] = [objects length]/sizeof(NSUInteger);
+        if(p == 0)
+        {
+            for(NSUInteger i = 0 ; i < [objects length]/sizeof(NSUInteger) ; i++)identifiers[((const NSUInteger*)[objects bytes])[i]] = identifier++;
+        }
+        [_order appendData:objects];
+    }
+    for(NSUInteger i = 0 ; i < [shared length]/sizeof(NSUInteger) ; i++)identifiers[((const NSUInteger*)[shared bytes])[i]] = identifier++;
+    _sharedObjectCount = [shared length]/sizeof(NSUInteger);
+    [_order appendData:shared];
+    [_order appendData:others];
+
+    _sharedIdentifiers = [NSMutableArray arrayWithObject:[NSData data]];
+    for(NSUInteger p = 1 ; p < pageCount ; p++)
+    {
+        NSMutableData* references = [NSMutableData data];
+        const NSUInteger* visit = [reached[p] bytes];
+        for(NSUInteger i = 0 ; i < [reached[p] length]/sizeof(NSUInteger) ; i++)
+        {
+            if(owners[visit[i]] == 0 || owners[visit[i]] == PDFCompactWriterSharedOwner)[references appendBytes:&identifiers[visit[i]] length:sizeof(NSUInteger)];
+        }
+        [_sharedIdentifiers addObject:references];
+    }
+
+    // Objects after the first page are numbered from 1, so the first-page section lists the highest numbers, starting with the linearization dictionary.
+    NSUInteger firstPageEnd = _documentObjectCount+((const NSUInteger*)[_pageObjectCounts bytes])[0];
+    const NSUInteger* order = [_order bytes];
+    NSMutableDictionary* newObjectNumbers = [NSMutableDictionary dictionaryWithCapacity:count];
+    for(NSUInteger k = 0 ; k < count ; k++)
+    {
+        NSUInteger newNumber = (k < firstPageEnd?count-firstPageEnd+2+k:k-firstPageEnd+1);
+        newObjectNumbers[_objectNumbers[order[k]]] = @(newNumber);
+    }
+    _newObjectNumbers = newObjectNumbers;
+
+    return YES;
+}
+
+
+// Until objects are renumbered for linearization, the new number of an object is its position in collection order plus one.
+
+-(NSUInteger)indexOfObjectWithNumber:(NSUInteger)objectNumber
+{
+    NSNumber* ret = _newObjectNumbers[@(objectNumber)];
+    return (ret?[ret unsignedIntegerValue]-1:NSNotFound);
+}
+
+
+-(NSData*)codeForObjectAtIndex:(NSUInteger)index
+{
+    return [self codeForObjectWithNumber:[_objectNumbers[index] unsignedIntegerValue] GenerationNumber:[_generationNumbers[index] unsignedIntegerValue]];
+}
+
+
+// The span of the value of an entry of the dictionary an object consists of, or a range with location NSNotFound.
+
+-(NSRange)rangeOfEntry:(const char*)key InCode:(NSData*)code
+{
+    if(code == nil)return NSMakeRange(NSNotFound, 0);
+    PDFLexer* lexer = [[PDFLexer alloc] initWithData:code];
+    if([lexer nextToken].type != PDFTokenTypeDictionaryOpen)return NSMakeRange(NSNotFound, 0);
+
+    size_t keyLength = strlen(key);
+    while(YES)
+    {
+        PDFToken name = [lexer nextToken];
+        if(name.type != PDFTokenTypeName)break;
+        NSRange range = [lexer skipObject];
+        if(range.location == NSNotFound)break;
+        if(name.length == keyLength+1 && memcmp(lexer.bytes+name.offset+1, key, keyLength) == 0)return range;
+    }
+
+    return NSMakeRange(NSNotFound, 0);
+}
+
+
+// The page offset hint table and the shared object hint table, as laid out by Tables F.3 to F.6 of the PDF specification. Content stream offsets are not recorded, and each shared object forms its own group.
+
+-(NSData*)hintStreamObjectWithNumber:(NSUInteger)objectNumber Lengths:(const NSUInteger*)lengths Offsets:(const NSUInteger*)offsets
+{
+    NSUInteger pageCount = [_pageObjectCounts length]/sizeof(NSUInteger);
+    const NSUInteger* objectCounts = [_pageObjectCounts bytes];
+    NSMutableData* pageLengthData = [NSMutableData dataWithLength:pageCount*sizeof(NSUInteger)];
+    NSUInteger* pageLengths = [pageLengthData mutableBytes];
+
+    NSUInteger k = _documentObjectCount;
+    NSUInteger leastObjects = NSUIntegerMax, mostObjects = 0, leastLength = NSUIntegerMax, mostLength = 0, mostShared = 0;
+    for(NSUInteger p = 0 ; p < pageCount ; p++)
+    {
+        for(NSUInteger i = 0 ; i < objectCounts[p] ; i++)pageLengths[p] += lengths[k++];
+        leastObjects = MIN(leastObjects, objectCounts[p]);
+        mostObjects = MAX(mostObjects, objectCounts[p]);
+        leastLength = MIN(leastLength, pageLengths[p]);
+        mostLength = MAX(mostLength, pageLengths[p]);
+        mostShared = MAX(mostShared, [_sharedIdentifiers[p] length]/sizeof(NSUInteger));
+    }
+
+    NSUInteger firstPageCount = objectCounts[0];
+    NSUInteger sharedStart = k;
+    NSUInteger groupCount = firstPageCount+_sharedObjectCount;
+    NSUInteger objectBits = PDFCompactWriterBitWidth(mostObjects-leastObjects);
+    NSUInteger lengthBits = PDFCompactWriterBitWidth(mostLength-leastLength);
+    NSUInteger sharedBits = PDFCompactWriterBitWidth(mostShared);
+    NSUInteger identifierBits = PDFCompactWriterBitWidth(groupCount > 0?groupCount-1:0);
+
+    NSMutableData* data = [NSMutableData data];
+    PDFCompactWriterBits bits = {0,0};
+
+    PDFCompactWriterWriteBits(data, &bits, leastObjects, 32);
+    PDFCompactWriterWriteBits(data, &bits, offsets[_documentObjectCount], 32);
+    PDFCompactWriterWriteBits(data, &bits, objectBits, 16);
+    PDFCompactWriterWriteBits(data, &bits, leastLength, 32);
+    PDFCompactWriterWriteBits(data, &bits, lengthBits, 16);
+    PDFCompactWriterWriteBits(data, &bits, 0, 32);
+    PDFCompactWriterWriteBits(data, &bits, 0, 16);
+    PDFCompactWriterWriteBits(data, &bits, leastLength, 32);
+    PDFCompactWriterWriteBits(data, &bits, lengthBits, 16);
+    PDFCompactWriterWriteBits(data, &bits, sharedBits, 16);
+    PDFCompactWriterWriteBits(data, &bits, identifierBits, 16);
+    PDFCompactWriterWriteBits(data, &bits, 0, 16);
+    PDFCompactWriterWriteBits(data, &bits, 1, 16);
+
+    // Each item is written for every page before the next item.
+    for(NSUInteger p = 0 ; p < pageCount ; p++)PDFCompactWriterWriteBits(data, &bits, objectCounts[p]-leastObjects, objectBits);
+    PDFCompactWriterFlushBits(data, &bits);
+    for(NSUInteger p = 0 ; p < pageCount ; p++)PDFCompactWriterWriteBits(data, &bits, pageLengths[p]-leastLength, lengthBits);
+    PDFCompactWriterFlushBits(data, &bits);
+    for(NSUInteger p = 0 ; p < pageCount ; p++)PDFCompactWriterWriteBits(data, &bits, [_sharedIdentifiers[p] length]/sizeof(NSUInteger), sharedBits);
+    PDFCompactWriterFlushBits(data, &bits);
+    for(NSUInteger p = 0 ; p < pageCount ; p++)
+    {
+        const NSUInteger* identifiers = [_sharedIdentifiers[p] bytes];
+        for(NSUInteger i = 0 ; i < [_sharedIdentifiers[p] length]/sizeof(NSUInteger) ; i++)PDFCompactWriterWriteBits(data, &bits, identifiers[i], identifierBits);
+    }
+    PDFCompactWriterFlushBits(data, &bits);
+    for(NSUInteger p = 0 ; p < pageCount ; p++)PDFCompactWriterWriteBits(data, &bits, pageLengths[p]-leastLength, lengthBits);
+    PDFCompactWriterFlushBits(data, &bits);
+
+    NSUInteger sharedTableOffset = [data length];
+    NSUInteger leastGroup = NSUIntegerMax, mostGroup = 0;
+    for(NSUInteger g = 0 ; g < groupCount ; g++)
+    {
+        NSUInteger length = lengths[(g < firstPageCount?_documentObjectCount+g:sharedStart+g-firstPageCount)];
+        leastGroup = MIN(leastGroup, length);
+        mostGroup = MAX(mostGroup, length);
+    }
+    NSUInteger groupBits = PDFCompactWriterBitWidth(mostGroup-leastGroup);
+
+    PDFCompactWriterWriteBits(data, &bits, (_sharedObjectCount > 0?[self newObjectNumberForObjectNumber:[_objectNumbers[((const NSUInteger*)[_order bytes])[sharedStart]] unsignedIntegerValue]]:0), 32);
+    PDFCompactWriterWriteBits(data, &bits, (_sharedObjectCount > 0?offsets[sharedStart]:0), 32);
+    PDFCompactWriterWriteBits(data, &bits, firstPageCount, 32);
+    PDFCompactWriterWriteBits(data, &bits, groupCount, 32);
+    PDFCompactWriterWriteBits(data, &bits, 0, 16);
+    PDFCompactWriterWriteBits(data, &bits, leastGroup, 32);
+    PDFCompactWriterWriteBits(data, &bits, groupBits, 16);
+
+    for(NSUInteger g = 0 ; g < groupCount ; g++)PDFCompactWriterWriteBits(data, &bits, lengths[(g < firstPageCount?_documentObjectCount+g:sharedStart+g-firstPageCount)]-leastGroup, groupBits);
+    PDFCompactWriterFlushBits(data, &bits);
+    for(NSUInteger g = 0 ; g < groupCount ; g++)PDFCompactWriterWriteBits(data, &bits, 0, 1);
+    PDFCompactWriterFlushBits(data, &bits);
+
+    NSMutableData* ret = [NSMutableData data];
+    [ret appendData:[[NSString stringWithFormat:@"%u 0 obj\n<</S %u /Length %u>>\nstream\n",(unsigned int)objectNumber,(unsigned int)sharedTableOffset,(unsigned int)[data length]] dataUsingEncoding:NSISOLatin1StringEncoding]];
+    [ret appendData:data];
+    [ret appendBytes:"\nendstream\nendobj\n" length:18];
+    return ret;
+}
+
+
+-(NSUInteger)lengthOfIndirectObjectWithNumber:(NSUInteger)objectNumber Code:(NSData*)code
+{
+    return [[NSString stringWithFormat:@"%u 0 obj\n",(unsigned int)objectNumber] length]+[code length]+8;
+}
+
+
+@end
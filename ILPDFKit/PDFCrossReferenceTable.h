@@ -0,0 +1,129 @@
+#import <Foundation/Foundation.h>
+
+@class PDFDocument;
+@class PDFDictionary;
+@class PDFMappedFile;
+
+
+typedef enum PDFCrossReferenceEntryType
+{
+    PDFCrossReferenceEntryTypeNone = 0,
+    PDFCrossReferenceEntryTypeFree,
+    PDFCrossReferenceEntryTypeInUse,
+    PDFCrossReferenceEntryTypeCompressed
+
+} PDFCrossReferenceEntryType;
+
+
+/** A single cross-reference entry.
+
+ - type: The entry type. PDFCrossReferenceEntryTypeNone means no section of the file defines the object. PDFCrossReferenceEntryTypeCompressed means the object is stored in an object stream.
+ - offset: For in use entries, the byte offset of the object definition in the file. For free entries, the next free object number. For compressed entries, the object number of the object stream containing the object.
+ - generationNumber: The generation number of the object. Always 0 for compressed entries.
+ - index: For compressed entries, the index of the object within its object stream.
+ */
+typedef struct
+{
+    PDFCrossReferenceEntryType type;
+    NSUInteger offset;
+    NSUInteger generationNumber;
+    NSUInteger index;
+}
+PDFCrossReferenceEntry;
+
+
+
+/** The PDFCrossReferenceTable class represents the merged cross-reference index of a PDFDocument.
+ Every cross-reference section and subsection of the file is parsed exactly once, starting at the last 'startxref' and following the 'Prev' entries of each trailer. Entries from newer sections shadow entries from older ones, so the table always reflects the latest revision of the document.
+ 
+ Both classic 'xref' tables and PDF 1.5 cross-reference streams are read, including the 'XRefStm' streams of hybrid files. Objects stored in object streams have entries of type PDFCrossReferenceEntryTypeCompressed.
+
+     PDFCrossReferenceTable* table = [[PDFCrossReferenceTable alloc] initWithData:document.documentData Document:document];
+     NSUInteger offset = [table offsetForObjectWithNumber:12 GenerationNumber:0];
+
+ Entries are stored in a contiguous C array indexed by object number so a lookup is constant time.
+ */
+@interface PDFCrossReferenceTable : NSObject
+
+
+/** The byte offsets of the cross-reference sections in the order they were parsed, newest first.
+ */
+@property(nonatomic,readonly) NSArray* sectionOffsets;
+
+
+/** The trailer dictionary of the newest cross-reference section.
+ @discussion If the newest section is a cross-reference stream, the trailer contains only the trailer entries of the stream dictionary ('Size', 'Root', 'Info', 'ID', 'Encrypt' and 'Prev'), so it can be written after a classic 'xref' table.
+ */
+@property(nonatomic,readonly) PDFDictionary* trailer;
+
+
+/** One greater than the highest object number in the table.
+ */
+@property(nonatomic,readonly) NSUInteger count;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Creating a PDFCrossReferenceTable
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Creates a new instance of PDFCrossReferenceTable.
+
+ @param data The file data of the PDF.
+ @param parentDocument The document the table indexes.
+ @return A new PDFCrossReferenceTable containing the entries of all sections reachable from the last 'startxref' of data.
+ */
+-(id)initWithData:(NSData*)data Document:(PDFDocument*)parentDocument;
+
+
+/** Creates a new instance of PDFCrossReferenceTable holding a single section.
+
+ @param data The file data of the PDF.
+ @param offset The offset of the section.
+ @return A new PDFCrossReferenceTable containing the entries of the section, or nil if there is no section at offset.
+ @discussion The 'Prev' entry of the section is not followed. A linearized file lists the objects of its first page in the section following its linearization dictionary, so these can be looked up before the rest of the file is indexed.
+ */
+-(id)initWithData:(NSData*)data SectionOffset:(NSUInteger)offset;
+
+
+/** Creates a new instance of PDFCrossReferenceTable from a file whose bytes may not all be present.
+
+ @param file The file of the PDF. Only the end of the file and the sections are fetched from its data source.
+ @param parentDocument The document the table indexes.
+ @return A new PDFCrossReferenceTable containing the entries of all sections reachable from the last 'startxref' of the file.
+ */
+-(id)initWithFile:(PDFMappedFile*)file Document:(PDFDocument*)parentDocument;
+
+
+/** Creates a new instance of PDFCrossReferenceTable holding a single section of a file whose bytes may not all be present.
+
+ @param file The file of the PDF. Only the section is fetched from its data source.
+ @param offset The offset of the section.
+ @return A new PDFCrossReferenceTable containing the entries of the section, or nil if there is no section at offset.
+ */
+-(id)initWithFile:(PDFMappedFile*)file SectionOffset:(NSUInteger)offset;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Looking Up Objects
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Returns the entry for an object.
+
+ @param objectNumber The object number.
+ @return The entry for objectNumber. If the table has no entry, the type of the result is PDFCrossReferenceEntryTypeNone.
+ */
+-(PDFCrossReferenceEntry)entryForObjectWithNumber:(NSUInteger)objectNumber;
+
+
+/** Returns the byte offset of an object.
+
+ @param objectNumber The object number.
+ @param generationNumber The generation number.
+ @return The offset of the object definition in the file, or NSNotFound if the object is free, missing, compressed, or has a different generation number.
+ */
+-(NSUInteger)offsetForObjectWithNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber;
+
+
+@end
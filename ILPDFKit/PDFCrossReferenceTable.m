@@ -0,0 +1,445 @@
+
+#import "PDFCrossReferenceTable.h"
+#import "PDFDictionary.h"
+#import "PDFDocument.h"
+#import "PDFLexer.h"
+#import "PDFArray.h"
+#import "PDFUtility.h"
+#import "PDFTrace.h"
+#import "PDFMappedFile.h"
+
+// Sections of a file read from a data source are fetched in windows of this many bytes, doubled until the section fits. The end of the file is searched for 'startxref' the same way.
+#define PDFCrossReferenceTableReadWindow (16*1024)
+
+// The largest number of indirect objects a PDF file may hold, as given in Appendix C of the PDF Reference. Object numbers from the file are checked against it before entries are allocated.
+#define PDFCrossReferenceTableMaximumCount 8388608
+
+// The length of an entry of a classic table, which is 20 bytes, less the two line ending bytes some writers shorten.
+#define PDFCrossReferenceTableMinimumEntryLength 18
+
+
+@interface PDFCrossReferenceTable()
+    -(id)initWithData:(NSData*)data File:(PDFMappedFile*)file SectionOffset:(NSUInteger)sectionOffset;
+    -(PDFDictionary*)parseAtOffset:(NSUInteger)offset With:(PDFDictionary*(^)(void))parse;
+    -(PDFDictionary*)parseSectionAtOffset:(NSUInteger)offset;
+    -(PDFDictionary*)parseTableSectionAtOffset:(NSUInteger)offset;
+    -(PDFDictionary*)parseStreamSectionAtOffset:(NSUInteger)offset Replacing:(NSIndexSet*)replaceableObjects;
+    -(NSDictionary*)valueRangesOfDictionaryWithRange:(NSRange)range;
+    -(PDFDictionary*)trailerFromValueRanges:(NSDictionary*)valueRanges;
+    -(NSUInteger)lastStartxrefValue;
+    -(BOOL)setEntry:(PDFCrossReferenceEntry)entry ForObjectWithNumber:(NSUInteger)objectNumber;
+@end
+
+
+@implementation PDFCrossReferenceTable
+{
+    PDFCrossReferenceEntry* _entries;
+    NSUInteger _capacity;
+    NSUInteger _maximumCount;
+    PDFLexer* _lexer;
+    NSData* _data;
+    PDFMappedFile* _file;
+}
+
+
+-(void)dealloc
+{
+    free(_entries);
+}
+
+
+-(id)initWithData:(NSData*)data Document:(PDFDocument*)parentDocument
+{
+    return [self initWithData:data File:nil SectionOffset:NSNotFound];
+}
+
+
+-(id)initWithData:(NSData*)data SectionOffset:(NSUInteger)offset
+{
+    if(offset == NSNotFound)return nil;
+    return [self initWithData:data File:nil SectionOffset:offset];
+}
+
+
+-(id)initWithFile:(PDFMappedFile*)file Document:(PDFDocument*)parentDocument
+{
+    return [self initWithData:[file data] File:file SectionOffset:NSNotFound];
+}
+
+
+-(id)initWithFile:(PDFMappedFile*)file SectionOffset:(NSUInteger)offset
+{
+    if(offset == NSNotFound)return nil;
+    return [self initWithData:[file data] File:file SectionOffset:offset];
+}
+
+
+-(PDFCrossReferenceEntry)entryForObjectWithNumber:(NSUInteger)objectNumber
+{
+    if(objectNumber < _count)return _entries[objectNumber];
+    PDFCrossReferenceEntry none = {PDFCrossReferenceEntryTypeNone,0,0,0};
+    return none;
+}
+
+
+-(NSUInteger)offsetForObjectWithNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber
+{
+    if(objectNumber >= _count)return NSNotFound;
+    PDFCrossReferenceEntry entry = _entries[objectNumber];
+    if(entry.type != PDFCrossReferenceEntryTypeInUse || entry.generationNumber != generationNumber)return NSNotFound;
+    return entry.offset;
+}
+
+
+#pragma mark - Hidden
+
+
+// Reads every section from the last 'startxref' on, or only the section at sectionOffset if it is not NSNotFound.
+
+-(id)initWithData:(NSData*)data File:(PDFMappedFile*)file SectionOffset:(NSUInteger)sectionOffset
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _data = data;
+        _file = (file.dataSource?file:nil);
+        _lexer = [[PDFLexer alloc] initWithData:data];
+
+        // Every object takes at least one byte of the file, so a file cannot list more objects than it has bytes.
+        _maximumCount = MIN([data length], (NSUInteger)PDFCrossReferenceTableMaximumCount);
+
+        if(sectionOffset != NSNotFound)
+        {
+            if(sectionOffset >= [_data length])return nil;
+            _trailer = [self parseSectionAtOffset:sectionOffset];
+            if(_trailer == nil)return nil;
+            _sectionOffsets = @[@(sectionOffset)];
+        }
+        else
+        {
+            NSMutableArray* offsets = [NSMutableArray array];
+            NSMutableSet* visited = [NSMutableSet set];
+            NSUInteger offset = [self lastStartxrefValue];
+
+            while(offset != NSNotFound && offset < [_data length] && [visited containsObject:@(offset)] == NO)
+            {
+                [visited addObject:@(offset)];
+                PDFDictionary* sectionTrailer = [self parseSectionAtOffset:offset];
+                if(sectionTrailer == nil)break;
+                [offsets addObject:@(offset)];
+                if(_trailer == nil)_trailer = sectionTrailer;
+
+                id prev = [sectionTrailer objectForKey:@"Prev"];
+                offset = ([prev isKindOfClass:[NSNumber class]]?[prev unsignedIntegerValue]:NSNotFound);
+            }
+
+            _sectionOffsets = [[NSArray alloc] initWithArray:offsets];
+        }
+
+        _lexer = nil;
+        _data = nil;
+        _file = nil;
+    }
+
+    return self;
+}
+
+
+// Runs parse with _lexer ending at a window of the file that starts at offset. While parse reads to the end of the window, its entries are discarded and it runs again on a window twice as large. Without a data source the window is the whole file.
+
+-(PDFDictionary*)parseAtOffset:(NSUInteger)offset With:(PDFDictionary*(^)(void))parse
+{
+    NSUInteger length = [_data length];
+    if(_file == nil || offset >= length)return parse();
+
+    PDFLexer* outer = _lexer;
+    NSUInteger count = _count;
+    NSData* entries = [NSData dataWithBytes:_entries length:count*sizeof(PDFCrossReferenceEntry)];
+    NSUInteger window = PDFCrossReferenceTableReadWindow;
+    PDFDictionary* ret = nil;
+
+    while(YES)
+    {
+        NSUInteger end = (length-offset > window?offset+window:length);
+        if([_file loadRange:NSMakeRange(offset, end-offset)] == NO)
+        {
+            ret = nil;
+            break;
+        }
+
+        _lexer = [[PDFLexer alloc] initWithData:_data Range:NSMakeRange(0, end)];
+        ret = parse();
+        if(_lexer.position < end || end == length)break;
+
+        // A number cut by the end of the window may have been read as an entry, so the entries are restored before the next try.
+        if(_capacity > count)memset(_entries+count, 0, (_capacity-count)*sizeof(PDFCrossReferenceEntry));
+        if(count > 0)memcpy(_entries, [entries bytes], [entries length]);
+        _count = count;
+        window *= 2;
+    }
+
+    _lexer = outer;
+    return ret;
+}
+
+
+-(NSUInteger)lastStartxrefValue
+{
+    NSUInteger length = [_data length];
+    NSUInteger window = PDFCrossReferenceTableReadWindow;
+    NSUInteger marker = NSNotFound;
+
+    while(YES)
+    {
+        NSUInteger start = (_file && length > window?length-window:0);
+        if([_file loadRange:NSMakeRange(start, length-start)] == NO && _file)return NSNotFound;
+        marker = [_lexer offsetOfKeyword:"startxref" InRange:NSMakeRange(start, length-start) Backwards:YES];
+        if(marker != NSNotFound || start == 0)break;
+        window *= 2;
+    }
+    if(marker == NSNotFound)return NSNotFound;
+
+    _lexer.position = marker+strlen("startxref");
+    PDFToken token = [_lexer nextToken];
+    if(token.type != PDFTokenTypeNumber)return NSNotFound;
+    return (NSUInteger)[_lexer integerValueOfToken:token];
+}
+
+
+// Returns NO if objectNumber is out of bounds or the entries cannot grow, in which case the section is malformed.
+
+-(BOOL)setEntry:(PDFCrossReferenceEntry)entry ForObjectWithNumber:(NSUInteger)objectNumber
+{
+    if(objectNumber >= _maximumCount)return NO;
+    if(objectNumber >= _capacity)
+    {
+        NSUInteger newCapacity = MIN(MAX(_capacity*2, objectNumber+1), _maximumCount);
+        PDFCrossReferenceEntry* entries = realloc(_entries, newCapacity*sizeof(PDFCrossReferenceEntry));
+        if(entries == NULL)return NO;
+        _entries = entries;
+        memset(_entries+_capacity, 0, (newCapacity-_capacity)*sizeof(PDFCrossReferenceEntry));
+        _capacity = newCapacity;
+    }
+
+    // Sections are parsed newest first, so an existing entry always wins.
+    if(_entries[objectNumber].type != PDFCrossReferenceEntryTypeNone)return YES;
+
+    _entries[objectNumber] = entry;
+    if(objectNumber >= _count)_count = objectNumber+1;
+    return YES;
+}
+
+
+-(PDFDictionary*)parseSectionAtOffset:(NSUInteger)offset
+{
+    return [self parseAtOffset:offset With:^PDFDictionary*
+    {
+        _lexer.position = offset;
+        PDFToken token = [_lexer peekToken];
+
+        PDFDictionary* ret = nil;
+        if([_lexer token:token IsKeyword:"xref"])ret = [self parseTableSectionAtOffset:offset];
+        else if(token.type == PDFTokenTypeNumber)ret = [self parseStreamSectionAtOffset:offset Replacing:nil];
+
+        if(ret && _lexer.position > offset)PDFTraceCount(PDFTraceCounterBytesScanned, _lexer.position-offset);
+        return ret;
+    }];
+}
+
+
+-(PDFDictionary*)parseTableSectionAtOffset:(NSUInteger)offset
+{
+    NSMutableIndexSet* freeObjects = [NSMutableIndexSet indexSet];
+    _lexer.position = offset;
+    if([_lexer token:[_lexer nextToken] IsKeyword:"xref"] == NO)return nil;
+
+    while(YES)
+    {
+        PDFToken token = [_lexer nextToken];
+        if([_lexer token:token IsKeyword:"trailer"])break;
+
+        PDFToken countToken = [_lexer nextToken];
+        if(token.type != PDFTokenTypeNumber || countToken.type != PDFTokenTypeNumber)return nil;
+
+        NSInteger first = [_lexer integerValueOfToken:token];
+        NSInteger count = [_lexer integerValueOfToken:countToken];
+        if(first < 0 || count < 0 || (NSUInteger)first >= _maximumCount || (NSUInteger)count > _maximumCount-first)return nil;
+
+        // Each entry takes its bytes of the section, so a count larger than what is left cannot be read. A window of a data source is first grown to the end of the file.
+        if((NSUInteger)count > (_lexer.end-_lexer.position)/PDFCrossReferenceTableMinimumEntryLength)
+        {
+            if(_lexer.end < [_data length])_lexer.position = _lexer.end;
+            return nil;
+        }
+        NSUInteger firstObjectNumber = first;
+        NSUInteger objectCount = count;
+
+        for(NSUInteger i = 0 ; i < objectCount ; i++)
+        {
+            PDFToken offsetToken = [_lexer nextToken];
+            PDFToken generationToken = [_lexer nextToken];
+            PDFToken typeToken = [_lexer nextToken];
+            if(offsetToken.type != PDFTokenTypeNumber || generationToken.type != PDFTokenTypeNumber)return nil;
+
+            PDFCrossReferenceEntry entry;
+            entry.offset = [_lexer integerValueOfToken:offsetToken];
+            entry.generationNumber = [_lexer integerValueOfToken:generationToken];
+            entry.index = 0;
+
+            if([_lexer token:typeToken IsKeyword:"n"])entry.type = PDFCrossReferenceEntryTypeInUse;
+            else if([_lexer token:typeToken IsKeyword:"f"])entry.type = PDFCrossReferenceEntryTypeFree;
+            else return nil;
+
+            // Only free entries this section actually stored may be replaced by its 'XRefStm'. An object a newer section defines keeps that definition.
+            NSUInteger objectNumber = firstObjectNumber+i;
+            if(entry.type == PDFCrossReferenceEntryTypeFree && [self entryForObjectWithNumber:objectNumber].type == PDFCrossReferenceEntryTypeNone)[freeObjects addIndex:objectNumber];
+            if([self setEntry:entry ForObjectWithNumber:objectNumber] == NO)return nil;
+        }
+    }
+
+    NSRange trailerRange = [_lexer skipObject];
+    if(trailerRange.location == NSNotFound)return nil;
+    
+    NSDictionary* valueRanges = [self valueRangesOfDictionaryWithRange:trailerRange];
+    
+    // In a hybrid file, objects stored in object streams are listed as free in the table and described by the stream the 'XRefStm' entry points to.
+    NSValue* streamOffsetRange = valueRanges[@"XRefStm"];
+    if(streamOffsetRange)
+    {
+        _lexer.position = [streamOffsetRange rangeValue].location;
+        PDFToken streamOffsetToken = [_lexer nextToken];
+        if(streamOffsetToken.type == PDFTokenTypeNumber)
+        {
+            NSUInteger streamOffset = [_lexer integerValueOfToken:streamOffsetToken];
+            [self parseAtOffset:streamOffset With:^PDFDictionary*{ return [self parseStreamSectionAtOffset:streamOffset Replacing:freeObjects]; }];
+        }
+    }
+
+    return [self trailerFromValueRanges:valueRanges];
+}
+
+
+-(PDFDictionary*)parseStreamSectionAtOffset:(NSUInteger)offset Replacing:(NSIndexSet*)replaceableObjects
+{
+    _lexer.position = offset;
+    PDFToken numberToken = [_lexer nextToken];
+    PDFToken generationToken = [_lexer nextToken];
+    PDFToken marker = [_lexer nextToken];
+    if(numberToken.type != PDFTokenTypeNumber || generationToken.type != PDFTokenTypeNumber || [_lexer token:marker IsKeyword:"obj"] == NO)return nil;
+    
+    NSRange dictionaryRange = [_lexer skipObject];
+    if(dictionaryRange.location == NSNotFound || [_lexer token:[_lexer nextToken] IsKeyword:"stream"] == NO)return nil;
+    
+    // The dictionary is parsed without a parent document, so an indirect 'Length' is not resolved and the data is delimited by 'endstream' instead.
+    PDFDictionary* dictionary = [[PDFDictionary alloc] initWithPDFRepresentation:[_lexer stringWithRange:dictionaryRange] Document:nil];
+    if([[dictionary objectForKey:@"Type"] isEqual:@"XRef"] == NO)return nil;
+    
+    id length = [dictionary objectForKey:@"Length"];
+    NSRange dataRange = [_lexer skipStreamDataWithLength:([length isKindOfClass:[NSNumber class]]?[length unsignedIntegerValue]:NSNotFound)];
+    
+    // Stream data cut by the end of a window is not decoded, so the section is read again from a larger window.
+    if(_lexer.position >= _lexer.end && _lexer.end < [_data length])return nil;
+    NSData* data = [PDFUtility decodedDataFromStreamData:[_lexer.data subdataWithRange:dataRange] Dictionary:dictionary];
+    if(data == nil)return nil;
+    
+    NSArray* widths = [[dictionary objectForKey:@"W"] nsa];
+    if([widths count] < 3)return nil;
+    NSUInteger w[3];
+    for(NSUInteger i = 0 ; i < 3 ; i++)
+    {
+        w[i] = [widths[i] unsignedIntegerValue];
+        if(w[i] > sizeof(NSUInteger))return nil;
+    }
+    NSUInteger entryLength = w[0]+w[1]+w[2];
+    if(entryLength == 0)return nil;
+    
+    NSArray* subsections = [[dictionary objectForKey:@"Index"] nsa];
+    if([subsections count] < 2)subsections = @[@0,[dictionary objectForKey:@"Size"]?:@0];
+    
+    const unsigned char* bytes = [data bytes];
+    NSUInteger entryCount = [data length]/entryLength;
+    NSUInteger e = 0;
+    
+    for(NSUInteger s = 0 ; s+1 < [subsections count] ; s += 2)
+    {
+        if([subsections[s] isKindOfClass:[NSNumber class]] == NO || [subsections[s+1] isKindOfClass:[NSNumber class]] == NO)return nil;
+        NSInteger first = [subsections[s] integerValue];
+        NSInteger count = [subsections[s+1] integerValue];
+        if(first < 0 || count < 0 || (NSUInteger)first >= _maximumCount || (NSUInteger)count > _maximumCount-first)return nil;
+        NSUInteger firstObjectNumber = first;
+        NSUInteger objectCount = count;
+        
+        for(NSUInteger i = 0 ; i < objectCount && e < entryCount ; i++, e++)
+        {
+            const unsigned char* field = bytes+e*entryLength;
+            NSUInteger values[3] = {0,0,0};
+            for(NSUInteger f = 0 ; f < 3 ; f++)
+            {
+                for(NSUInteger b = 0 ; b < w[f] ; b++)values[f] = (values[f] << 8)|*field++;
+            }
+            
+            // A zero width type field means every entry is in use.
+            if(w[0] == 0)values[0] = 1;
+            
+            PDFCrossReferenceEntry entry;
+            entry.offset = values[1];
+            entry.generationNumber = values[2];
+            entry.index = 0;
+            
+            if(values[0] == 0)entry.type = PDFCrossReferenceEntryTypeFree;
+            else if(values[0] == 1)entry.type = PDFCrossReferenceEntryTypeInUse;
+            else if(values[0] == 2)
+            {
+                entry.type = PDFCrossReferenceEntryTypeCompressed;
+                entry.generationNumber = 0;
+                entry.index = values[2];
+            }
+            else continue; // Unknown types are treated as null references.
+            
+            NSUInteger objectNumber = firstObjectNumber+i;
+            if([replaceableObjects containsIndex:objectNumber] && objectNumber < _count)_entries[objectNumber].type = PDFCrossReferenceEntryTypeNone;
+            if([self setEntry:entry ForObjectWithNumber:objectNumber] == NO)return nil;
+        }
+    }
+    
+    return [self trailerFromValueRanges:[self valueRangesOfDictionaryWithRange:dictionaryRange]];
+}
+
+
+-(NSDictionary*)valueRangesOfDictionaryWithRange:(NSRange)range
+{
+    NSMutableDictionary* ret = [NSMutableDictionary dictionary];
+    _lexer.position = range.location;
+    if([_lexer nextToken].type != PDFTokenTypeDictionaryOpen)return ret;
+    
+    while(_lexer.position < NSMaxRange(range))
+    {
+        PDFToken key = [_lexer nextToken];
+        if(key.type != PDFTokenTypeName)break;
+        NSRange valueRange = [_lexer skipObject];
+        if(valueRange.location == NSNotFound)break;
+        ret[[_lexer stringWithRange:NSMakeRange(key.offset+1, key.length-1)]] = [NSValue valueWithRange:valueRange];
+    }
+    
+    return ret;
+}
+
+
+-(PDFDictionary*)trailerFromValueRanges:(NSDictionary*)valueRanges
+{
+    NSMutableString* representation = [NSMutableString stringWithString:@"<<"];
+    
+    for(NSString* key in @[@"Size",@"Prev",@"Root",@"Encrypt",@"Info",@"ID"])
+    {
+        NSValue* valueRange = valueRanges[key];
+        if(valueRange)[representation appendFormat:@"/%@ %@",key,[_lexer stringWithRange:[valueRange rangeValue]]];
+    }
+    
+    [representation appendString:@">>"];
+    
+    // The trailer is parsed without a parent document so that its indirect references are not resolved while the table is still being built.
+    return [[PDFDictionary alloc] initWithPDFRepresentation:representation Document:nil];
+}
+
+
+@end
@@ -0,0 +1,27 @@
+#import <Foundation/Foundation.h>
+
+
+/** The PDFDataSource protocol is adopted by objects that serve the bytes of a PDF file by range, such as a byte-range store or an HTTP server that accepts 'Range' requests.
+ A PDFDocument created with initWithDataSource: does not need the whole file. It asks its source for the trailer, the cross-reference sections and the objects it actually reads, so a single field can be read after fetching a small part of a large file. Adjacent requests are merged, and each request is extended by a read-ahead, so the source sees few, larger reads. PDFFileDataSource is a local implementation for testing.
+
+ Sources are called synchronously, from whichever thread reads the document, and may be called from several threads at once.
+ */
+@protocol PDFDataSource <NSObject>
+
+
+/** The total length of the file, in bytes.
+
+ @return The length. It must not change while a document reads the source.
+ */
+-(NSUInteger)length;
+
+
+/** Reads bytes of the file.
+
+ @param range The range to read. It always lies within length.
+ @return The bytes of range, exactly range.length of them, or nil if they could not be read.
+ */
+-(NSData*)dataWithRange:(NSRange)range;
+
+
+@end
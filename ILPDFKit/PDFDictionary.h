@@ -11,6 +11,8 @@
         PDFDictionary* pdfDictionary = [[PDFDictionary alloc] initWithDictionary:pdfDRef];
  
  PDFDictionary provides a range of methods that mirror those of NSDictionary.
+ 
+ A PDFDictionary may be read from several threads at once, as when a form container extracts its fields in parallel. Values resolved by objectForKey: are cached under a lock, and every caller of a key receives the same object. Setting parent is not synchronized.
  */
 
 @class PDFArray;
@@ -19,7 +21,7 @@
 
 
 /** The NSDictionary backing store.
- @discussion PDFDictionary maps the CGPDFDictionary dict onto the NSDictionary nsd. Thus nsd contains all the information of its owning PDFDictionary except for its parent.
+ @discussion PDFDictionary maps the CGPDFDictionary dict onto the NSDictionary nsd. Thus nsd contains all the information of its owning PDFDictionary except for its parent. Accessing nsd wraps or parses every value of the dictionary, so it is only built when the whole dictionary is needed, such as for enumeration, allValues or comparison.
  */
 
 @property(weak, nonatomic,readonly) NSDictionary* nsd;
@@ -48,6 +50,17 @@
 
 -(id)initWithDictionary:(CGPDFDictionaryRef)pdict;
 
+
+/** Creates a new instance of PDFDictionary whose entries are already parsed.
+ 
+ @param entries The keys and values of the dictionary.
+ @param range The range of data spanned by the dictionary, including its delimiters.
+ @param data The ISO Latin 1 encoded PDF code containing the dictionary.
+ @param parentDocument The parent document containing the dictionary.
+ @return A new PDFDictionary object. PDFObjectParser uses this initializer so that nested dictionaries are never parsed a second time.
+ */
+-(id)initWithEntries:(NSDictionary*)entries PDFRepresentationRange:(NSRange)range OfData:(NSData*)data Document:(PDFDocument*)parentDocument;
+
 /**---------------------------------------------------------------------------------------
  * @name Getting Object Type
  *  ---------------------------------------------------------------------------------------
@@ -87,6 +100,7 @@
  
  @param aKey The key for which to return the corresponding value
  @return The value associated with aKey, or nil if no value is associated with aKey.
+ @discussion Only the value for aKey is wrapped or parsed, and it is cached, so other entries are not touched until they are asked for.
  */
 -(id)objectForKey:(NSString*)aKey;
 
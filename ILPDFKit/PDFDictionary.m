@@ -6,6 +6,9 @@
 #import "PDFUtility.h"
 #import "PDFDocument.h"
 #import "PDFObjectParser.h"
+#import "PDFLexer.h"
+#import "PDFNameTable.h"
+#import "PDFTrace.h"
 
 
 
@@ -21,6 +24,9 @@
     -(NSNumber*)booleanFromKey:(NSString*)key;
     -(PDFStream*)streamFromKey:(NSString*)key;
     -(id)pdfObjectFromKey:(NSString*)key;
+    -(id)parsedObjectForKey:(NSString*)key;
+    -(NSArray*)keys;
+    -(NSData*)representationData;
    
 @end
 
@@ -28,12 +34,16 @@
 @implementation PDFDictionary
 {
     NSDictionary* _nsd;
+    NSMutableDictionary* _resolvedValues;
+    NSData* _representationData;
 }
 
 void checkKeys(const char *key,CGPDFObjectRef value,void *info)
 {
-    NSString* add = [[NSString alloc] initWithUTF8String:key];
-        [(__bridge NSMutableArray*)info addObject:add];
+    // A null value is equivalent to the key being absent.
+    if(CGPDFObjectGetType(value) == kCGPDFObjectTypeNull)return;
+    NSString* add = [[PDFNameTable tableForDocument:nil] atomForCString:key];
+    if(add)[(__bridge NSMutableArray*)info addObject:add];
 }
 
 
@@ -49,6 +59,22 @@ void checkKeys(const char *key,CGPDFObjectRef value,void *info)
 }
 
 
+-(id)initWithEntries:(NSDictionary*)entries PDFRepresentationRange:(NSRange)range OfData:(NSData*)data Document:(PDFDocument*)parentDocument
+{
+    self = [super initWithPDFRepresentationRange:range OfData:data Document:parentDocument];
+    if(self != nil)
+    {
+        _nsd = entries;
+        for(id value in [entries allValues])
+        {
+            if([value isKindOfClass:[PDFDictionary class]])[value setParent:self];
+        }
+    }
+    
+    return self;
+}
+
+
 -(CGPDFObjectType)typeForKey:(NSString*)aKey
 {
     CGPDFObjectRef obj = NULL;
@@ -60,15 +86,49 @@ void checkKeys(const char *key,CGPDFObjectRef value,void *info)
     return kCGPDFObjectTypeName;
 }
 
+// Only the value asked for is wrapped or parsed. It is cached, with NSNull standing for a missing key, until the whole dictionary is materialized. The cache is locked, but values are resolved outside the lock.
+
 -(id)objectForKey:(NSString*)aKey
 {
-    return (self.nsd)[aKey];
+    if(aKey == nil)return nil;
+    
+    id ret = nil;
+    @synchronized(self)
+    {
+        if(_nsd != nil)return _nsd[aKey];
+        ret = _resolvedValues[aKey];
+    }
+    PDFTraceCount((ret?PDFTraceCounterDictionaryHits:PDFTraceCounterDictionaryMisses), 1);
+    if(ret == nil)
+    {
+        id resolved = (_dict != NULL?[self pdfObjectFromKey:aKey]:[self parsedObjectForKey:aKey]);
+        
+        // If another thread resolved the key meanwhile, its value is kept, so every caller sees the same object.
+        @synchronized(self)
+        {
+            if(_nsd != nil)return _nsd[aKey];
+            ret = _resolvedValues[aKey];
+            if(ret == nil)
+            {
+                ret = (resolved?resolved:[NSNull null]);
+                if([ret isKindOfClass:[PDFDictionary class]])[ret setParent:self];
+                if(_resolvedValues == nil)_resolvedValues = [[NSMutableDictionary alloc] init];
+                _resolvedValues[aKey] = ret;
+            }
+        }
+    }
+    
+    return ([ret isKindOfClass:[NSNull class]]?nil:ret);
 }
 
 
 -(NSArray*)allKeys
 {
-    return [self.nsd allKeys];
+    @synchronized(self)
+    {
+        if(_nsd != nil)return [_nsd allKeys];
+    }
+    return [self keys];
 }
 
 -(NSArray*)allValues
@@ -90,7 +150,7 @@ void checkKeys(const char *key,CGPDFObjectRef value,void *info)
 
 -(NSUInteger)count
 {
-    return [self.nsd count];
+    return [[self allKeys] count];
 }
 
 #pragma mark - Getter
@@ -100,76 +160,140 @@ void checkKeys(const char *key,CGPDFObjectRef value,void *info)
 {
     if(_parent == nil)
     {
-        _parent = (self.nsd)[@"Parent"];
+        _parent = [self objectForKey:@"Parent"];
     }
     return _parent;
 }
 
+// Materializes every entry, reusing any value already resolved by objectForKey. The lock is held throughout, so the entries are materialized once.
+
 -(NSDictionary*)nsd
 {
-    if(_nsd == nil)
+    @synchronized(self)
     {
-        @autoreleasepool {
-            NSMutableArray* keys = [NSMutableArray array];
-            NSMutableDictionary* nsdFiller = nil;
+        if(_nsd == nil)
+        {
+            PDFTraceBegin(span);
+            @autoreleasepool {
+                NSMutableDictionary* temp = [NSMutableDictionary dictionary];
             
-            if(_dict!=NULL)
-            {
-                CGPDFDictionaryApplyFunction(_dict, checkKeys, (__bridge void *)(keys));
-            }
-            else
-            {
-                nsdFiller = [NSMutableDictionary dictionary];
-                NSMutableArray* keysAndValues = [NSMutableArray array];
-                
-                PDFObjectParser* parser = [PDFObjectParser parserWithString:[self pdfFileRepresentation] Document:self.parentDocument];
-                
-                for(id pdfObject in parser)[keysAndValues addObject:pdfObject];
-                
-                if([keysAndValues count]&1)return nil;
-                
-                for(NSUInteger c = 0 ; c < [keysAndValues count]/2; c++)
+                if(_dict == NULL)
                 {
-                    NSString* key = keysAndValues[2*c];
-                    [keys addObject:key];
-                    nsdFiller[key] = keysAndValues[2*c+1];
+                    // Parsing the representation once is cheaper than looking up each key in it.
+                    NSMutableArray* keysAndValues = [NSMutableArray array];
+                    PDFObjectParser* parser = [PDFObjectParser parserWithString:[self pdfFileRepresentation] Document:self.parentDocument];
+                    for(id pdfObject in parser)[keysAndValues addObject:pdfObject];
+                    if([keysAndValues count]&1)
+                    {
+                        PDFTraceEnd(span, @"PDFDictionary.nsd");
+                        return nil;
+                    }
+                
+                    for(NSUInteger c = 0 ; c < [keysAndValues count]/2; c++)
+                    {
+                        // Values already handed out are kept, so callers holding them see the same objects.
+                        id set = _resolvedValues[keysAndValues[2*c]];
+                        if(set == nil || [set isKindOfClass:[NSNull class]])set = keysAndValues[2*c+1];
+                        if([set isKindOfClass:[PDFDictionary class]])[set setParent:self];
+                        temp[keysAndValues[2*c]] = set;
+                    }
                 }
-            }
-
-            NSMutableDictionary* temp = [NSMutableDictionary dictionary];
-            
-            for(NSString* key in keys)
-            {
-                @autoreleasepool {
-                    id set = (_dict!=NULL?[self pdfObjectFromKey:key]:nsdFiller[key]);
-
-                    if(set != nil) 
+                else
+                {
+                    for(NSString* key in [self keys])
                     {
-                        
-                        if([set isKindOfClass:[PDFDictionary class]])
-                        {
-                            [set setParent:self];
+                        @autoreleasepool {
+                            id set = [self objectForKey:key];
+                            if(set != nil)temp[key] = set;
                         }
-                        
-                        
-                        temp[key] = set;
                     }
-                
                 }
-               
-            }
     
-            _nsd = [NSDictionary  dictionaryWithDictionary:temp];
-        
+                _nsd = [NSDictionary  dictionaryWithDictionary:temp];
+                _resolvedValues = nil;
+                _representationData = nil;
+            }
+            PDFTraceEnd(span, @"PDFDictionary.nsd");
         }
+        return _nsd;
     }
-    return _nsd;
 }
 
 
 #pragma mark - Hidden
 
 
+-(NSArray*)keys
+{
+    NSMutableArray* ret = [NSMutableArray array];
+    
+    if(_dict != NULL)
+    {
+        CGPDFDictionaryApplyFunction(_dict, checkKeys, (__bridge void *)(ret));
+        return ret;
+    }
+    
+    PDFLexer* lexer = [[PDFLexer alloc] initWithData:[self representationData]];
+    if([lexer nextToken].type != PDFTokenTypeDictionaryOpen)return ret;
+    PDFNameTable* names = [PDFNameTable tableForDocument:self.parentDocument];
+    
+    while(YES)
+    {
+        PDFToken key = [lexer nextToken];
+        if(key.type != PDFTokenTypeName)break;
+        
+        NSRange range = [lexer skipObject];
+        if(range.location == NSNotFound)break;
+        if(range.length == 4 && memcmp(lexer.bytes+range.location, "null", 4) == 0)continue;
+        
+        NSString* name = [names atomForBytes:(const char*)lexer.bytes+key.offset+1 Length:key.length-1];
+        if([ret containsObject:name] == NO)[ret addObject:name];
+    }
+    
+    return ret;
+}
+
+
+// The representation is kept as bytes for the lexer until the dictionary is materialized.
+
+-(NSData*)representationData
+{
+    @synchronized(self)
+    {
+        if(_representationData == nil)_representationData = [PDFUtility dataWithObjectCode:[self pdfFileRepresentation]];
+        return _representationData;
+    }
+}
+
+
+// Values are skipped without being parsed until the key is found. As with the full parse, the last occurence of a repeated key wins.
+
+-(id)parsedObjectForKey:(NSString*)key
+{
+    PDFLexer* lexer = [[PDFLexer alloc] initWithData:[self representationData]];
+    if([lexer nextToken].type != PDFTokenTypeDictionaryOpen)return nil;
+    
+    NSData* keyData = [key dataUsingEncoding:NSISOLatin1StringEncoding allowLossyConversion:YES];
+    NSRange valueRange = NSMakeRange(NSNotFound, 0);
+    
+    while(YES)
+    {
+        PDFToken token = [lexer nextToken];
+        if(token.type != PDFTokenTypeName)break;
+        NSRange range = [lexer skipObject];
+        if(range.location == NSNotFound)break;
+        
+        if(token.length-1 == [keyData length] && memcmp(lexer.bytes+token.offset+1, [keyData bytes], [keyData length]) == 0)valueRange = range;
+    }
+    
+    if(valueRange.location == NSNotFound)return nil;
+    
+    // nsd may release the representation data meanwhile, so the value is parsed from the bytes it was found in.
+    return [[[PDFObjectParser alloc] initWithData:lexer.data Range:valueRange Document:self.parentDocument] parseObject];
+}
+
+
+
 
 
 
@@ -236,7 +360,7 @@ void checkKeys(const char *key,CGPDFObjectRef value,void *info)
     const char* targ = NULL;
     if(CGPDFDictionaryGetName(_dict, [key UTF8String], &targ))
     {
-        return @(targ);
+        return [[PDFNameTable tableForDocument:nil] atomForCString:targ];
     }
     
     return nil;
@@ -8,11 +8,17 @@
 
 @class PDFDictionary;
 @class PDFFormContainer;
+@class PDFTemplate;
+@class PDFObjectCache;
+@class PDFLinearization;
+@class PDFNameTable;
+@protocol PDFDataSource;
 
 @interface PDFDocument : NSObject
 
 
 /** The PDF file data.
+ @discussion The document reads its file through a read-only mapping, and saveFormsToDocumentData appends to a separate log, so the file is not copied into memory until this property is first read. From then on the document works on the returned copy.
  */
 @property(nonatomic,strong) NSMutableData* documentData;
 
@@ -36,6 +42,11 @@
  */
 @property(weak, nonatomic,readonly) PDFDictionary* info;
 
+/** The trailer dictionary of the latest revision of the file.
+ @discussion Unlike catalog and info, the trailer is parsed from the file itself, so its indirect references, such as 'Root', are PDFObject instances that carry their object and generation numbers.
+ */
+@property(nonatomic,readonly) PDFDictionary* trailer;
+
 /** An array containing PDFPage objects cooresponding in order and content to the pages of the document.
  */
 @property(weak, nonatomic,readonly) NSArray* pages;
@@ -49,6 +60,21 @@
  */
 @property(nonatomic,readonly) CGPDFDocumentRef document;
 
+/** The cache of the object codes read by codeForObjectWithNumber:GenerationNumber:.
+ @discussion Its budget defaults to 8 MB. The catalog, the form dictionary and up to 256 nodes of the page tree are pinned when it is first used. A document read from a data source pins only the root of its page tree, so that its first lookup does not fetch the whole tree. It is emptied, pins included, whenever the data of the document changes.
+ */
+@property(nonatomic,readonly) PDFObjectCache* objectCache;
+
+/** The linearization dictionary and hint tables of the file, or nil if the file is not linearized.
+ @discussion Until the whole file is indexed, objects listed by the first-page cross-reference section of a linearized file are read through that section alone, so the first page and its widgets are available before the rest of the file is parsed. A linearized file stops being linearized once saveFormsToDocumentData appends to it.
+ */
+@property(nonatomic,readonly) PDFLinearization* linearization;
+
+/** The table interning the names read from the file of the document.
+ @discussion Each distinct name of the document is stored once, so equal names are the same object. The table lives as long as the document and is kept when the data of the document changes.
+ */
+@property(nonatomic,readonly) PDFNameTable* nameTable;
+
 
 /**---------------------------------------------------------------------------------------
  * @name Creating a PDFDocument
@@ -77,6 +103,24 @@
  */
 -(id)initWithPath:(NSString*)path;
 
+/** Creates a new instance of PDFDocument that fetches the bytes of its file from a source as they are read.
+ 
+ @param source The source of the file, such as a byte-range store.
+ @return A new instance of PDFDocument reading source, or nil if memory could not be reserved for the file.
+ @discussion Only the bytes the document reads are fetched: the end of the file and its cross-reference sections, then each object as it is resolved, and the first page and hint stream of a linearized file. Reading a single field of a large file therefore fetches a small part of it. Nearby reads are merged into one request and each request reads ahead, so the source sees few, larger reads.
+ 
+ Saving, writing the file, documentData and templates need every byte, and fetch the rest of the file first. Reads block while bytes are fetched, so a slow source should be read off the main thread.
+ */
+-(id)initWithDataSource:(id<PDFDataSource>)source;
+
+/** Creates a new instance of PDFDocument from a parsed template.
+ 
+ @param parsedTemplate The template.
+ @return A new instance of PDFDocument with the content of the template.
+ @discussion The document shares the bytes, cross-reference index and decoded object streams of the template and copies its forms on first use, so nothing is parsed. The shared bytes are copied only if documentData is used, or if saveFormsToDocumentData is called on a template that was not loaded from a file. saveFormsToPath writes the template bytes followed by the update without copying them into memory. PDFTemplate newDocument is equivalent.
+ */
+-(id)initWithTemplate:(PDFTemplate*)parsedTemplate;
+
 
 /**---------------------------------------------------------------------------------------
  * @name Finding Document Structure
@@ -89,6 +133,20 @@
 -(NSUInteger)numberOfPages;
 
 
+/** Returns the page dictionary of the first page, read from the file.
+ @return The page dictionary, or nil if it cannot be found.
+ @discussion If the document is linearized, the first page is named by its linearization dictionary and listed by its first-page cross-reference section, so it is read without indexing the rest of the file or building pages. Otherwise the page tree is walked down its first kids.
+ */
+-(PDFDictionary*)firstPageDictionary;
+
+
+/** Returns the widget annotations of the first page, read from the file.
+ @return An array of PDFDictionary, one for each widget annotation in the 'Annots' array of the first page.
+ @discussion Like firstPageDictionary, a linearized document reads these from the start of the file only.
+ */
+-(NSArray*)widgetAnnotationsOfFirstPage;
+
+
 
 /**---------------------------------------------------------------------------------------
  * @name Saving and Refreshing
@@ -96,15 +154,41 @@
  */
 
 
-/** Saves any changes in the PDF forms to its data. Must be an uncompressed PDF not counting images/fonts etc.
+/** Saves any changes in the PDF forms to its data.
  Call writeToFile to subsequently save the updated PDF to disk.
  @return YES if successful, NO is failed.
+ @discussion All modified field objects are appended as a single incremental update, with one cross-reference section and one trailer, however many forms changed. Each field object is located through the object number recorded by its PDFForm and rewritten from the cross-reference index, so fields stored in object streams can be saved too. A modified field whose object could not be found in the file is logged and skipped, and stays modified. If a field object that was found cannot be read, nothing is written. The update is kept in a log after the read-only mapped file, so saving never copies the file into memory.
  */
 -(BOOL)saveFormsToDocumentData;
 
 
+/** Saves any changes in the PDF forms directly to a file.
+ @param path The destination path. It may be documentPath itself.
+ @return YES if successful, NO is failed.
+ @discussion The changes are written as the same incremental update as saveFormsToDocumentData, but the document is never copied into memory. If the document was loaded from a file and its data has not been changed in memory, the unchanged bytes are copied from that file by the kernel. The new file is written next to path, flushed to disk and renamed over path, so path is never left partially written. On success, documentPath becomes path.
+ */
+-(BOOL)saveFormsToPath:(NSString*)path;
+
+
+/** Saves the document, including any changes in the PDF forms, as a compacted file.
+ @param path The destination path. It may be documentPath itself.
+ @param useObjectStreams If YES, objects are packed into compressed object streams, which makes the file smaller but requires PDF 1.5.
+ @return YES if successful, NO is failed.
+ @discussion Unlike saveFormsToPath, the file is rewritten in full. Superseded revisions, unreachable objects and old cross-reference sections are dropped, the remaining objects are renumbered densely, and the file ends with a single cross-reference section. Use it occasionally on documents that have been saved many times. Encrypted documents cannot be compacted. On success, documentPath becomes path and the object numbers of the forms refer to the new file.
+ */
+-(BOOL)saveCompactedToPath:(NSString*)path UsingObjectStreams:(BOOL)useObjectStreams;
+
+
+/** Saves the document, including any changes in the PDF forms, as a compacted and linearized file.
+ @param path The destination path. It may be documentPath itself.
+ @return YES if successful, NO is failed.
+ @discussion The file is written like saveCompactedToPath:UsingObjectStreams: without object streams, but laid out for fast web view: the first page and its widgets come first, followed by each other page in order, with hint tables locating every page. Viewers that read linearized files can show the first page before the rest of the file has arrived. Saving form changes to the file afterwards appends an update, which ends the linearization. The document must have at least one page.
+ */
+-(BOOL)saveLinearizedToPath:(NSString*)path;
+
+
 
-/** Reloads everything based on documentData.
+/** Reloads everything based on the document data, including any updates saved with saveFormsToDocumentData.
  */
 -(void)refresh;
 
@@ -126,8 +210,8 @@
  Looks up an object in the cross-reference table
  @param objectNumber The object number of the object to find
  @param generationNumber The generation number of the object to find
- @return The file represention of the object including the the obj and endobj bounding lines.
- @discussion Not currently implemented.
+ @return The file represention of the object between the obj and endobj bounding keywords, or nil if the object is free, missing or has a different generation number.
+ @discussion The cross-reference sections of the document are indexed once, on first use, so each lookup only reads the bytes of the object itself. Objects stored in object streams are read from the decoded stream, and each object stream is decoded only once. Codes are kept in objectCache, so an object referenced from many places is read once.
  */
 
 
@@ -8,30 +8,82 @@
 #import "PDFUtility.h"
 #import "PDFFormButtonField.h"
 #import "PDFFormContainer.h"
+#import "PDFCrossReferenceTable.h"
+#import "PDFLexer.h"
+#import "PDFObjectStream.h"
+#import "PDFFileWriter.h"
+#import "PDFCompactWriter.h"
+#import "PDFTemplate.h"
+#import "PDFTrace.h"
+#import "PDFObjectCache.h"
+#import "PDFMappedFile.h"
+#import "PDFLinearization.h"
+#import "PDFNameTable.h"
 #import "PDF.h"
 #import <QuartzCore/QuartzCore.h>
-#define isWS(c) ((c) == 0 || (c) == 9 || (c) == 10 || (c) == 12 || (c) == 13 || (c) == 32)
+
+// Resolved objects are cached up to this many bytes, unless the budget of objectCache is changed.
+#define PDFDocumentObjectCacheBudget (8*1024*1024)
+
+// At most this many nodes of the page tree are pinned in the object cache, nearest the root first.
+#define PDFDocumentMaximumPinnedPageNodes 256
+
+// Objects of a document read from a data source are fetched in windows of this many bytes, doubled until the object fits.
+#define PDFDocumentReadWindow (16*1024)
 
 @interface PDFDocument()
-    -(NSString*)formIndirectObjectFrom:(NSString*)str WithName:(NSString*)name NewValue:(NSString*)value ObjectNumber:(NSUInteger*)objectNumber GenerationNumber:(NSUInteger*)generationNumber Type:(PDFFormType)type BehindIndex:(NSInteger)index;
-    -(NSString*)constructTrailer:(NSString*)file FinalOffset:(NSUInteger)fo;
-    -(NSMutableString*)sourceCode;
-    -(PDFDictionary*)getTrailerBeforeOffset:(NSUInteger)offset;
-    -(NSUInteger)offsetForObjectWithNumber:(NSUInteger)number InSection:(NSUInteger)section;
-    -(NSString*)codeForIndirectObjectWithOffset:(NSUInteger)offset;
+    -(NSData*)formUpdateForData:(NSData*)data SavedForms:(NSMutableArray*)savedForms;
+    -(NSDictionary*)modifiedFieldCodesWithGenerationNumbers:(NSMutableDictionary*)generationNumbers SavedForms:(NSMutableArray*)savedForms;
+    -(NSString*)fieldCodeWithNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber NewValue:(NSString*)value Type:(PDFFormType)type;
+    -(NSArray*)fieldCodePartsWithNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber;
+    -(NSData*)incrementalUpdateWithCodes:(NSDictionary*)objects GenerationNumbers:(NSDictionary*)generationNumbers Offset:(NSUInteger)dataLength Trailer:(NSString*)trailer;
+    -(NSString*)incrementalUpdateTrailer;
+    -(NSString*)pdfValueFromString:(NSString*)value Type:(PDFFormType)type;
+    -(NSString*)trailerFromTrailer:(NSString*)trailer Prev:(NSUInteger)prev;
+    -(NSRange)rangeOfIndirectObjectWithOffset:(NSUInteger)offset;
+    -(PDFObjectStream*)objectStreamWithNumber:(NSUInteger)objectNumber;
+    -(void)pinDocumentStructure;
+    -(NSArray*)referencesOfKidsInCode:(NSString*)code;
+    -(void)invalidateParsedFile;
+    -(BOOL)saveRewrittenToPath:(NSString*)path UsingObjectStreams:(BOOL)useObjectStreams Linearized:(BOOL)linearized;
+    -(PDFCrossReferenceTable*)crossReferenceTableForObjectWithNumber:(NSUInteger)objectNumber;
+    -(id)readFileAtOffset:(NSUInteger)offset With:(id(^)(PDFLexer* lexer))read;
+    -(PDFMappedFile*)sourceFile;
+    -(NSData*)completeFileData;
+    -(void)loadSharedStructure;
     @property(weak, nonatomic,readonly) NSArray* crossReferenceSectionsOffsets;
+    @property(nonatomic,readonly) PDFCrossReferenceTable* crossReferenceTable;
+    @property(nonatomic,readonly) PDFCrossReferenceTable* firstPageCrossReferenceTable;
+    @property(nonatomic,readonly) NSData* fileData;
+
+@end
 
+/* The prototype document of a template, whose parsed state is shared.
+ */
+@interface PDFTemplate(PDFDocument)
+    -(PDFDocument*)prototype;
 @end
 
+
 @implementation PDFDocument
 {
-    NSMutableString* _sourceCode;
     NSString* _documentPath;
     PDFDictionary* _catalog;
     PDFDictionary* _info;
     PDFFormContainer* _forms;
     NSArray* _pages;
-    NSArray* _crossReferenceSectionsOffsets;
+    PDFCrossReferenceTable* _crossReferenceTable;
+    NSMutableDictionary* _objectStreams;
+    PDFDictionary* _trailer;
+    NSData* _mappedData;
+    PDFMappedFile* _mappedFile;
+    PDFTemplate* _parsedTemplate;
+    PDFObjectCache* _objectCache;
+    BOOL _structurePinned;
+    PDFLinearization* _linearization;
+    BOOL _linearizationRead;
+    PDFCrossReferenceTable* _firstPageCrossReferenceTable;
+    PDFNameTable* _nameTable;
 }
 
 
@@ -47,8 +99,21 @@
     self = [super init];
     if(self != nil)
     {
-        _document = [PDFUtility newPDFDocumentRefFromData:data];
-        _documentData = [[NSMutableData alloc] initWithData:data];
+        _mappedFile = [[PDFMappedFile alloc] initWithData:data];
+        if(_mappedFile == nil)_documentData = [[NSMutableData alloc] initWithData:data];
+        _document = [PDFUtility newPDFDocumentRefFromData:self.fileData];
+    }
+    return self;
+}
+
+-(id)initWithDataSource:(id<PDFDataSource>)source
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _mappedFile = [[PDFMappedFile alloc] initWithDataSource:source];
+        if(_mappedFile == nil)return nil;
+        _document = [PDFUtility newPDFDocumentRefFromMappedFile:_mappedFile];
     }
     return self;
 }
@@ -62,15 +127,6 @@
             name = [name substringToIndex:name.length-4];
         _document = [PDFUtility newPDFDocumentRefFromResource:name];
         _documentPath = [[NSBundle mainBundle] pathForResource:name ofType:@"pdf"];
-        
-        
-        
-        NSString* test = [self codeForObjectWithNumber:42 GenerationNumber:0];
-        
-        
-        
-        test = nil;
-
     }
     return self;
 }
@@ -90,35 +146,138 @@
 }
 
 
--(BOOL)saveFormsToDocumentData
+-(id)initWithTemplate:(PDFTemplate*)parsedTemplate
 {
-    NSMutableString* retval = [NSMutableString string];
-    NSMutableArray* names = [NSMutableArray array];
-    for(PDFForm* form in _forms)
+    self = [super init];
+    if(self != nil)
     {
-        if(form.modified == NO)continue;
-        if([names containsObject:form.name])continue;
-        [names addObject:form.name];
-        form.modified = NO;
-        NSUInteger objectNumber;
-        NSUInteger generationNumber;
-        NSString* indirectObject = [self formIndirectObjectFrom:self.sourceCode WithName:form.name NewValue:form.value ObjectNumber:&objectNumber GenerationNumber:&generationNumber Type:form.formType BehindIndex:[self.sourceCode length]];
-        NSString* objectNumberString = [NSString stringWithFormat:@"%u",(unsigned int)objectNumber];
-        NSString* generationNumberString = [NSString stringWithFormat:@"%05u",(unsigned int)generationNumber];
-        NSString* offsetString = [NSString stringWithFormat:@"%010u",(unsigned int)([self.documentData length]+1+[retval length])];
+        PDFDocument* prototype = [parsedTemplate prototype];
+        if(prototype == nil)return nil;
         
-        if(indirectObject)
+        // The prototype is fully parsed when the template is created and is only read afterwards.
+        _parsedTemplate = parsedTemplate;
+        _document = CGPDFDocumentRetain(prototype->_document);
+        _documentPath = prototype->_documentPath;
+        _mappedData = prototype.fileData;
+        _crossReferenceTable = prototype->_crossReferenceTable;
+        @synchronized(prototype)
+        {
+            _objectStreams = [[NSMutableDictionary alloc] initWithDictionary:prototype->_objectStreams];
+        }
+    }
+    return self;
+}
+
+
+-(BOOL)saveFormsToDocumentData
+{
+    PDFTraceBegin(span);
+    NSMutableArray* savedForms = [NSMutableArray array];
+    NSData* update = [self formUpdateForData:self.fileData SavedForms:savedForms];
+    if(update == nil)
+    {
+        PDFTraceEnd(span, @"PDFDocument.saveFormsToDocumentData");
+        return NO;
+    }
+    
+    // Unless documentData has been asked for, the update goes to the log after the read-only bytes, which are never copied.
+    if(_documentData != nil)[_documentData appendData:update];
+    else
+    {
+        if(_mappedFile == nil)_mappedFile = (_documentPath?[[PDFMappedFile alloc] initWithPath:_documentPath]:[[PDFMappedFile alloc] initWithData:self.fileData]);
+        if([_mappedFile appendData:update] == NO)
         {
-            [retval appendFormat:@"\r%@\rxref\r0 1\r0000000000 65535 f\r\n%@ 1\r%@ %@ n\r\n",indirectObject,objectNumberString,offsetString,generationNumberString];
-            NSUInteger finalOffset = [retval rangeOfString:@"xref" options:NSBackwardsSearch].location+[self.documentData length];
-            [retval appendString:[self constructTrailer:[self.sourceCode stringByAppendingString:retval] FinalOffset:finalOffset]];
+            PDFTraceEnd(span, @"PDFDocument.saveFormsToDocumentData");
+            return NO;
         }
-        else return NO;
+        _mappedData = nil;
+    }
+    for(PDFForm* form in savedForms)form.modified = NO;
+    [self invalidateParsedFile];
+    PDFTraceEnd(span, @"PDFDocument.saveFormsToDocumentData");
+    return YES;
+}
+
+-(BOOL)saveFormsToPath:(NSString*)path
+{
+    PDFTraceBegin(span);
+    NSData* source = [self completeFileData];
+    NSMutableArray* savedForms = [NSMutableArray array];
+    NSData* update = (source?[self formUpdateForData:source SavedForms:savedForms]:nil);
+    if(update == nil)
+    {
+        PDFTraceEnd(span, @"PDFDocument.saveFormsToPath");
+        return NO;
     }
     
+    // Unless the document has been changed in memory, the file on disk is the unchanged prefix and the kernel copies it. Updates saved to the document data follow it from the log.
+    PDFFileWriter* writer = [[PDFFileWriter alloc] initWithPath:path];
+    BOOL written = NO;
+    if(_documentData == nil && _documentPath != nil)written = ([writer appendContentsOfFile:_documentPath] && (_mappedFile == nil || [writer appendData:[_mappedFile appendedData]]));
+    else written = [writer appendData:source];
+    if(written == NO || [writer appendData:update] == NO || [writer commit] == NO)
+    {
+        [writer cancel];
+        PDFTraceEnd(span, @"PDFDocument.saveFormsToPath");
+        return NO;
+    }
     
+    for(PDFForm* form in savedForms)form.modified = NO;
+    _documentPath = [path copy];
+    _documentData = nil;
+    _mappedData = nil;
+    _mappedFile = nil;
+    [self invalidateParsedFile];
+    PDFTraceEnd(span, @"PDFDocument.saveFormsToPath");
+    return YES;
+}
+
+-(BOOL)saveCompactedToPath:(NSString*)path UsingObjectStreams:(BOOL)useObjectStreams
+{
+    return [self saveRewrittenToPath:path UsingObjectStreams:useObjectStreams Linearized:NO];
+}
+
+-(BOOL)saveLinearizedToPath:(NSString*)path
+{
+    return [self saveRewrittenToPath:path UsingObjectStreams:NO Linearized:YES];
+}
+
+// Compacted and linearized files are both written by a PDFCompactWriter, which renumbers every object.
+
+-(BOOL)saveRewrittenToPath:(NSString*)path UsingObjectStreams:(BOOL)useObjectStreams Linearized:(BOOL)linearized
+{
+    NSString* spanName = (linearized?@"PDFDocument.saveLinearizedToPath":@"PDFDocument.saveCompactedToPath");
+    PDFTraceBegin(span);
+    NSMutableArray* savedForms = [NSMutableArray array];
+    NSDictionary* replacementCodes = [self modifiedFieldCodesWithGenerationNumbers:[NSMutableDictionary dictionary] SavedForms:savedForms];
+    PDFCompactWriter* writer = nil;
+    if(replacementCodes != nil)
+    {
+        writer = [[PDFCompactWriter alloc] initWithDocument:self];
+        writer.replacementCodes = replacementCodes;
+        writer.usesObjectStreams = useObjectStreams;
+        writer.linearized = linearized;
+    }
+    if(writer == nil || [writer writeToPath:path] == NO)
+    {
+        PDFTraceEnd(span, spanName);
+        return NO;
+    }
+    
+    for(PDFForm* form in savedForms)form.modified = NO;
+    for(PDFForm* form in _forms)
+    {
+        if(form.objectNumber == NSNotFound)continue;
+        form.objectNumber = [writer newObjectNumberForObjectNumber:form.objectNumber];
+        form.generationNumber = 0;
+    }
     
-    [self.documentData appendData:[retval dataUsingEncoding:NSASCIIStringEncoding]];
+    _documentPath = [path copy];
+    _documentData = nil;
+    _mappedData = nil;
+    _mappedFile = nil;
+    [self invalidateParsedFile];
+    PDFTraceEnd(span, spanName);
     return YES;
 }
 
@@ -126,7 +285,7 @@
 {
     NSString *docsDirectory = NSSearchPathForDirectoriesInDomains(NSDocumentDirectory,NSUserDomainMask,YES)[0];
     NSString *path = [docsDirectory stringByAppendingPathComponent:name];
-    [self.documentData writeToFile:path atomically:YES];
+    [[self completeFileData] writeToFile:path atomically:YES];
 }
 
 
@@ -135,9 +294,10 @@
     _catalog = nil;
     _pages = nil;
     _info = nil;
-    _sourceCode = nil;
+    [self invalidateParsedFile];
     CGPDFDocumentRelease(_document);_document = NULL;
-    _document = [PDFUtility newPDFDocumentRefFromData:self.documentData];
+    PDFMappedFile* file = [self sourceFile];
+    _document = (file?[PDFUtility newPDFDocumentRefFromMappedFile:file]:[PDFUtility newPDFDocumentRefFromData:self.fileData]);
 }
 
 
@@ -148,31 +308,41 @@
 {
     if(_forms == nil)
     {
-        _forms = [[PDFFormContainer alloc] initWithParentDocument:self];
+        if(_parsedTemplate)_forms = [[PDFFormContainer alloc] initWithParentDocument:self Forms:[_parsedTemplate prototype].forms];
+        else _forms = [[PDFFormContainer alloc] initWithParentDocument:self];
     }
     
     return _forms;
 }
 
 
--(NSMutableString*)sourceCode
+-(NSMutableData*)documentData
 {
-    if(_sourceCode == nil)
+    if(_documentData == nil)
     {
-        _sourceCode = [[NSMutableString alloc] initWithData:self.documentData encoding:NSASCIIStringEncoding];
+        // Callers may change these bytes, so the mapped or shared bytes and any logged updates are copied here, the first time they are asked for.
+        NSData* data = [self completeFileData];
+        if(data == nil)return nil;
+        _documentData = [[NSMutableData alloc] initWithData:data];
+        _mappedData = nil;
+        _mappedFile = nil;
     }
     
-    return _sourceCode;
+    return _documentData;
 }
 
--(NSMutableData*)documentData
+-(NSData*)fileData
 {
-    if(_documentData == nil)
+    // Reading never needs a mutable copy, so the document is read through its mapped file and update log until documentData is asked for.
+    if(_documentData != nil)return _documentData;
+    
+    if(_mappedData == nil)
     {
-        _documentData = [[NSMutableData alloc] initWithContentsOfFile:_documentPath options:NSDataReadingMappedAlways error:NULL];
+        if(_mappedFile == nil && _documentPath != nil)_mappedFile = [[PDFMappedFile alloc] initWithPath:_documentPath];
+        _mappedData = [_mappedFile data];
     }
     
-    return _documentData;
+    return _mappedData;
 }
 
 -(PDFDictionary*)catalog
@@ -195,6 +365,19 @@
     return _info;
 }
 
+-(PDFDictionary*)trailer
+{
+    if(_trailer == nil)
+    {
+        // The first-page section of a linearized file is its newest, so its trailer applies to the whole file.
+        PDFCrossReferenceTable* table = (_crossReferenceTable == nil?self.firstPageCrossReferenceTable:nil);
+        if(table == nil)table = self.crossReferenceTable;
+        _trailer = [[PDFDictionary alloc] initWithPDFRepresentation:[table.trailer pdfFileRepresentation] Document:self];
+    }
+    
+    return _trailer;
+}
+
 -(NSArray*)pages
 {
     if(_pages == nil)
@@ -213,36 +396,78 @@
     return _pages;
 }
 
--(NSArray*)crossReferenceSectionsOffsets
+-(PDFCrossReferenceTable*)crossReferenceTable
 {
+    if(_crossReferenceTable == nil)
+    {
+        PDFTraceBegin(span);
+        PDFMappedFile* file = [self sourceFile];
+        _crossReferenceTable = (file?[[PDFCrossReferenceTable alloc] initWithFile:file Document:self]:[[PDFCrossReferenceTable alloc] initWithData:self.fileData Document:self]);
+        PDFTraceEnd(span, @"PDFDocument.crossReferenceTable");
+    }
     
-    if(_crossReferenceSectionsOffsets == nil)
+    return _crossReferenceTable;
+}
+
+-(PDFLinearization*)linearization
+{
+    if(_linearizationRead == NO)
     {
-        NSMutableArray* temp = [NSMutableArray array];
-        NSMutableString* code = [self sourceCode];
-        NSUInteger bound = code.length;
-        NSUInteger markerLength = [@"startxref" length];
-        
-        
-        while(YES){
-            
-            NSUInteger startxrefOffsetEnd = [code rangeOfString:@"startxref" options:NSBackwardsSearch range:NSMakeRange(0, bound)].location;
-            
-            if(startxrefOffsetEnd == NSNotFound)
-            {
-                _crossReferenceSectionsOffsets = [[NSArray alloc] initWithArray:temp];
-                break;
-            }
-            
-            NSScanner* scanner = [NSScanner scannerWithString:[code substringFromIndex:startxrefOffsetEnd+markerLength]];
-            NSInteger crossReferenceTableOffset;
-            [scanner scanInteger:&crossReferenceTableOffset];
-            [temp addObject:@(crossReferenceTableOffset)];
-            bound = startxrefOffsetEnd;
+        // From a data source, the dictionary is read from the first bytes. The first page and the hint stream are then fetched together, and read with the dictionary again.
+        PDFMappedFile* file = [self sourceFile];
+        if(file && [file loadRange:NSMakeRange(0, PDFDocumentReadWindow)])
+        {
+            PDFLinearization* dictionary = [[PDFLinearization alloc] initWithData:self.fileData];
+            if(dictionary)[file loadRanges:@[[NSValue valueWithRange:NSMakeRange(0, dictionary.firstPageEndOffset)],[NSValue valueWithRange:dictionary.hintStreamRange]]];
         }
+        _linearization = [[PDFLinearization alloc] initWithData:self.fileData];
+        _linearizationRead = YES;
+    }
+    
+    return _linearization;
+}
+
+-(PDFCrossReferenceTable*)firstPageCrossReferenceTable
+{
+    if(_firstPageCrossReferenceTable == nil && self.linearization != nil)
+    {
+        PDFMappedFile* file = [self sourceFile];
+        NSUInteger offset = self.linearization.firstPageCrossReferenceOffset;
+        _firstPageCrossReferenceTable = (file?[[PDFCrossReferenceTable alloc] initWithFile:file SectionOffset:offset]:[[PDFCrossReferenceTable alloc] initWithData:self.fileData SectionOffset:offset]);
+    }
+    
+    return _firstPageCrossReferenceTable;
+}
+
+-(NSArray*)crossReferenceSectionsOffsets
+{
+    return self.crossReferenceTable.sectionOffsets;
+}
+
+-(PDFNameTable*)nameTable
+{
+    @synchronized(self)
+    {
+        if(_nameTable == nil)_nameTable = [[PDFNameTable alloc] init];
+        return _nameTable;
+    }
+}
+
+-(PDFObjectCache*)objectCache
+{
+    PDFObjectCache* ret = nil;
+    BOOL pin = NO;
+    @synchronized(self)
+    {
+        if(_objectCache == nil)_objectCache = [[PDFObjectCache alloc] initWithByteBudget:PDFDocumentObjectCacheBudget];
+        pin = (_structurePinned == NO);
+        _structurePinned = YES;
+        ret = _objectCache;
     }
     
-    return _crossReferenceSectionsOffsets;
+    // Pinning resolves objects through the cache, so it happens once the cache exists.
+    if(pin)[self pinDocumentStructure];
+    return ret;
 }
 
 -(NSUInteger)numberOfPages
@@ -250,122 +475,228 @@
     return CGPDFDocumentGetNumberOfPages(_document);
 }
 
-#pragma mark - PDF File Saving
-
--(NSString*)formIndirectObjectFrom:(NSString*)str WithName:(NSString*)name  NewValue:(NSString*)value ObjectNumber:(NSUInteger*)objectNumber GenerationNumber:(NSUInteger*)generationNumber Type:(PDFFormType)type BehindIndex:(NSInteger)index
+-(PDFDictionary*)firstPageDictionary
 {
-    BOOL simple = ([[name componentsSeparatedByString:@"."] count]==1);
-    NSString* search = [NSString stringWithFormat:@"/T(%@)",[[name componentsSeparatedByString:@"."] lastObject]];
-    NSUInteger searchLocation = [str rangeOfString:search options:NSBackwardsSearch range:NSMakeRange(0, index)].location;
+    NSUInteger objectNumber = self.linearization.firstPageObjectNumber;
+    NSUInteger generationNumber = 0;
     
+    if(objectNumber == 0)
+    {
+        // The page tree is walked down its first kids, from the numbers in each 'Kids' array, so no other page is resolved.
+        PDFObject* root = [self.trailer objectForKey:@"Root"];
+        if([root isMemberOfClass:[PDFObject class]] == NO)return nil;
+        PDFDictionary* catalog = (PDFDictionary*)[PDFObject createWithPDFRepresentation:[root pdfFileRepresentation] Document:self];
+        if([catalog isKindOfClass:[PDFDictionary class]] == NO)return nil;
+        
+        PDFObject* pages = [catalog objectForKey:@"Pages"];
+        if([pages isMemberOfClass:[PDFObject class]] == NO || pages.objectNumber == 0)return nil;
+        objectNumber = pages.objectNumber;
+        generationNumber = pages.generationNumber;
+        NSMutableSet* visited = [NSMutableSet set];
+        
+        while(YES)
+        {
+            NSArray* kids = [self referencesOfKidsInCode:[self codeForObjectWithNumber:objectNumber GenerationNumber:generationNumber]];
+            if(kids == nil)break;
+            if([kids count] == 0 || [visited containsObject:@(objectNumber)])return nil;
+            [visited addObject:@(objectNumber)];
+            objectNumber = [kids[0][0] unsignedIntegerValue];
+            generationNumber = [kids[0][1] unsignedIntegerValue];
+        }
+    }
     
+    PDFObject* ret = [PDFObject createWithPDFRepresentation:[self codeForObjectWithNumber:objectNumber GenerationNumber:generationNumber] Document:self];
+    return ([ret isKindOfClass:[PDFDictionary class]]?(PDFDictionary*)ret:nil);
+}
+
+-(NSArray*)widgetAnnotationsOfFirstPage
+{
+    id annotations = [[self firstPageDictionary] objectForKey:@"Annots"];
+    if([annotations isMemberOfClass:[PDFObject class]])annotations = [PDFObject createWithPDFRepresentation:[annotations pdfFileRepresentation] Document:self];
+    if([annotations isKindOfClass:[PDFArray class]] == NO)return @[];
     
-    if(searchLocation == NSNotFound)return nil;
+    NSMutableArray* ret = [NSMutableArray array];
+    for(NSUInteger i = 0 ; i < [annotations count] ; i++)
+    {
+        id annotation = [annotations objectAtIndex:i];
+        if([annotation isMemberOfClass:[PDFObject class]])annotation = [PDFObject createWithPDFRepresentation:[annotation pdfFileRepresentation] Document:self];
+        if([annotation isKindOfClass:[PDFDictionary class]] && [[annotation objectForKey:@"Subtype"] isEqual:@"Widget"])[ret addObject:annotation];
+    }
     
+    return ret;
+}
+
+#pragma mark - PDF File Saving
+
+-(NSData*)formUpdateForData:(NSData*)data SavedForms:(NSMutableArray*)savedForms
+{
+    NSString* trailer = [self incrementalUpdateTrailer];
+    if(trailer == nil)return nil;
     
-    NSUInteger startMarkerLocation = [str rangeOfString:@"obj" options:NSBackwardsSearch range:NSMakeRange(0, searchLocation+1)].location;
-    if(startMarkerLocation == NSNotFound)return nil;
+    // Gather every modified field object first, so the update holds one definition per object and a single cross-reference section.
+    NSMutableDictionary* generationNumbers = [NSMutableDictionary dictionary];
+    NSDictionary* objects = [self modifiedFieldCodesWithGenerationNumbers:generationNumbers SavedForms:savedForms];
+    if(objects == nil)return nil;
     
-    NSUInteger startLocation = startMarkerLocation;
-    while([str characterAtIndex:startLocation]!='\n' && [str characterAtIndex:startLocation]!='\r')startLocation--;
+    return [self incrementalUpdateWithCodes:objects GenerationNumbers:generationNumbers Offset:[data length] Trailer:trailer];
+}
+
+
+// Builds an update, to be appended at dataLength, that redefines the objects whose codes are given. It only reads its arguments, so it can be called from several threads at once.
+
+-(NSData*)incrementalUpdateWithCodes:(NSDictionary*)objects GenerationNumbers:(NSDictionary*)generationNumbers Offset:(NSUInteger)dataLength Trailer:(NSString*)trailer
+{
+    if([objects count] == 0)return [NSData data];
     
-    NSString* objectLine = [str substringWithRange:NSMakeRange(startLocation+1, startMarkerLocation-startLocation)];
+    NSArray* objectNumbers = [[objects allKeys] sortedArrayUsingSelector:@selector(compare:)];
+    NSMutableData* update = [NSMutableData data];
+    NSMutableArray* offsets = [NSMutableArray arrayWithCapacity:[objectNumbers count]];
     
-    NSScanner* scanner = [NSScanner scannerWithString:objectLine];
-    [scanner scanInteger:(NSInteger*)objectNumber];
-    [scanner scanInteger:(NSInteger*)generationNumber];
-    NSString* ret =  [str substringWithRange:NSMakeRange(startLocation+1, [[str substringFromIndex:startLocation+1] rangeOfString:@"endobj"].location+[@"endobj" length])];
+    for(NSNumber* objectNumber in objectNumbers)
+    {
+        [update appendBytes:"\r" length:1];
+        [offsets addObject:@(dataLength+[update length])];
+        NSString* indirectObject = [NSString stringWithFormat:@"%u %u obj\r%@\rendobj",(unsigned int)[objectNumber unsignedIntegerValue],(unsigned int)[generationNumbers[objectNumber] unsignedIntegerValue],objects[objectNumber]];
+        [update appendData:[indirectObject dataUsingEncoding:NSISOLatin1StringEncoding allowLossyConversion:YES]];
+        [update appendBytes:"\r" length:1];
+    }
     
-    if(simple == NO)
+    NSUInteger xrefOffset = dataLength+[update length];
+    NSMutableString* xref = [NSMutableString stringWithString:@"xref\r0 1\r0000000000 65535 f\r\n"];
+    
+    // Consecutive object numbers share a subsection.
+    for(NSUInteger i = 0 ; i < [objectNumbers count] ; )
     {
-        NSString* parentName = @"/Parent";
-        NSUInteger objNumber;
-        NSUInteger genNumber;
-        NSUInteger lastDot = [name rangeOfString:@"." options:NSBackwardsSearch].location;
-        [self formIndirectObjectFrom:str WithName:[name substringToIndex:lastDot]  NewValue:(id)[NSNull null] ObjectNumber:&objNumber GenerationNumber:&genNumber Type:type BehindIndex:[str length]];
-        NSUInteger parentLoc = [ret rangeOfString:parentName].location;
-        if(parentLoc == NSNotFound)return nil;
-        NSString* scans = [ret substringFromIndex:parentLoc+[parentName length]];
-        NSScanner* mscanner = [NSScanner scannerWithString:scans];
-        NSInteger nObjNumber,nGenNumber;
-        [mscanner scanInteger:&nObjNumber];
-        [mscanner scanInteger:&nGenNumber];
+        NSUInteger first = i;
+        while(i+1 < [objectNumbers count] && [objectNumbers[i+1] unsignedIntegerValue] == [objectNumbers[i] unsignedIntegerValue]+1)i++;
+        i++;
         
-        if(nObjNumber!=objNumber || nGenNumber!=genNumber)
+        [xref appendFormat:@"%u %u\r",(unsigned int)[objectNumbers[first] unsignedIntegerValue],(unsigned int)(i-first)];
+        for(NSUInteger j = first ; j < i ; j++)
         {
-            return [self formIndirectObjectFrom:str WithName:name  NewValue:value ObjectNumber:objectNumber GenerationNumber:generationNumber Type:type  BehindIndex:searchLocation];
+            [xref appendFormat:@"%010u %05u n\r\n",(unsigned int)[offsets[j] unsignedIntegerValue],(unsigned int)[generationNumbers[objectNumbers[j]] unsignedIntegerValue]];
         }
     }
     
-    if([value isKindOfClass:[NSNull class]])return ret;
+    [xref appendFormat:@"trailer\r%@\rstartxref\r%u\r%%%%EOF",trailer,(unsigned int)xrefOffset];
+    [update appendData:[xref dataUsingEncoding:NSISOLatin1StringEncoding allowLossyConversion:YES]];
+    return update;
+}
+
+
+-(NSString*)incrementalUpdateTrailer
+{
+    NSString* trailer = [self.crossReferenceTable.trailer pdfFileRepresentation];
+    if(trailer == nil)return nil;
+    
+    NSUInteger prev = ([self.crossReferenceSectionsOffsets count]?[(self.crossReferenceSectionsOffsets)[0] unsignedIntegerValue]:0);
+    return [self trailerFromTrailer:trailer Prev:prev];
+}
+
+
+-(NSDictionary*)modifiedFieldCodesWithGenerationNumbers:(NSMutableDictionary*)generationNumbers SavedForms:(NSMutableArray*)savedForms
+{
+    NSMutableDictionary* ret = [NSMutableDictionary dictionary];
     
-    if(type != PDFFormTypeButton)
+    for(PDFForm* form in _forms)
     {
-        if([ret rangeOfString:@"/V"].location!=NSNotFound)
+        if(form.modified == NO)continue;
+        
+        // A field that could not be matched with its object in the file cannot be written, but the others still are. It stays modified, so a later save can retry.
+        if(form.objectNumber == NSNotFound)
         {
-            NSUInteger c = [ret rangeOfString:@"/V"].location;
-            NSMutableString* oldval = [NSMutableString stringWithString:@"/V"];c++;
-            NSUInteger dc = 0;
-            while(dc < 1)
-            {
-                c++;
-                unichar append = [ret characterAtIndex:c];
-                [oldval appendString:[NSString stringWithCharacters:&append length:1]];
-                
-                if([ret characterAtIndex:c] == '/')dc++;
-                if([ret characterAtIndex:c] == '>')dc++;
-            }
-            NSString* val = [oldval substringToIndex:oldval.length-1];
-            
-            if(value == nil)value = @"";
-            return [ret stringByReplacingOccurrencesOfString:val withString:[NSString stringWithFormat:@"/V(%@)",value]];
+            NSLog(@"PDFDocument: the field %@ was not found in the file and is not saved.",form.name);
+            continue;
         }
-        else 
+        
+        // The widgets of a field share the object holding its value, which is written once and saves every one of them.
+        if(ret[@(form.objectNumber)])
         {
-            if(value == nil)value = @"";
-            return [ret stringByReplacingOccurrencesOfString:search withString:[NSString stringWithFormat:@"%@/V(%@)",search,value]];
+            [savedForms addObject:form];
+            continue;
         }
+        NSString* code = [self fieldCodeWithNumber:form.objectNumber GenerationNumber:form.generationNumber NewValue:form.value Type:form.formType];
+        if(code == nil)return nil;
+        
+        ret[@(form.objectNumber)] = code;
+        generationNumbers[@(form.objectNumber)] = @(form.generationNumber);
+        [savedForms addObject:form];
     }
-    else 
+    
+    return ret;
+}
+
+
+-(NSString*)fieldCodeWithNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber NewValue:(NSString*)value Type:(PDFFormType)type
+{
+    NSArray* parts = [self fieldCodePartsWithNumber:objectNumber GenerationNumber:generationNumber];
+    if(parts == nil)return nil;
+    
+    return [NSString stringWithFormat:@"%@%@%@",parts[0],[self pdfValueFromString:value Type:type],parts[1]];
+}
+
+
+// Splits the code of a field object around its value, so the code for any value is the first part, the value and the second part.
+
+-(NSArray*)fieldCodePartsWithNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber
+{
+    NSString* code = [self codeForObjectWithNumber:objectNumber GenerationNumber:generationNumber];
+    if(code == nil)return nil;
+    
+    PDFLexer* lexer = [[PDFLexer alloc] initWithData:[PDFUtility dataWithObjectCode:code]];
+    PDFToken open = [lexer nextToken];
+    if(open.type != PDFTokenTypeDictionaryOpen)return nil;
+    
+    NSRange valueRange = NSMakeRange(NSNotFound, 0);
+    while(YES)
     {
-        if([ret rangeOfString:@"/V"].location!=NSNotFound)
-        {
-            NSUInteger c = [ret rangeOfString:@"/V"].location;
-            NSMutableString* oldval = [NSMutableString stringWithString:@"/V"];c++;
-            NSUInteger dc = 0;
-            while(dc < 2)
-            {
-                c++;
-                unichar append = [ret characterAtIndex:c];
-                [oldval appendString:[NSString stringWithCharacters:&append length:1]];
-                
-                if([ret characterAtIndex:c] == '/')dc++;
-                if([ret characterAtIndex:c] == '>')dc++;
-            }
-            NSString* val = [oldval substringToIndex:oldval.length-1];
-            if(value == nil)value = @"";
-            NSString* set = [value stringByReplacingOccurrencesOfString:@" " withString:@"#20"];
-            return [ret stringByReplacingOccurrencesOfString:val withString:[@"/V/" stringByAppendingString:set]];
-        }
-        else 
+        PDFToken key = [lexer nextToken];
+        if(key.type != PDFTokenTypeName)break;
+        NSRange range = [lexer skipObject];
+        if(range.location == NSNotFound)break;
+        if(key.length == 2 && lexer.bytes[key.offset+1] == 'V')
         {
-            if(value == nil)value = @"";
-            NSString* set = [value stringByReplacingOccurrencesOfString:@" " withString:@"#20"];
-            return [ret stringByReplacingOccurrencesOfString:search withString:[[NSString stringWithFormat:@"%@/V/",search] stringByAppendingString:set]];
+            valueRange = range;
+            break;
         }
     }
+    
+    NSString* head = nil;
+    NSString* tail = nil;
+    
+    if(valueRange.location != NSNotFound)
+    {
+        head = [code substringToIndex:valueRange.location];
+        tail = [code substringFromIndex:NSMaxRange(valueRange)];
+    }
+    else
+    {
+        head = [[code substringToIndex:open.offset+open.length] stringByAppendingString:@"/V "];
+        tail = [code substringFromIndex:open.offset+open.length];
+    }
+    
+    // Leading and trailing white space is dropped, as the code is written between the obj and endobj keywords.
+    NSCharacterSet* whiteSpace = [PDFUtility whiteSpaceCharacterSet];
+    NSRange start = [head rangeOfCharacterFromSet:[whiteSpace invertedSet]];
+    NSRange end = [tail rangeOfCharacterFromSet:[whiteSpace invertedSet] options:NSBackwardsSearch];
+    head = (start.location == NSNotFound?@"":[head substringFromIndex:start.location]);
+    tail = (end.location == NSNotFound?@"":[tail substringToIndex:NSMaxRange(end)]);
+    
+    return @[head,tail];
 }
 
--(NSString*)constructTrailer:(NSString*)file FinalOffset:(NSUInteger)fo
+
+-(NSString*)pdfValueFromString:(NSString*)value Type:(PDFFormType)type
 {
-    NSUInteger trailerloc = [file rangeOfString:@"trailer" options:NSBackwardsSearch].location;
-    NSUInteger startxrefloc = [file rangeOfString:@"startxref" options:NSBackwardsSearch].location;
-    
-    NSScanner* scanner = [NSScanner scannerWithString:[file substringFromIndex:startxrefloc+[@"startxref" length]+1]];
-    NSInteger newPrevValInt;
-    [scanner scanInteger:&newPrevValInt];
-    NSString* newPrevVal = [NSString stringWithFormat:@"%u",(unsigned int)newPrevValInt];
-    NSString* trailer = [file substringWithRange:NSMakeRange(trailerloc+[@"trailer" length]+1, startxrefloc-trailerloc-1-[@"trailer" length]-1)];
+    // Button values are names.
+    if(type == PDFFormTypeButton)return [PDFUtility pdfNameFromString:value];
+    return [PDFUtility pdfStringFromString:value];
+}
+
+
+-(NSString*)trailerFromTrailer:(NSString*)trailer Prev:(NSUInteger)prev
+{
+    NSString* newPrevVal = [NSString stringWithFormat:@"%u",(unsigned int)prev];
     NSString* newTrailer = nil;
     
     if([trailer rangeOfString:@"/Prev"].location != NSNotFound)
@@ -378,7 +709,7 @@
         newTrailer = [trailer stringByReplacingOccurrencesOfString:@"/Size" withString:[NSString stringWithFormat:@"/Prev %@/Size",newPrevVal]];
     }
    
-    return [[NSString stringWithFormat:@"trailer\r%@\rstartxref\r%u\r",newTrailer,(unsigned int)fo] stringByAppendingString:@"%%EOF"];
+    return newTrailer;
 }
 
 
@@ -391,105 +722,285 @@
 #pragma mark - Parsing 
 
 
--(NSUInteger)offsetForObjectWithNumber:(NSUInteger)number InSection:(NSUInteger)section
+-(NSRange)rangeOfIndirectObjectWithOffset:(NSUInteger)offset
 {
-    NSUInteger sectionOffset = [(self.crossReferenceSectionsOffsets)[section] unsignedIntegerValue]+[@"xref" length];
-    
-    NSString* searchStart = [self.sourceCode substringFromIndex:sectionOffset];
-    
-    
-    NSRegularExpression* regexStart = [[NSRegularExpression alloc] initWithPattern:@"[0-9]{1,9} [0-9]{1,4}" options:0 error:NULL];
-    
-     NSUInteger start = [regexStart rangeOfFirstMatchInString:searchStart options:0 range:NSMakeRange(0, searchStart.length)].location;
+    // The read is bounded by the object definition itself, from the 'obj' following the object header to the matching 'endobj'.
     
+    NSValue* ret = [self readFileAtOffset:offset With:^id(PDFLexer* lexer)
+    {
+        PDFToken numberToken = [lexer nextToken];
+        PDFToken generationToken = [lexer nextToken];
+        PDFToken marker = [lexer nextToken];
+        if(numberToken.type != PDFTokenTypeNumber || generationToken.type != PDFTokenTypeNumber || [lexer token:marker IsKeyword:"obj"] == NO)return nil;
+        
+        NSUInteger start = marker.offset+marker.length;
+        
+        while(YES)
+        {
+            PDFToken token = [lexer nextToken];
+            if(token.type == PDFTokenTypeEnd)break;
+            if([lexer token:token IsKeyword:"endobj"])
+            {
+                PDFTraceCount(PDFTraceCounterBytesScanned, token.offset+token.length-offset);
+                return [NSValue valueWithRange:NSMakeRange(start, token.offset-start)];
+            }
+            if([lexer token:token IsKeyword:"stream"])[lexer skipStreamDataWithLength:NSNotFound];
+        }
+        
+        return nil;
+    }];
     
+    return (ret?[ret rangeValue]:NSMakeRange(NSNotFound, 0));
+}
+
+
+-(PDFObjectStream*)objectStreamWithNumber:(NSUInteger)objectNumber
+{
+    // Form fields are read from several threads, so the cache is locked. Streams are decoded outside the lock.
+    PDFObjectStream* ret = nil;
+    @synchronized(self)
+    {
+        if(_objectStreams == nil)_objectStreams = [[NSMutableDictionary alloc] init];
+        ret = _objectStreams[@(objectNumber)];
+    }
+    PDFTraceCount((ret?PDFTraceCounterObjectStreamHits:PDFTraceCounterObjectStreamMisses), 1);
+    if(ret)return ret;
     
-    NSScanner* scanner = [NSScanner scannerWithString:[searchStart substringFromIndex:start]];
-    NSInteger startingObjectNumber;
-    NSInteger objectCount;
-    [scanner scanInteger:&startingObjectNumber];
-    [scanner scanInt:&objectCount];
+    NSUInteger offset = [self.crossReferenceTable offsetForObjectWithNumber:objectNumber GenerationNumber:0];
+    if(offset == NSNotFound)return nil;
     
+    __block PDFDictionary* dictionary = nil;
+    NSValue* dataRange = [self readFileAtOffset:offset With:^id(PDFLexer* lexer)
+    {
+        [lexer nextToken];
+        [lexer nextToken];
+        if([lexer token:[lexer nextToken] IsKeyword:"obj"] == NO)return nil;
+        
+        NSRange dictionaryRange = [lexer skipObject];
+        if(dictionaryRange.location == NSNotFound || [lexer token:[lexer nextToken] IsKeyword:"stream"] == NO)return nil;
+        
+        dictionary = [[PDFDictionary alloc] initWithPDFRepresentation:[lexer stringWithRange:dictionaryRange] Document:self];
+        if(PDFNameIsEqual([dictionary objectForKey:PDFNameType], PDFNameObjStm) == NO)return nil;
+        
+        return [NSValue valueWithRange:[lexer skipStreamDataWithLength:[PDFUtility lengthOfStreamWithDictionary:dictionary]]];
+    }];
+    if(dataRange == nil)return nil;
     
+    PDFTraceCount(PDFTraceCounterBytesScanned, NSMaxRange([dataRange rangeValue])-offset);
+    NSData* data = [PDFUtility decodedDataFromStreamData:[self.fileData subdataWithRange:[dataRange rangeValue]] Dictionary:dictionary];
+    if(data == nil)return nil;
     
-    while(1)
+    ret = [[PDFObjectStream alloc] initWithData:data Dictionary:dictionary];
+    if(ret)
     {
-        start++;
-        char c = [searchStart characterAtIndex:start];
-        if(c == 'n' || c == 'f')
+        // Another thread may have decoded the same stream meanwhile. The first one stored is kept, so every reader shares it.
+        @synchronized(self)
         {
-            start = start-17;
-            break;
+            if(_objectStreams[@(objectNumber)])ret = _objectStreams[@(objectNumber)];
+            else _objectStreams[@(objectNumber)] = ret;
         }
     }
+    return ret;
+}
+
+
+-(NSString*)codeForObjectWithNumber:(NSInteger)objectNumber GenerationNumber:(NSInteger)generationNumber
+{
+    if(objectNumber < 0 || generationNumber < 0)return nil;
     
-    NSString* linesStart = [searchStart substringFromIndex:start];
+    PDFObjectCache* cache = self.objectCache;
+    NSString* ret = [cache objectWithNumber:objectNumber GenerationNumber:generationNumber];
+    PDFTraceCount((ret?PDFTraceCounterCacheHits:PDFTraceCounterCacheMisses), 1);
+    if(ret)return ret;
     
+    PDFTraceBegin(span);
+    PDFCrossReferenceTable* table = [self crossReferenceTableForObjectWithNumber:objectNumber];
+    PDFCrossReferenceEntry entry = [table entryForObjectWithNumber:objectNumber];
+    if(entry.type == PDFCrossReferenceEntryTypeCompressed)
+    {
+        PDFObjectStream* objectStream = (generationNumber == 0?[self objectStreamWithNumber:entry.offset]:nil);
+        if([objectStream objectNumberAtIndex:entry.index] == (NSUInteger)objectNumber)ret = [objectStream codeForObjectAtIndex:entry.index];
+    }
+    else
+    {
+        NSUInteger offset = [table offsetForObjectWithNumber:objectNumber GenerationNumber:generationNumber];
+        NSRange range = (offset != NSNotFound?[self rangeOfIndirectObjectWithOffset:offset]:NSMakeRange(NSNotFound, 0));
+        if(range.location != NSNotFound)ret = [[NSString alloc] initWithBytes:(const char*)[self.fileData bytes]+range.location length:range.length encoding:NSISOLatin1StringEncoding];
+    }
     
-    if(number >= startingObjectNumber && number<startingObjectNumber+objectCount)
+    if(ret)
     {
-        NSArray* lines = [linesStart componentsSeparatedByCharactersInSet:[NSCharacterSet characterSetWithCharactersInString:@"nf"]];
-        
-        NSString* targ = lines[number-startingObjectNumber];
-        
-        
-        NSScanner* scanner = [NSScanner scannerWithString:targ];
-        
-        NSInteger offset = 7;
-        
-        [scanner scanInteger:&offset];
-        
-        return (NSUInteger)offset;
-        
+        PDFTraceCount(PDFTraceCounterObjectsResolved, 1);
+        [cache setObject:ret Cost:[ret length] ForNumber:objectNumber GenerationNumber:generationNumber];
     }
+    PDFTraceEnd(span, @"PDFDocument.resolveObject");
+    return ret;
+}
+
+
+// Until the whole file is indexed, objects listed by the first-page section of a linearized file are looked up there.
+
+-(PDFCrossReferenceTable*)crossReferenceTableForObjectWithNumber:(NSUInteger)objectNumber
+{
+    if(_crossReferenceTable == nil)
+    {
+        PDFCrossReferenceTable* firstPageTable = self.firstPageCrossReferenceTable;
+        if([firstPageTable entryForObjectWithNumber:objectNumber].type != PDFCrossReferenceEntryTypeNone)return firstPageTable;
+    }
+    
+    return self.crossReferenceTable;
+}
+
+
+// Form fields are read from several threads at once, which would otherwise build these structures concurrently, so they are built first, on one thread. The object streams of a data source are left to be fetched as they are read.
+
+-(void)loadSharedStructure
+{
+    [self fileData];
+    [self linearization];
+    PDFCrossReferenceTable* table = self.crossReferenceTable;
+    [self trailer];
+    [self catalog];
+    [self pages];
+    [self objectCache];
+    
+    if([self sourceFile])return;
+    NSMutableIndexSet* streamNumbers = [NSMutableIndexSet indexSet];
+    for(NSUInteger i = 0 ; i < table.count ; i++)
+    {
+        PDFCrossReferenceEntry entry = [table entryForObjectWithNumber:i];
+        if(entry.type == PDFCrossReferenceEntryTypeCompressed)[streamNumbers addIndex:entry.offset];
+    }
+    [streamNumbers enumerateIndexesUsingBlock:^(NSUInteger number, BOOL* stop) { [self objectStreamWithNumber:number]; }];
+}
+
+
+// The catalog, the form dictionary and the upper nodes of the page tree are read by almost every operation, so they are pinned.
+
+-(void)pinDocumentStructure
+{
+    PDFObject* root = [self.trailer objectForKey:@"Root"];
+    if([root isMemberOfClass:[PDFObject class]] == NO || root.objectNumber == 0)return;
+    [_objectCache pinObjectWithNumber:root.objectNumber GenerationNumber:root.generationNumber];
     
+    PDFDictionary* catalog = (PDFDictionary*)[PDFObject createWithPDFRepresentation:[root pdfFileRepresentation] Document:self];
+    if([catalog isKindOfClass:[PDFDictionary class]] == NO)return;
     
-    return NSNotFound;
+    PDFObject* acroForm = [catalog objectForKey:@"AcroForm"];
+    if([acroForm isMemberOfClass:[PDFObject class]] && acroForm.objectNumber > 0)[_objectCache pinObjectWithNumber:acroForm.objectNumber GenerationNumber:acroForm.generationNumber];
     
+    // The page tree is walked breadth first from the numbers in each 'Kids' array, so only the pinned nodes are resolved. A set of visited nodes guards against cycles.
+    PDFObject* pages = [catalog objectForKey:@"Pages"];
+    if([pages isMemberOfClass:[PDFObject class]] == NO || pages.objectNumber == 0)return;
+    NSMutableArray* nodes = [NSMutableArray arrayWithObject:@[@(pages.objectNumber),@(pages.generationNumber)]];
+    NSMutableSet* visited = [NSMutableSet set];
     
+    // Before a linearized file is indexed, only the nodes its first-page section lists are read. The others are pinned without being walked, so pinning does not index the file. A document read from a data source walks no node, so pinning fetches nothing a lookup would not.
+    PDFCrossReferenceTable* firstPageTable = (_crossReferenceTable == nil?self.firstPageCrossReferenceTable:nil);
+    BOOL walk = ([self sourceFile] == nil);
     
+    for(NSUInteger i = 0 ; i < [nodes count] && [visited count] < PDFDocumentMaximumPinnedPageNodes ; i++)
+    {
+        NSUInteger number = [nodes[i][0] unsignedIntegerValue];
+        NSUInteger generation = [nodes[i][1] unsignedIntegerValue];
+        if([visited containsObject:@(number)])continue;
+        [visited addObject:@(number)];
+        [_objectCache pinObjectWithNumber:number GenerationNumber:generation];
+        if(walk == NO || (firstPageTable && [firstPageTable entryForObjectWithNumber:number].type == PDFCrossReferenceEntryTypeNone))continue;
+        
+        NSArray* kids = [self referencesOfKidsInCode:[self codeForObjectWithNumber:number GenerationNumber:generation]];
+        if(kids)[nodes addObjectsFromArray:kids];
+    }
 }
 
 
- -(NSString*)codeForIndirectObjectWithOffset:(NSUInteger)offset
+// The object and generation numbers of the references in the 'Kids' array of a dictionary, read without resolving them.
+
+-(NSArray*)referencesOfKidsInCode:(NSString*)code
 {
-    NSUInteger start = [[self.sourceCode substringFromIndex:offset] rangeOfString:@"obj"].location+[@"obj" length];
-    NSUInteger end = [[self.sourceCode substringFromIndex:offset] rangeOfString:@"endobj"].location;
-    return [self.sourceCode substringWithRange:NSMakeRange(start, end-start)];
+    if(code == nil)return nil;
+    
+    PDFLexer* lexer = [[PDFLexer alloc] initWithData:[PDFUtility dataWithObjectCode:code]];
+    if([lexer nextToken].type != PDFTokenTypeDictionaryOpen)return nil;
+    
+    while(YES)
+    {
+        PDFToken key = [lexer nextToken];
+        if(key.type != PDFTokenTypeName)return nil;
+        if(key.length == 5 && memcmp(lexer.bytes+key.offset+1, "Kids", 4) == 0)break;
+        if([lexer skipObject].location == NSNotFound)return nil;
+    }
+    if([lexer nextToken].type != PDFTokenTypeArrayOpen)return nil;
+    
+    NSMutableArray* ret = [NSMutableArray array];
+    while(YES)
+    {
+        PDFToken number = [lexer nextToken];
+        PDFToken generation = [lexer nextToken];
+        if(number.type != PDFTokenTypeNumber || generation.type != PDFTokenTypeNumber || [lexer token:[lexer nextToken] IsKeyword:"R"] == NO)break;
+        [ret addObject:@[@([lexer integerValueOfToken:number]),@([lexer integerValueOfToken:generation])]];
+    }
+    
+    return ret;
 }
 
 
--(NSString*)codeForObjectWithNumber:(NSInteger)objectNumber GenerationNumber:(NSInteger)generationNumber
+// Runs read with a lexer positioned at offset. For a document read from a data source, the lexer ends at a window of fetched bytes, and read runs again on a window twice as large while it reaches the end of the window. Readers must therefore have no effect besides their result.
+
+-(id)readFileAtOffset:(NSUInteger)offset With:(id(^)(PDFLexer* lexer))read
 {
-   
-    NSArray* crossRefSectionOffsets = self.crossReferenceSectionsOffsets;
-    for(NSInteger c = 0 ; c <[crossRefSectionOffsets count] ; c++)
+    NSData* data = self.fileData;
+    PDFMappedFile* file = [self sourceFile];
+    NSUInteger length = [data length];
+    NSUInteger window = PDFDocumentReadWindow;
+    
+    while(YES)
     {
-        NSUInteger offset = [self offsetForObjectWithNumber:objectNumber InSection:c];
-        if(offset!= NSNotFound)
-        {
-            return [self codeForIndirectObjectWithOffset:offset];
-        }
+        NSUInteger end = (file && offset < length && length-offset > window?offset+window:length);
+        if(file && offset < end && [file loadRange:NSMakeRange(offset, end-offset)] == NO)return nil;
         
+        PDFLexer* lexer = [[PDFLexer alloc] initWithData:data Range:NSMakeRange(0, end)];
+        lexer.position = offset;
+        id ret = read(lexer);
+        if(lexer.position < end || end == length)return ret;
+        window *= 2;
     }
-    
-    return nil;
 }
 
 
--(PDFDictionary*)getTrailerBeforeOffset:(NSUInteger)offset
+// The mapped file whose bytes are fetched from a data source, or nil if every byte of the document is present.
+
+-(PDFMappedFile*)sourceFile
 {
-    NSMutableString* code = [self sourceCode];
+    return (_documentData == nil && _mappedFile.dataSource?_mappedFile:nil);
+}
 
-    NSUInteger trailerStartMarker = [code rangeOfString:@"trailer" options:NSBackwardsSearch range:NSMakeRange(0, offset)].location;
-    NSUInteger trailerEndMarker = [code rangeOfString:@"startxref" options:NSBackwardsSearch range:NSMakeRange(0, offset)].location;
-    
-    while ([code characterAtIndex:trailerStartMarker]!='<') {
-        trailerStartMarker++;
+
+// The file data, with any bytes of a data source fetched first. Everything that copies or writes the whole file reads it here.
+
+-(NSData*)completeFileData
+{
+    PDFMappedFile* file = [self sourceFile];
+    if(file && [file loadRange:NSMakeRange(0, file.originalLength)] == NO)return nil;
+    return self.fileData;
+}
+
+
+// Saving may give new content to existing object numbers, so everything read from the old bytes is dropped.
+
+-(void)invalidateParsedFile
+{
+    _crossReferenceTable = nil;
+    _firstPageCrossReferenceTable = nil;
+    _linearization = nil;
+    _linearizationRead = NO;
+    _objectStreams = nil;
+    _trailer = nil;
+    @synchronized(self)
+    {
+        [_objectCache removeAllObjects];
+        _structurePinned = NO;
     }
-    
-    return [[PDFDictionary alloc] initWithPDFRepresentation:[code substringWithRange:NSMakeRange(trailerStartMarker, trailerEndMarker-trailerStartMarker)] Document:self];
-    
 }
 
 
@@ -0,0 +1,63 @@
+#import <Foundation/Foundation.h>
+#import "PDFDataSource.h"
+
+
+/** The PDFFileDataSource class serves a local file as a PDFDataSource, optionally slowed down to behave like a remote store.
+ Every read waits latency seconds, plus the time its bytes take at bytesPerSecond, before reading the file. Counting reads and bytes shows how much of a file an operation fetches:
+
+     PDFFileDataSource* source = [[PDFFileDataSource alloc] initWithPath:path];
+     source.latency = 0.05;
+     PDFDocument* document = [[PDFDocument alloc] initWithDataSource:source];
+     NSLog(@"%u reads, %u bytes",(unsigned int)source.numberOfReads,(unsigned int)source.numberOfBytesRead);
+
+ A PDFFileDataSource is thread safe. Simulated delays of concurrent reads overlap, as they would on a network.
+ */
+@interface PDFFileDataSource : NSObject <PDFDataSource>
+
+
+/** The file.
+ */
+@property(nonatomic,readonly) NSString* path;
+
+/** The delay before each read, in seconds. Defaults to 0.
+ */
+@property(nonatomic) NSTimeInterval latency;
+
+/** The simulated transfer rate, in bytes per second, or 0 for no limit. Defaults to 0.
+ */
+@property(nonatomic) NSUInteger bytesPerSecond;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Statistics
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** The number of calls to dataWithRange:.
+ */
+@property(nonatomic,readonly) NSUInteger numberOfReads;
+
+/** The total number of bytes returned by dataWithRange:.
+ */
+@property(nonatomic,readonly) NSUInteger numberOfBytesRead;
+
+
+/** Sets numberOfReads and numberOfBytesRead to 0.
+ */
+-(void)resetStatistics;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Creating a PDFFileDataSource
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Opens a file.
+
+ @param path The file to serve. It must not be changed while it is served.
+ @return A new PDFFileDataSource, or nil if the file could not be opened.
+ */
+-(id)initWithPath:(NSString*)path;
+
+
+@end
@@ -0,0 +1,86 @@
+#import "PDFFileDataSource.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <errno.h>
+
+
+@implementation PDFFileDataSource
+{
+    int _fd;
+    NSUInteger _length;
+}
+
+
+-(void)dealloc
+{
+    if(_fd >= 0)close(_fd);
+}
+
+
+-(id)initWithPath:(NSString*)path
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _fd = open([path fileSystemRepresentation], O_RDONLY);
+        if(_fd < 0)return nil;
+
+        struct stat info;
+        if(fstat(_fd, &info) != 0)return nil;
+
+        _path = [path copy];
+        _length = (NSUInteger)info.st_size;
+    }
+
+    return self;
+}
+
+
+-(NSUInteger)length
+{
+    return _length;
+}
+
+
+-(NSData*)dataWithRange:(NSRange)range
+{
+    if(NSMaxRange(range) > _length)return nil;
+
+    // The delay is simulated outside the lock, so concurrent reads wait together.
+    NSTimeInterval delay = _latency;
+    if(_bytesPerSecond > 0)delay += (NSTimeInterval)range.length/_bytesPerSecond;
+    if(delay > 0)[NSThread sleepForTimeInterval:delay];
+
+    NSMutableData* ret = [NSMutableData dataWithLength:range.length];
+    unsigned char* bytes = [ret mutableBytes];
+    NSUInteger offset = 0;
+    while(offset < range.length)
+    {
+        ssize_t count = pread(_fd, bytes+offset, range.length-offset, (off_t)(range.location+offset));
+        if(count < 0 && errno == EINTR)continue;
+        if(count <= 0)return nil;
+        offset += count;
+    }
+
+    @synchronized(self)
+    {
+        _numberOfReads++;
+        _numberOfBytesRead += range.length;
+    }
+
+    return ret;
+}
+
+
+-(void)resetStatistics
+{
+    @synchronized(self)
+    {
+        _numberOfReads = 0;
+        _numberOfBytesRead = 0;
+    }
+}
+
+
+@end
@@ -0,0 +1,75 @@
+#import <Foundation/Foundation.h>
+
+
+/** The PDFFileWriter class writes a PDF file to disk without holding it in memory.
+ Output goes to a temporary file created next to the destination. Existing files can be appended with a kernel side copy, and data is appended with plain writes, so memory use is bounded by the data passed in rather than by the size of the file. commit flushes the temporary file to disk and renames it over the destination, so the destination is replaced atomically and is never left partially written.
+ 
+     PDFFileWriter* writer = [[PDFFileWriter alloc] initWithPath:path];
+     if([writer appendContentsOfFile:document.documentPath] && [writer appendData:update] && [writer commit])
+     {
+        // path now holds the updated file.
+     }
+ 
+ If the writer is released without being committed, the temporary file is removed.
+ */
+@interface PDFFileWriter : NSObject
+
+
+/** The destination path.
+ */
+@property(nonatomic,readonly) NSString* path;
+
+/** The number of bytes written so far.
+ */
+@property(nonatomic,readonly) NSUInteger length;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Creating a PDFFileWriter
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Creates a new instance of PDFFileWriter.
+ 
+ @param path The destination path. Its directory must exist and be writable.
+ @return A new PDFFileWriter, or nil if the temporary file could not be created.
+ */
+-(id)initWithPath:(NSString*)path;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Writing
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Appends the whole contents of a file.
+ 
+ @param sourcePath The file to copy.
+ @return YES if successful, NO if failed.
+ @discussion The bytes are copied by the kernel with fcopyfile on Apple platforms and copy_file_range or sendfile on Linux. Elsewhere, or if those calls fail, they are copied through a fixed size buffer.
+ */
+-(BOOL)appendContentsOfFile:(NSString*)sourcePath;
+
+
+/** Appends data.
+ 
+ @param data The data to append.
+ @return YES if successful, NO if failed.
+ */
+-(BOOL)appendData:(NSData*)data;
+
+
+/** Flushes the written data to disk and moves it to path.
+ 
+ @return YES if successful, NO if failed. Once commit has been called, the writer accepts no more data.
+ @discussion The file keeps the permissions of the file it replaces, or gets the default permissions of a new file under the umask. The directory holding path is flushed after the rename, so the new file survives a crash.
+ */
+-(BOOL)commit;
+
+
+/** Discards everything written and removes the temporary file.
+ */
+-(void)cancel;
+
+
+@end
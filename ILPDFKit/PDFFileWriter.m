@@ -0,0 +1,208 @@
+
+#import "PDFFileWriter.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <errno.h>
+#if defined(__APPLE__)
+#include <copyfile.h>
+#elif defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+
+// The buffer used when the kernel cannot copy a file for us.
+#define PDFFileWriterBufferSize (1 << 20)
+
+
+@interface PDFFileWriter()
+    -(BOOL)writeBytes:(const void*)bytes Length:(NSUInteger)length;
+    -(BOOL)copyFileDescriptor:(int)source Length:(NSUInteger)length;
+    -(mode_t)modeOfDestination;
+    -(void)synchronizeDirectory;
+@end
+
+
+@implementation PDFFileWriter
+{
+    NSString* _temporaryPath;
+    int _fd;
+}
+
+
+-(void)dealloc
+{
+    [self cancel];
+}
+
+
+-(id)initWithPath:(NSString*)path
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _path = [path copy];
+        
+        // The temporary file must be on the same volume as path for the final rename to be atomic.
+        NSMutableData* pattern = [[[path stringByAppendingString:@".XXXXXX"] dataUsingEncoding:NSUTF8StringEncoding] mutableCopy];
+        [pattern appendBytes:"" length:1];
+        _fd = mkstemp([pattern mutableBytes]);
+        if(_fd < 0)return nil;
+        _temporaryPath = @((const char*)[pattern bytes]);
+    }
+    
+    return self;
+}
+
+
+-(BOOL)appendContentsOfFile:(NSString*)sourcePath
+{
+    if(_fd < 0)return NO;
+    
+    int source = open([sourcePath fileSystemRepresentation], O_RDONLY);
+    if(source < 0)return NO;
+    
+    struct stat info;
+    BOOL ret = (fstat(source, &info) == 0 && [self copyFileDescriptor:source Length:(NSUInteger)info.st_size]);
+    close(source);
+    return ret;
+}
+
+
+-(BOOL)appendData:(NSData*)data
+{
+    if(_fd < 0)return NO;
+    return [self writeBytes:[data bytes] Length:[data length]];
+}
+
+
+-(BOOL)commit
+{
+    if(_fd < 0)return NO;
+    
+    // mkstemp creates the file readable by its owner only, so it is given the permissions the destination would otherwise have.
+    BOOL ret = (fchmod(_fd, [self modeOfDestination]) == 0);
+    ret = (fsync(_fd) == 0) && ret;
+#if defined(__APPLE__)
+    // fsync only hands the data to the drive; F_FULLFSYNC asks the drive to make it durable.
+    if(ret)fcntl(_fd, F_FULLFSYNC);
+#endif
+    ret = (close(_fd) == 0) && ret;
+    _fd = -1;
+    
+    if(ret)ret = (rename([_temporaryPath fileSystemRepresentation], [_path fileSystemRepresentation]) == 0);
+    if(ret)
+    {
+        _temporaryPath = nil;
+        [self synchronizeDirectory];
+    }
+    else [self cancel];
+    
+    return ret;
+}
+
+
+-(void)cancel
+{
+    if(_fd >= 0)close(_fd);
+    _fd = -1;
+    if(_temporaryPath)unlink([_temporaryPath fileSystemRepresentation]);
+    _temporaryPath = nil;
+}
+
+
+#pragma mark - Hidden
+
+
+-(BOOL)writeBytes:(const void*)bytes Length:(NSUInteger)length
+{
+    const char* c = bytes;
+    
+    while(length > 0)
+    {
+        ssize_t written = write(_fd, c, length);
+        if(written < 0)
+        {
+            if(errno == EINTR)continue;
+            return NO;
+        }
+        c += written;
+        length -= written;
+        _length += written;
+    }
+    
+    return YES;
+}
+
+
+// The permissions of the file being replaced, or those a new file gets under the current umask.
+
+-(mode_t)modeOfDestination
+{
+    struct stat info;
+    if(stat([_path fileSystemRepresentation], &info) == 0)return info.st_mode & 07777;
+    
+    // The umask can only be read by setting it, so it is restored at once.
+    mode_t mask = umask(0);
+    umask(mask);
+    return 0666 & ~mask;
+}
+
+
+// The rename is only durable once the directory holding the file is flushed too. A failure here does not undo the save, which has already replaced the file.
+
+-(void)synchronizeDirectory
+{
+    NSString* directory = [_path stringByDeletingLastPathComponent];
+    if([directory length] == 0)directory = @".";
+    
+    int fd = open([directory fileSystemRepresentation], O_RDONLY);
+    if(fd < 0)return;
+    fsync(fd);
+    close(fd);
+}
+
+
+-(BOOL)copyFileDescriptor:(int)source Length:(NSUInteger)length
+{
+    NSUInteger copied = 0;
+    
+#if defined(__APPLE__)
+    // fcopyfile writes at the current offset of the destination, which is always its end here.
+    if(fcopyfile(source, _fd, NULL, COPYFILE_DATA) == 0 && lseek(_fd, 0, SEEK_END) == (off_t)(_length+length))
+    {
+        _length += length;
+        return YES;
+    }
+    if(ftruncate(_fd, _length) != 0 || lseek(_fd, _length, SEEK_SET) < 0 || lseek(source, 0, SEEK_SET) < 0)return NO;
+#elif defined(__linux__)
+    while(copied < length)
+    {
+        ssize_t result = copy_file_range(source, NULL, _fd, NULL, length-copied, 0);
+        if(result <= 0)result = sendfile(_fd, source, NULL, length-copied);
+        if(result <= 0)break;
+        copied += result;
+        _length += result;
+    }
+#endif
+    
+    if(copied < length)
+    {
+        char* buffer = malloc(PDFFileWriterBufferSize);
+        if(buffer == NULL)return NO;
+        
+        while(copied < length)
+        {
+            ssize_t result = pread(source, buffer, MIN(length-copied, PDFFileWriterBufferSize), copied);
+            if(result < 0 && errno == EINTR)continue;
+            if(result <= 0 || [self writeBytes:buffer Length:result] == NO)break;
+            copied += result;
+        }
+        
+        free(buffer);
+    }
+    
+    return copied == length;
+}
+
+
+@end
@@ -128,7 +128,7 @@ typedef enum PDFFormType
  */
 @property(nonatomic,weak) PDFFormContainer* parent;
 
-/** The dictionary containing all PDFFormAction actions. The keys match the corresponding key through which the action exists in it's parent PDFDictionary. The main action is under 'A' and additionaly actions are found uner 'K' and 'E'.
+/** The dictionary containing all PDFFormAction actions. The keys match the corresponding key through which the action exists in it's parent PDFDictionary. The main action is under 'A' and additionaly actions are found uner 'K', 'E' and 'C'.
  */
 @property(nonatomic,strong) NSMutableDictionary* actions;
 
@@ -145,6 +145,16 @@ typedef enum PDFFormType
 @property(nonatomic) BOOL modified;
 
 
+/** The object number of the field dictionary that holds the value of the form, or NSNotFound if it is not known.
+ @discussion This is the form's own dictionary if it has a 'T' entry, otherwise its parent field. It is recorded by PDFFormContainer when the fields are enumerated, and used to rewrite the field when the document is saved.
+ */
+@property(nonatomic) NSUInteger objectNumber;
+
+/** The generation number of the field dictionary that holds the value of the form.
+ */
+@property(nonatomic) NSUInteger generationNumber;
+
+
 /** The appearance stream for the set state of button forms. Can be used to customize button appearance to better match the PDF.
  */
 @property(nonatomic,strong) NSString* setAppearanceStream;
@@ -167,6 +177,38 @@ typedef enum PDFFormType
 -(id)initWithFieldDictionary:(PDFDictionary*)leaf Page:(PDFPage*)pg Parent:(PDFFormContainer*)p;
 
 
+/** Creates a new instance of PDFForm using the resolved attributes of its parent field.
+ 
+ @param leaf Either a terminal Acroform field dictionary (i.e. with no children), a terminal widget annotation dictionary, or a union of both.
+ @param pg The page that contains the form.
+ @param p The parent.
+ @param parentAttributes The attributes of the field whose 'Kids' contain leaf, as returned by attributesOfFieldDictionary:ParentAttributes:, or nil if leaf is a top level field.
+ @return A new PDFForm object.
+ @discussion The field tree is not walked, so creating a form costs the same at any depth of the hierarchy.
+ */
+-(id)initWithFieldDictionary:(PDFDictionary*)leaf Page:(PDFPage*)pg Parent:(PDFFormContainer*)p ParentAttributes:(NSDictionary*)parentAttributes;
+
+
+/** Creates a new instance of PDFForm with the state of another form.
+ 
+ @param form The form to copy.
+ @param p The parent of the new form.
+ @return A new PDFForm object with the value, attributes and actions of form, which is not marked as modified.
+ @discussion No dictionary is read, so copying a form is much cheaper than creating it. The actions are copied, so they run in the container of the new form.
+ */
+-(id)initWithForm:(PDFForm*)form Parent:(PDFFormContainer*)p;
+
+
+/** Resolves the attributes of a field dictionary that its descendants may need.
+ 
+ @param field A field dictionary.
+ @param parentAttributes The resolved attributes of the parent of field, or nil if field is a top level field.
+ @return A dictionary holding the inheritable entries 'V', 'FT', 'DV', 'TU', 'Ff', 'Q' and 'Opt' in effect for field, its own 'AA' entry, and the fully qualified name of field for the key 'T'.
+ @discussion A non terminal field is resolved once and its attributes are shared by all of its descendants.
+ */
++(NSDictionary*)attributesOfFieldDictionary:(PDFDictionary*)field ParentAttributes:(NSDictionary*)parentAttributes;
+
+
 /**---------------------------------------------------------------------------------------
  * @name Updating Data
  *  ---------------------------------------------------------------------------------------
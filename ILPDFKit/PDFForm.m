@@ -13,14 +13,19 @@
 #import "PDFStream.h"
 #import "PDFDocument.h"
 #import "PDF.h"
+#import "PDFNameTable.h"
 #import <QuartzCore/QuartzCore.h>
 
+// Parent chains longer than this are treated as cyclic.
+#define PDFFormMaximumFieldDepth 256
+
+// Radio buttons are recognized by the operators near the start of their appearance stream, so no more than this many bytes are decoded.
+#define PDFFormAppearanceStreamPrefixLength 4096
+
 
 @interface PDFForm() 
 
-    -(id)getAttributeFromLeaf:(PDFDictionary*)leaf Name:(NSString*)nme Inheritable:(BOOL)inheritable;
-    -(NSString*)getFormNameFromLeaf:(PDFDictionary*)leaf;
-    -(NSMutableDictionary*)getActionsFromLeaf:(PDFDictionary*)leaf;
+    -(NSMutableDictionary*)getActionsFromLeaf:(PDFDictionary*)leaf Attributes:(NSDictionary*)attributes;
     -(NSString*)getExportValueFrom:(PDFDictionary*)leaf;
     -(NSString*)getSetAppearanceStreamFromLeaf:(PDFDictionary*)leaf;
     -(void)updateFlagsString;
@@ -35,24 +40,47 @@
 }
 
 -(id)initWithFieldDictionary:(PDFDictionary*)leaf Page:(PDFPage*)pg Parent:(PDFFormContainer*)p
+{
+    // Without the attributes of the parent, the chain of ancestors is resolved from the top.
+    NSMutableArray* ancestors = [NSMutableArray array];
+    PDFDictionary* iter = ([leaf objectForKey:@"Parent"]?[leaf objectForKey:@"Parent"]:leaf.parent);
+    while(iter != nil && [ancestors count] < PDFFormMaximumFieldDepth)
+    {
+        [ancestors insertObject:iter atIndex:0];
+        iter = [iter objectForKey:@"Parent"];
+    }
+    
+    NSDictionary* parentAttributes = nil;
+    for(PDFDictionary* ancestor in ancestors)parentAttributes = [PDFForm attributesOfFieldDictionary:ancestor ParentAttributes:parentAttributes];
+    
+    return [self initWithFieldDictionary:leaf Page:pg Parent:p ParentAttributes:parentAttributes];
+}
+
+
+-(id)initWithFieldDictionary:(PDFDictionary*)leaf Page:(PDFPage*)pg Parent:(PDFFormContainer*)p ParentAttributes:(NSDictionary*)parentAttributes
 {
     self = [super init];
     if(self != nil)
     {
-        _value = [self getAttributeFromLeaf:leaf Name:@"V" Inheritable:YES];
-        self.name = [self getFormNameFromLeaf:leaf ];
-        NSString* formTypeString = [self getAttributeFromLeaf:leaf Name:@"FT"  Inheritable:YES];
-        self.defaultValue = [self getAttributeFromLeaf:leaf Name:@"DV"  Inheritable:YES];
-         self.uname = [self getAttributeFromLeaf:leaf Name:@"TU"  Inheritable:YES];
-       _flags = [[self getAttributeFromLeaf:leaf Name:@"Ff"  Inheritable:YES] unsignedIntegerValue];
-        NSNumber* formTextAlignment = [self getAttributeFromLeaf:leaf Name:@"Q" Inheritable:YES];
-        self.actions = [self getActionsFromLeaf:leaf];
+        // A widget listed in the 'Kids' of a field without a 'Parent' entry of its own takes every field attribute from that field.
+        NSDictionary* attributes = parentAttributes;
+        if([leaf objectForKey:@"Parent"] != nil || parentAttributes == nil)attributes = [PDFForm attributesOfFieldDictionary:leaf ParentAttributes:parentAttributes];
+        
+        _objectNumber = NSNotFound;
+        _value = attributes[PDFNameV];
+        self.name = attributes[PDFNameT];
+        NSString* formTypeString = attributes[PDFNameFT];
+        self.defaultValue = attributes[PDFNameDV];
+        self.uname = attributes[PDFNameTU];
+        _flags = [attributes[PDFNameFf] unsignedIntegerValue];
+        NSNumber* formTextAlignment = attributes[PDFNameQ];
+        self.actions = [self getActionsFromLeaf:leaf Attributes:attributes];
         self.exportValue = [self getExportValueFrom:leaf];
         self.setAppearanceStream = [self getSetAppearanceStreamFromLeaf:leaf];
         
         @autoreleasepool {
         
-            NSArray* arr = [[self getAttributeFromLeaf:leaf Name:@"Opt" Inheritable:YES] nsa];
+            NSArray* arr = [attributes[PDFNameOpt] nsa];
             
             NSMutableArray* temp = [NSMutableArray array];
             
@@ -72,19 +100,20 @@
         
         }
         
-        if([formTypeString isEqualToString:@"Btn"])
+        // An interned field type is the constant itself, so the pointer check decides. A type from a dictionary that was not read through a name table is compared by value.
+        if(PDFNameIsEqual(formTypeString, PDFNameBtn))
         {
             self.formType = PDFFormTypeButton;
         }
-        else if([formTypeString isEqualToString:@"Tx"])
+        else if(PDFNameIsEqual(formTypeString, PDFNameTx))
         {
             self.formType = PDFFormTypeText;
         }
-        else if([formTypeString isEqualToString:@"Ch"])
+        else if(PDFNameIsEqual(formTypeString, PDFNameCh))
         {
             self.formType = PDFFormTypeChoice;
         }
-        else if([formTypeString isEqualToString:@"Sig"])
+        else if(PDFNameIsEqual(formTypeString, PDFNameSig))
         {
             self.formType = PDFFormTypeSignature;
         }
@@ -148,6 +177,50 @@
     return self;
 }
 
+-(id)initWithForm:(PDFForm*)form Parent:(PDFFormContainer*)p
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _value = form.value;
+        _page = form.page;
+        _frame = form.frame;
+        _formType = form.formType;
+        _cropBox = form.cropBox;
+        _mediaBox = form.mediaBox;
+        _name = form.name;
+        _uname = form.uname;
+        _defaultValue = form.defaultValue;
+        _flagsString = form.flagsString;
+        _options = form.options;
+        _textAlignment = form.textAlignment;
+        _uiBaseFrame = form.uiBaseFrame;
+        _pageFrame = form.pageFrame;
+        _exportValue = form.exportValue;
+        _objectNumber = form.objectNumber;
+        _generationNumber = form.generationNumber;
+        _setAppearanceStream = form.setAppearanceStream;
+        _flags = form->_flags;
+        _annotFlags = form->_annotFlags;
+        
+        _actions = [NSMutableDictionary dictionary];
+        for(NSString* key in form.actions)
+        {
+            PDFFormAction* source = (form.actions)[key];
+            PDFFormAction* action = [[PDFFormAction alloc] init];
+            action.string = source.string;
+            action.key = source.key;
+            action.prefix = source.prefix;
+            action.parent = self;
+            _actions[key] = action;
+        }
+        
+        self.parent = p;
+    }
+    
+    return self;
+}
+
 -(void)dealloc
 {
     [self removeObservers];
@@ -423,7 +496,6 @@
         [_parent setDocumentValue:self.value ForKey:@"EventValue"];
         ((PDFFormAction*)_actions[@"K"]).prefix = ((PDFFormAction*)_actions[@"E"]).string;
         [_actions[@"K"] execute];
-        [_actions[@"K"] execute];
     }
 }
 
@@ -439,73 +511,32 @@
 
 #pragma mark - Hidden
 
--(id)getAttributeFromLeaf:(PDFDictionary*)leaf Name:(NSString*)nme  Inheritable:(BOOL)inheritable 
++(NSDictionary*)attributesOfFieldDictionary:(PDFDictionary*)field ParentAttributes:(NSDictionary*)parentAttributes
 {
-   
-    PDFDictionary* iter = nil;
-    PDFDictionary* temp = nil;
-    id object;
+    NSMutableDictionary* ret = [NSMutableDictionary dictionaryWithDictionary:parentAttributes];
     
-    temp = [leaf objectForKey:@"Parent"];
-    
-    iter = ((temp == nil)?leaf.parent:leaf);temp = nil;
-    
-    if(iter == nil)iter = leaf;
-    
-    BOOL objectIsValid;
-    
-    while(!(objectIsValid = ((object = [iter objectForKey:nme])!=nil)) && (inheritable == YES))
+    for(NSString* key in @[PDFNameV,PDFNameFT,PDFNameDV,PDFNameTU,PDFNameFf,PDFNameQ,PDFNameOpt])
     {
-        object = nil;
-        if(!(temp = [iter objectForKey:@"Parent"]))break;
-        iter = temp;
+        id object = [field objectForKey:key];
+        if(object != nil)ret[key] = object;
     }
     
-    if((inheritable == NO && objectIsValid == NO) || object == NULL)return nil;
-    return object;
-}
-
-
--(NSString*)getFormNameFromLeaf:(PDFDictionary*)leaf 
-{
-    
-   
-    PDFDictionary* iter = nil;
-    PDFDictionary* temp = nil;
-    
-    temp = [leaf objectForKey:@"Parent"];
-    
-    iter = ((temp==nil)?leaf.parent:leaf);temp = nil;
-    
-    if(iter==nil)iter = leaf;
-    
+    // Additional actions are not inherited.
+    id additionalActions = [field objectForKey:PDFNameAA];
+    if(additionalActions != nil)ret[PDFNameAA] = additionalActions;
+    else [ret removeObjectForKey:PDFNameAA];
     
-    NSString* string = nil;
-    NSString* ret = @"";
-    
-    do{
-        
-        BOOL objectIsValid = [(string = [iter objectForKey:@"T"]) isKindOfClass:[NSString class]];
-        
-        if(objectIsValid)
-        {
-            ret = [[NSString stringWithFormat:@"%@.",string] stringByAppendingString:ret];
-        }
-        
-        temp = [iter objectForKey:@"Parent"];
-        
-        if(temp == nil)break;
-        iter = temp;
-        
-    }while(YES);
-    
-    if([ret length]>0)ret = [ret substringToIndex:[ret length]-1];
+    // Fields without a partial name do not add a component to the fully qualified name.
+    NSString* parentName = (parentAttributes[PDFNameT]?parentAttributes[PDFNameT]:@"");
+    NSString* partialName = [field objectForKey:PDFNameT];
+    if([partialName isKindOfClass:[NSString class]])ret[PDFNameT] = ([parentName length]?[NSString stringWithFormat:@"%@.%@",parentName,partialName]:partialName);
+    else ret[PDFNameT] = parentName;
     
     return ret;
 }
 
 
--(NSMutableDictionary*)getActionsFromLeaf:(PDFDictionary*)leaf
+-(NSMutableDictionary*)getActionsFromLeaf:(PDFDictionary*)leaf Attributes:(NSDictionary*)attributes
 {
     NSMutableDictionary* ret = [NSMutableDictionary dictionary];
     
@@ -518,26 +549,18 @@
         act.key = @"A";
     }
     
-    PDFDictionary* iter = nil;
-    PDFDictionary* temp = nil;
-    
-    temp = [leaf objectForKey:@"Parent"];
-    iter = ((temp==nil)?leaf.parent:leaf);temp = nil;
-    
-    if(iter==nil)iter = leaf;
-    
     PDFDictionary* additionalActions = nil;
     
-    BOOL active = ((additionalActions = [iter objectForKey:@"AA"]) != nil);
+    BOOL active = ((additionalActions = attributes[PDFNameAA]) != nil);
     
-    if(active == NO && iter!= leaf)
+    if(active == NO)
     {
         active = ((additionalActions = [leaf objectForKey:@"AA"]) != nil);
     }
     
     if(active)
     {
-        NSArray* keys = @[@"E",@"K"];
+        NSArray* keys = @[@"E",@"K",@"C"];
         
         for(NSString* key in keys)
         {
@@ -559,20 +582,20 @@
 {
     PDFDictionary* ap = nil;
     
-    if((ap = [leaf objectForKey:@"AP"]))
+    if((ap = [leaf objectForKey:PDFNameAP]))
     {
         PDFDictionary* n = nil;
-        if([(n = [ap objectForKey:@"N"]) isKindOfClass:[PDFDictionary class]])
+        if([(n = [ap objectForKey:PDFNameN]) isKindOfClass:[PDFDictionary class]])
         {
             for(NSString* key in [n allKeys])
             {
-                if([key isEqualToString:@"Off"] == NO && [key isEqualToString:@"OFF"] == NO)
+                if(PDFNameIsEqual(key, PDFNameOff) == NO && [key isEqualToString:@"OFF"] == NO)
                 {
                     PDFStream* str = [n objectForKey:key];
                     if([str isKindOfClass:[PDFStream class]])
                     {
-                        NSData* dat = str.data;
-                        if(str.dataFormat == CGPDFDataFormatRaw)
+                        NSData* dat = [str dataWithMaximumLength:PDFFormAppearanceStreamPrefixLength];
+                        if(dat && str.dataFormat == CGPDFDataFormatRaw)
                         {
                             return [[NSString alloc] initWithData:dat encoding:NSASCIIStringEncoding];
                         }
@@ -589,14 +612,14 @@
 {
     PDFDictionary* ap = nil;
     
-    if((ap = [leaf objectForKey:@"AP"]))
+    if((ap = [leaf objectForKey:PDFNameAP]))
     {
         PDFDictionary* n = nil;
-        if([(n = [ap objectForKey:@"N"]) isKindOfClass:[PDFDictionary class]])
+        if([(n = [ap objectForKey:PDFNameN]) isKindOfClass:[PDFDictionary class]])
         {
             for(NSString* key in [n allKeys])
             {
-                if([key isEqualToString:@"Off"] == NO && [key isEqualToString:@"OFF"] == NO)return key;
+                if(PDFNameIsEqual(key, PDFNameOff) == NO && [key isEqualToString:@"OFF"] == NO)return key;
             }
         }
     }
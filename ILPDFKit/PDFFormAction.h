@@ -34,6 +34,7 @@
  - A: Performed when a button is pressed or a text field starts editing or a choice field is expanded.
  - K: Performed when a text field is edited or a choice field selection is modified.
  - E: Performed when a text field starts editing or a choice field is expanded.
+ - C: Performed to recalculate the value of the field when a field it reads changes. The calculation order of the document is managed by the PDFFormContainer.
  
  */
 @property(nonatomic,strong) NSString* key;
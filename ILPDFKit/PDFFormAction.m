@@ -5,6 +5,7 @@
 #import "PDFFormContainer.h"
 #import "PDFDictionary.h"
 #import "PDFStream.h"
+#import "PDFNameTable.h"
 
 @implementation PDFFormAction
 
@@ -16,11 +17,11 @@
     self = [super init];
     if(self != nil)
     {
-        NSString* actionType = [dict objectForKey:@"S"];
+        NSString* actionType = [dict objectForKey:PDFNameS];
         
-        if([actionType isEqualToString:@"JavaScript"])
+        if(PDFNameIsEqual(actionType, PDFNameJavaScript))
         {
-            id js = [dict objectForKey:@"JS"];
+            id js = [dict objectForKey:PDFNameJS];
             if([js isKindOfClass:[NSString class]])
             {
                 self.string = js;
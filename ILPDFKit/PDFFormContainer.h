@@ -2,6 +2,7 @@
 
 #import <Foundation/Foundation.h>
 #import "PDFForm.h"
+#import "PDFScriptEngine.h"
 
 @class PDFForm;
 @class PDFDocument;
@@ -9,12 +10,17 @@
 
 /** The PDFFormContainer class represents a container class for all the PDFForm objects attached to a PDFDocument. It manages the Adobe AcroScript execution environment as well as the UIKit representation of a PDFForm.
  */
-@interface PDFFormContainer : NSObject<UIWebViewDelegate,NSFastEnumeration>
+@interface PDFFormContainer : NSObject<NSFastEnumeration>
 
 /** The parent PDFDocument.
  */
 @property(nonatomic,weak) PDFDocument* document;
 
+/** The engine that runs the scripts of the forms.
+ @discussion By default, a PDFJavaScriptEngine. Set it to nil to ignore scripts.
+ */
+@property(nonatomic,strong) id<PDFScriptEngine> scriptEngine;
+
 /**---------------------------------------------------------------------------------------
  * @name Creating a PDFFormContainer
  *  ---------------------------------------------------------------------------------------
@@ -30,6 +36,16 @@
 -(id)initWithParentDocument:(PDFDocument*)parent;
 
 
+/** Creates a new instance of PDFFormContainer holding copies of the forms of another container.
+ 
+ @param parent The PDFDocument that owns the PDFFormContainer.
+ @param forms The container to copy, typically the forms of a PDFTemplate.
+ @return A new PDFFormContainer object.
+ @discussion The field tree is not read and the initialization scripts are not run again, since their effects are already part of the copied forms. The calculation order is shared with forms. The copied container is only read, so several containers can be created from it at once.
+ */
+-(id)initWithParentDocument:(PDFDocument*)parent Forms:(PDFFormContainer*)forms;
+
+
 
 /**---------------------------------------------------------------------------------------
  * @name Retrieving Forms
@@ -71,6 +87,24 @@
 -(NSArray*)formsWithType:(PDFFormType)type;
 
 
+/** Returns the partial names of the fields directly below a field.
+ 
+ @param name The fully qualified name of a field, or nil for the top level fields.
+ @return The partial names of the children of the field, in document order, or an empty array for a terminal field.
+ @discussion Together with formsWithName:, this walks the field hierarchy without building it.
+ */
+-(NSArray*)childComponentsOfName:(NSString*)name;
+
+
+/** Returns the value of the forms with a name.
+ 
+ @param name The name of the form(s).
+ @return The common value of the forms, or nil if there is none.
+ @discussion Script engines read field values through this method. While a calculation script runs, every name read is recorded as a dependency of the calculated field, so the calculation is repeated only when one of those fields changes.
+ */
+-(NSString*)valueForFormWithName:(NSString*)name;
+
+
 /**---------------------------------------------------------------------------------------
  * @name Adding and Removing Forms
  *  ---------------------------------------------------------------------------------------
@@ -114,6 +148,7 @@
 /** Sets a form value.
  @param val The value to set.
  @param name The name of the form(s) to set the value for. 
+ @discussion If the value changes, the calculation scripts ('C' actions) of the fields that read it are run again, in the calculation order ('CO') of the document, followed by the calculations that read the fields they change. Calculations whose dependencies have not been recorded yet, because they have never run, are treated as reading every field.
  */
 -(void)setValue:(NSString*)val ForFormWithName:(NSString*)name;
 
@@ -156,6 +191,7 @@
 
 /** Returns an XML representation of the form values in the document.
  @return The xml string defining the value and hierarchical structure of all forms in the document.
+ @discussion To exchange form data with other applications, use PDFFormDataWriter and PDFFormDataReader, which write and read the standard XFDF and FDF formats.
  */
 -(NSString*)formXML;
 
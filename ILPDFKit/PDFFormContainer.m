@@ -4,23 +4,43 @@
 #import "PDFDocument.h"
 #import "PDFForm.h"
 #import "PDFDictionary.h"
+#import "PDFArray.h"
 #import "PDFPage.h"
 #import "PDFFormAction.h"
 #import "PDFStream.h"
 #import "PDFUIAdditionElementView.h"
 #import "PDFFormChoiceField.h"
 #import "PDFUtility.h"
+#import "PDFFormNameTree.h"
+#import "PDFNameTable.h"
+#import "PDFJavaScriptEngine.h"
+#import "PDFTrace.h"
+
+
+// Parent chains longer than this are treated as cyclic.
+#define PDFFormContainerMaximumFieldDepth 256
+
+/* The structures of PDFDocument shared by the threads that read the fields.
+ */
+@interface PDFDocument(PDFFormContainer)
+    -(void)loadSharedStructure;
+@end
+
 
 @interface PDFFormContainer()
-    -(void)populateNameTreeNode:(NSMutableDictionary*)node WithComponents:(NSArray*)components Final:(PDFForm*)final;
-    -(NSArray*)formsDescendingFromTreeNode:(NSDictionary*)node;
-    -(void)applyAnnotationTypeLeafToForms:(PDFDictionary*)leaf Parent:(PDFDictionary*)parent PageMap:(NSDictionary*)pmap;
-    -(void)enumerateFields:(PDFDictionary*)fieldDict PageMap:(NSDictionary*)pmap;
-    -(NSString*)delimeter;
+    -(void)applyAnnotationTypeLeafToForms:(PDFDictionary*)leaf Parent:(PDFDictionary*)parent PageMap:(NSDictionary*)pmap FieldObject:(PDFObject*)leafObject ParentAttributes:(NSDictionary*)parentAttributes Forms:(NSMutableArray*)forms;
+    -(void)enumerateFields:(PDFDictionary*)fieldDict PageMap:(NSDictionary*)pmap FieldObject:(PDFObject*)fieldObject ParentAttributes:(NSDictionary*)parentAttributes Forms:(NSMutableArray*)forms;
+    -(id)resolvedFileObject:(id)object;
+    -(NSArray*)fileObjectsForFields:(NSArray*)fields FileFields:(NSArray*)fileFields;
     -(NSArray*)allForms;
     -(void)initializeJS;
-    -(NSString*)formXMLForFormsWithRootNode:(NSDictionary*)node;
-    -(void)loadJS;
+    -(BOOL)appendFormXMLForFormsWithName:(NSString*)name ToString:(NSMutableString*)xml;
+    -(void)loadCalculationOrder:(NSArray*)co;
+    -(void)loadCalculationsWithNames:(NSArray*)candidates;
+    -(NSString*)qualifiedNameOfFieldDictionary:(PDFDictionary*)field;
+    -(void)calculateFormsDependingOnFormWithName:(NSString*)name;
+    -(void)scheduleCalculationsDependingOnFormWithName:(NSString*)name;
+    -(void)runCalculationAtIndex:(NSUInteger)index;
 @end
 
 @implementation PDFFormContainer
@@ -28,8 +48,17 @@
     
     NSMutableArray* _formsByType[PDFFormTypeNumberOfFormTypes];
     NSMutableArray* _allForms;
-    NSMutableDictionary* _nameTree;
-    UIWebView* _jsParser;
+    PDFFormNameTree* _nameTree;
+    NSMutableDictionary* _documentValues;
+    
+    NSArray* _calculationOrder;
+    NSArray* _calculationActions;
+    NSMutableArray* _calculationReads;
+    NSMutableDictionary* _calculationDependents;
+    NSMutableIndexSet* _unrecordedCalculations;
+    NSMutableIndexSet* _pendingCalculations;
+    NSMutableIndexSet* _completedCalculations;
+    NSMutableSet* _recordedReads;
 }
 
 
@@ -40,44 +69,71 @@
     {
         for(NSUInteger i = 0 ; i < PDFFormTypeNumberOfFormTypes ; i++)_formsByType[i] = [[NSMutableArray alloc] init];
         _allForms = [[NSMutableArray alloc] init];
-        _nameTree = [[NSMutableDictionary alloc] init];
+        _nameTree = [[PDFFormNameTree alloc] init];
         _document = parent;
+        [_document loadSharedStructure];
         NSMutableDictionary* pmap = [NSMutableDictionary dictionary];
         for(PDFPage* page in _document.pages)
         {
             pmap[@((NSUInteger)(page.dictionary.dict))] = @(page.pageNumber);
         }
         PDFDictionary*catalog = _document.catalog;
-        for(PDFDictionary* field in [[catalog objectForKey:@"AcroForm"] objectForKey: @"Fields"])
+        
+        // The fields are also read from the file itself, in the same order, to learn the object number of each field dictionary.
+        PDFDictionary* fileAcroForm = [self resolvedFileObject:[[self resolvedFileObject:[_document.trailer objectForKey:@"Root"]] objectForKey:@"AcroForm"]];
+        NSArray* fields = [[[catalog objectForKey:@"AcroForm"] objectForKey: @"Fields"] nsa];
+        NSArray* fileFields = [self fileObjectsForFields:fields FileFields:[[self resolvedFileObject:[fileAcroForm objectForKey:@"Fields"]] nsa]];
+        
+        // Each top level field is a separate subtree, so the subtrees are read concurrently, one worker per core. Their forms are then added in field order, so the result does not depend on scheduling.
+        PDFTraceBegin(span);
+        NSMutableArray* subtreeForms = [NSMutableArray arrayWithCapacity:[fields count]];
+        for(NSUInteger i = 0 ; i < [fields count] ; i++)[subtreeForms addObject:[NSMutableArray array]];
+        
+        dispatch_apply([fields count], dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+            @autoreleasepool {
+                PDFObject* fieldObject = ([fileFields[i] isKindOfClass:[NSNull class]]?nil:fileFields[i]);
+                [self enumerateFields:fields[i] PageMap:pmap FieldObject:fieldObject ParentAttributes:nil Forms:subtreeForms[i]];
+            }
+        });
+        
+        for(NSArray* forms in subtreeForms)
         {
-            [self enumerateFields:field PageMap:pmap];
+            for(PDFForm* form in forms)[self addForm:form];
         }
+        PDFTraceEnd(span, @"PDFFormContainer.enumerateFields");
         
-        [self loadJS];
+        _documentValues = [[NSMutableDictionary alloc] init];
+        _scriptEngine = [[PDFJavaScriptEngine alloc] init];
+        [self initializeJS];
+        
+        // The calculation order is loaded last, so values set by the initialization scripts do not trigger calculations.
+        [self loadCalculationOrder:[[[catalog objectForKey:PDFNameAcroForm] objectForKey:PDFNameCO] nsa]];
     }
     return self;
 }   
 
--(NSArray*)formsWithName:(NSString*)name
+-(id)initWithParentDocument:(PDFDocument*)parent Forms:(PDFFormContainer*)forms
 {
-    id current = _nameTree;
-    NSArray* comps = [name componentsSeparatedByString:@"."];
-    
-    for(NSString* comp in comps)
+    self = [super init];
+    if(self!=nil)
     {
-        current = current[comp];
-        if(current == nil)return nil;
+        for(NSUInteger i = 0 ; i < PDFFormTypeNumberOfFormTypes ; i++)_formsByType[i] = [[NSMutableArray alloc] init];
+        _allForms = [[NSMutableArray alloc] init];
+        _nameTree = [[PDFFormNameTree alloc] init];
+        _document = parent;
         
-        if([current isKindOfClass:[NSMutableArray class]])
-        {
-            if(comp == [comps lastObject])
-                return current;
-            else
-                return nil;
-        }
+        for(PDFForm* form in forms)[self addForm:[[PDFForm alloc] initWithForm:form Parent:self]];
+        
+        _documentValues = [[NSMutableDictionary alloc] initWithDictionary:forms->_documentValues];
+        _scriptEngine = [[PDFJavaScriptEngine alloc] init];
+        [self loadCalculationsWithNames:forms->_calculationOrder];
     }
-    
-    return [self formsDescendingFromTreeNode:current];
+    return self;
+}
+
+-(NSArray*)formsWithName:(NSString*)name
+{
+    return [_nameTree formsWithName:name];
 }
 
 
@@ -86,6 +142,12 @@
     return _formsByType[type];
 }
 
+-(NSString*)valueForFormWithName:(NSString*)name
+{
+    [_recordedReads addObject:name];
+    return [(PDFForm*)[[self formsWithName:name] lastObject] value];
+}
+
 -(NSArray*)allForms
 {
     return _allForms;
@@ -96,108 +158,115 @@
 {
     [_formsByType[form.formType] addObject:form];
     [_allForms addObject:form];
-    [self populateNameTreeNode:_nameTree WithComponents:[form.name componentsSeparatedByString:@"."] Final:form];
+    [_nameTree addForm:form];
 }
 
 -(void)removeForm:(PDFForm*)form
 {
     [_formsByType[form.formType] removeObject:form];
     [_allForms removeObject:form];
-    
-    id current = _nameTree;
-    NSArray* comps = [form.name componentsSeparatedByString:@"."];
-    
-    for(NSString* comp in comps)
-    {
-        current = current[comp];
-    }
-    
-    [current removeObject:form];
+    [_nameTree removeForm:form];
 }
 
 
 #pragma mark - Hidden
 
--(NSString*)delimeter
-{
-    return @"*delim*";
-}
-
--(void)enumerateFields:(PDFDictionary*)fieldDict PageMap:(NSDictionary*)pmap
+-(void)enumerateFields:(PDFDictionary*)fieldDict PageMap:(NSDictionary*)pmap FieldObject:(PDFObject*)fieldObject ParentAttributes:(NSDictionary*)parentAttributes Forms:(NSMutableArray*)forms
 {
-    if([fieldDict objectForKey:@"Subtype"])
+    if([fieldDict objectForKey:PDFNameSubtype])
     {
-        PDFDictionary* parent = [fieldDict objectForKey:@"Parent"];
-        [self applyAnnotationTypeLeafToForms:fieldDict Parent:parent PageMap:pmap];
+        PDFDictionary* parent = [fieldDict objectForKey:PDFNameParent];
+        [self applyAnnotationTypeLeafToForms:fieldDict Parent:parent PageMap:pmap FieldObject:fieldObject ParentAttributes:parentAttributes Forms:forms];
     }
     else
     {
-        for(PDFDictionary* innerFieldDictionary in [fieldDict objectForKey:@"Kids"])
+        // Inherited attributes and the qualified name are resolved once here and shared by every descendant.
+        NSDictionary* attributes = [PDFForm attributesOfFieldDictionary:fieldDict ParentAttributes:parentAttributes];
+        NSArray* kids = [[fieldDict objectForKey:PDFNameKids] nsa];
+        NSArray* fileKids = [self fileObjectsForFields:kids FileFields:[[[self resolvedFileObject:fieldObject] objectForKey:PDFNameKids] nsa]];
+        
+        for(NSUInteger i = 0 ; i < [kids count] ; i++)
         {
-            PDFDictionary* parent = [innerFieldDictionary objectForKey:@"Parent"];
-            if(parent!=nil)[self enumerateFields:innerFieldDictionary PageMap:pmap];
-            else [self applyAnnotationTypeLeafToForms:innerFieldDictionary Parent:fieldDict PageMap:pmap];
+            PDFDictionary* innerFieldDictionary = kids[i];
+            PDFObject* innerFieldObject = ([fileKids[i] isKindOfClass:[NSNull class]]?nil:fileKids[i]);
+            PDFDictionary* parent = [innerFieldDictionary objectForKey:PDFNameParent];
+            if(parent!=nil)[self enumerateFields:innerFieldDictionary PageMap:pmap FieldObject:innerFieldObject ParentAttributes:attributes Forms:forms];
+            else [self applyAnnotationTypeLeafToForms:innerFieldDictionary Parent:fieldDict PageMap:pmap FieldObject:innerFieldObject ParentAttributes:attributes Forms:forms];
         }
     }
 }
 
--(void)applyAnnotationTypeLeafToForms:(PDFDictionary*)leaf Parent:(PDFDictionary*)parent PageMap:(NSDictionary*)pmap
+-(void)applyAnnotationTypeLeafToForms:(PDFDictionary*)leaf Parent:(PDFDictionary*)parent PageMap:(NSDictionary*)pmap FieldObject:(PDFObject*)leafObject ParentAttributes:(NSDictionary*)parentAttributes Forms:(NSMutableArray*)forms
 {
-    NSUInteger targ = (NSUInteger)(((PDFDictionary*)[leaf objectForKey:@"P"]).dict);
+    NSUInteger targ = (NSUInteger)(((PDFDictionary*)[leaf objectForKey:PDFNameP]).dict);
     leaf.parent = parent;
     
     NSUInteger index = targ?([pmap[@(targ)] unsignedIntegerValue] - 1):0;
-    PDFForm* form = [[PDFForm alloc] initWithFieldDictionary:leaf Page:(_document.pages)[index] Parent:self];
-    [self addForm:form];
+    
+    // A top level leaf has no resolved parent, so the form walks any 'Parent' chain itself.
+    PDFForm* form = nil;
+    if(parentAttributes)form = [[PDFForm alloc] initWithFieldDictionary:leaf Page:(_document.pages)[index] Parent:self ParentAttributes:parentAttributes];
+    else form = [[PDFForm alloc] initWithFieldDictionary:leaf Page:(_document.pages)[index] Parent:self];
+    
+    // The value lives in the dictionary carrying the partial name, which is the parent field for widgets without a 'T' entry.
+    PDFDictionary* fileLeaf = [self resolvedFileObject:leafObject];
+    PDFObject* valueObject = leafObject;
+    if([leaf objectForKey:PDFNameT] == nil)valueObject = [fileLeaf objectForKey:PDFNameParent];
+    
+    // The trees are only matched by position, so a disagreement about the partial name means they have diverged.
+    BOOL matches = (([leaf objectForKey:PDFNameT] == nil) == ([fileLeaf objectForKey:PDFNameT] == nil));
+    
+    if(matches && [valueObject isMemberOfClass:[PDFObject class]] && valueObject.objectNumber > 0)
+    {
+        form.objectNumber = valueObject.objectNumber;
+        form.generationNumber = valueObject.generationNumber;
+    }
+    
+    [forms addObject:form];
 }
 
--(NSArray*)formsDescendingFromTreeNode:(NSDictionary*)node
+// Pairs each field read through CGPDF with its entry in the file. Both arrays list the fields in the same order, but either may drop entries the other keeps, such as nulls or references to missing objects. When their counts differ, entries are paired in order by their partial names, so one odd entry leaves only the fields it hides unbound.
+
+-(NSArray*)fileObjectsForFields:(NSArray*)fields FileFields:(NSArray*)fileFields
 {
-    NSMutableArray* ret = [NSMutableArray array];
-    for(NSString* key in [node allKeys])
+    if([fileFields count] == [fields count])return fileFields;
+    
+    NSMutableArray* ret = [NSMutableArray arrayWithCapacity:[fields count]];
+    NSUInteger next = 0;
+    for(id field in fields)
     {
-        id obj = node[key];
+        id name = ([field isKindOfClass:[PDFDictionary class]]?[field objectForKey:PDFNameT]:nil);
+        id match = [NSNull null];
         
-        if([obj isKindOfClass:[NSMutableArray class]])
+        for(NSUInteger j = next ; j < [fileFields count] ; j++)
         {
-            [ret addObjectsFromArray:obj];
-        }
-        else
-        {
-            [ret addObjectsFromArray:[self formsDescendingFromTreeNode:obj]];
+            id fileField = [self resolvedFileObject:fileFields[j]];
+            if([fileField isKindOfClass:[PDFDictionary class]] == NO)continue;
+            id fileName = [fileField objectForKey:PDFNameT];
+            if(fileName == name || [fileName isEqual:name])
+            {
+                match = fileFields[j];
+                next = j+1;
+                break;
+            }
         }
+        
+        [ret addObject:match];
     }
+    
     return ret;
 }
 
-
--(void)populateNameTreeNode:(NSMutableDictionary*)node WithComponents:(NSArray*)components Final:(PDFForm*)final
+-(id)resolvedFileObject:(id)object
 {
-    NSString* base = components[0];
-    
-    if([components count] == 1)
+    // Indirect references parsed from the file are generic PDFObject instances whose representation is the code of the referenced object.
+    if([object isMemberOfClass:[PDFObject class]] && [object objectNumber] > 0)
     {
-        NSMutableArray* arr = node[base];
-        if(arr == nil)
-        {
-            arr = [NSMutableArray arrayWithObject:final];
-            node[base] = arr;
-        }
-        else
-        {
-            [arr addObject:final];
-        }
-        return;
+        NSString* code = [object pdfFileRepresentation];
+        return (code?[PDFObject createWithPDFRepresentation:code Document:_document]:nil);
     }
     
-    NSMutableDictionary* dict  = node[base];
-    if(dict == nil)
-    {
-        dict = [NSMutableDictionary dictionary];
-        node[base] = dict;
-    }
-   
-    [self populateNameTreeNode:dict WithComponents:[components subarrayWithRange:NSMakeRange(1, [components count]-1)] Final:final];
+    return object;
 }
 
 
@@ -206,119 +275,184 @@
 -(void)executeJS:(NSString*)js
 {
     [self setDocumentValue:@"" ForKey:@"SubmitForm"];
-    
-    for(PDFForm* form in [self allForms])
-    {
-        if(form.value)
-        {
-            NSString* set = [[form.value componentsSeparatedByCharactersInSet:[NSCharacterSet newlineCharacterSet]] componentsJoinedByString:@" "];
-            if([set isEqualToString:@" "])set = @"";
-            
-            [self setDocumentValue:set ForKey:[NSString stringWithFormat:@"Field(%@).%@",form.name,@"value"]];
-        }
-        
-        
-        if([form.options count])
-        {
-            NSString* set = [form.options componentsJoinedByString:[self delimeter]];
-            
-            [self setDocumentValue:set ForKey:[NSString stringWithFormat:@"Field(%@).%@",form.name,@"items"]];
-        }
-    }
-    
-    if([_jsParser stringByEvaluatingJavaScriptFromString:js])
-    {
-        for(PDFForm* form in [self allForms])
-        {
-            NSString* val = [self getDocumentValueForKey:[NSString stringWithFormat:@"Field(%@).%@",form.name,@"value"]];
-            if([[[form actions] allValues] count] > 0)
-            {
-                NSString* opt = [self getDocumentValueForKey:[NSString stringWithFormat:@"Field(%@).%@",form.name,@"items"]];
-                if([opt length] > 0)
-                {
-                    form.options = [opt componentsSeparatedByString:[self delimeter]];
-                }
-                else
-                {
-                    form.options = nil;
-                }
-            }
-            
-            if([form.value isEqualToString:val] == NO && (form.value!=nil || val!=nil))
-            {
-                form.value = val;
-                form.modified = YES;
-            }
-        }
-    }
+    [self.scriptEngine evaluateScript:js WithForms:self];
 }
 
 -(void)setDocumentValue:(NSString*)value ForKey:(NSString*)key
 {
-    NSString* ckey = [key stringByReplacingOccurrencesOfString:@"\"" withString:@"\\\""];
-    NSString* cvalue = [value stringByReplacingOccurrencesOfString:@"\"" withString:@"\\\""];
-    [_jsParser stringByEvaluatingJavaScriptFromString:[NSString stringWithFormat:@"setDocumentKeyValue(\"%@\",\"%@\")",ckey ,cvalue]];
+    if(value)_documentValues[key] = value;
+    else [_documentValues removeObjectForKey:key];
 }
 
 -(NSString*)getDocumentValueForKey:(NSString*)key
 {
-    NSString* ckey = [key stringByReplacingOccurrencesOfString:@"\"" withString:@"\\\""];
-    NSString* ret = [_jsParser stringByEvaluatingJavaScriptFromString:[NSString stringWithFormat:@"getDocumentValueForKey(\"%@\")",ckey]];
+    NSString* ret = _documentValues[key];
     if([ret length] == 0)return nil;
     return ret;
 }
 
 -(void)initializeJS
 {
-   
-    for(PDFForm* form in self)
+    PDFTraceBegin(span);
+    for(PDFForm* form in [self formsWithType:PDFFormTypeChoice])
     {
-        [self setDocumentValue:[NSString stringWithFormat:@"%@",form.name] ForKey:[NSString stringWithFormat:@"Field(%@).%@",form.name,@"name"]];
-        
-        if([form.options count] && [[form.actions allValues] count]==0)
+        [(form.actions)[@"E"] execute];
+    }
+    PDFTraceEnd(span, @"PDFFormContainer.initializeJS");
+}
+
+#pragma mark - Value Setting
+
+
+-(void)setValue:(NSString*)val ForFormWithName:(NSString*)name
+{
+    BOOL changed = NO;
+    for(PDFForm* form in [self formsWithName:name])
+    {
+        if((([form.value isEqualToString:val] == NO) && (form.value!=nil || val!=nil)))
         {
-            NSString* set = @"";
-            for(NSString* comp in form.options)set = [set stringByAppendingString:[NSString stringWithFormat:@"%@%@",comp,[self delimeter]]];
-            set = [set substringToIndex:[set length]-[[self delimeter] length]];
-            [self setDocumentValue:set ForKey:[NSString stringWithFormat:@"Field(%@).%@",form.name,@"items"]];
+            form.value = val;
+            changed = YES;
         }
     }
     
-    for(PDFForm* form in [self formsWithType:PDFFormTypeChoice])
+    if(changed)[self calculateFormsDependingOnFormWithName:name];
+}
+
+#pragma mark - Calculation
+
+-(void)loadCalculationOrder:(NSArray*)co
+{
+    NSMutableArray* candidates = [NSMutableArray array];
+    for(PDFDictionary* field in co)
     {
-        [(form.actions)[@"E"] execute];
+        if([field isKindOfClass:[PDFDictionary class]] == NO)continue;
+        NSString* name = [self qualifiedNameOfFieldDictionary:field];
+        if(name)[candidates addObject:name];
     }
+    
+    // Calculated fields missing from the calculation order run after those listed, in document order.
+    for(PDFForm* form in _allForms)
+    {
+        if((form.actions)[PDFNameC] && form.name)[candidates addObject:form.name];
+    }
+    
+    [self loadCalculationsWithNames:candidates];
 }
 
--(void)loadJS
+
+-(void)loadCalculationsWithNames:(NSArray*)candidates
 {
-    _jsParser = [[UIWebView alloc] init];
-    _jsParser.delegate = self;
-    NSString* path = [[NSBundle mainBundle] pathForResource:@"document" ofType:@"html"];
-    NSURL* address = [NSURL fileURLWithPath:path];
-    NSURLRequest* request = [NSURLRequest requestWithURL:address];
-    [_jsParser loadRequest:request];
+    NSMutableArray* order = [NSMutableArray array];
+    NSMutableArray* actions = [NSMutableArray array];
+    NSMutableSet* names = [NSMutableSet set];
+    
+    for(NSString* name in candidates)
+    {
+        if([names containsObject:name])continue;
+        PDFFormAction* action = nil;
+        for(PDFForm* form in [self formsWithName:name])
+        {
+            if((action = (form.actions)[PDFNameC]) != nil && [action.string length])break;
+            action = nil;
+        }
+        if(action == nil)continue;
+        
+        [names addObject:name];
+        [order addObject:name];
+        [actions addObject:action];
+    }
+    
+    _calculationOrder = [NSArray arrayWithArray:order];
+    _calculationActions = [NSArray arrayWithArray:actions];
+    _calculationReads = [NSMutableArray array];
+    for(NSUInteger i = 0 ; i < [order count] ; i++)[_calculationReads addObject:[NSSet set]];
+    _calculationDependents = [[NSMutableDictionary alloc] init];
+    _unrecordedCalculations = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(0, [order count])];
 }
 
-#pragma mark - UIWebViewDidFinishLoading
 
--(void)webViewDidFinishLoad:(UIWebView *)webView
+-(NSString*)qualifiedNameOfFieldDictionary:(PDFDictionary*)field
 {
-    [self initializeJS];
+    NSMutableArray* components = [NSMutableArray array];
+    PDFDictionary* iter = field;
+    while(iter != nil && [components count] < PDFFormContainerMaximumFieldDepth)
+    {
+        NSString* partialName = [iter objectForKey:PDFNameT];
+        if([partialName isKindOfClass:[NSString class]])[components insertObject:partialName atIndex:0];
+        iter = [iter objectForKey:PDFNameParent];
+    }
+    
+    return ([components count]?[components componentsJoinedByString:@"."]:nil);
 }
 
-#pragma mark - Value Setting
 
+// A change made while calculations are running only schedules the calculations that depend on it, so every change is handled by the outermost call. Each calculation runs at most once per change, which keeps the order of the document authoritative and ends cycles.
 
--(void)setValue:(NSString*)val ForFormWithName:(NSString*)name
+-(void)calculateFormsDependingOnFormWithName:(NSString*)name
 {
-    for(PDFForm* form in [self formsWithName:name])
+    if(_pendingCalculations != nil)
     {
-        if((([form.value isEqualToString:val] == NO) && (form.value!=nil || val!=nil)))
-        {
-            form.value = val;
-        }
+        [self scheduleCalculationsDependingOnFormWithName:name];
+        return;
+    }
+    
+    if(self.scriptEngine == nil || [_calculationOrder count] == 0)return;
+    
+    PDFTraceBegin(span);
+    _pendingCalculations = [NSMutableIndexSet indexSet];
+    _completedCalculations = [NSMutableIndexSet indexSet];
+    [self scheduleCalculationsDependingOnFormWithName:name];
+    
+    NSUInteger index;
+    while((index = [_pendingCalculations firstIndex]) != NSNotFound)
+    {
+        [_pendingCalculations removeIndex:index];
+        [_completedCalculations addIndex:index];
+        [self runCalculationAtIndex:index];
+    }
+    
+    _pendingCalculations = nil;
+    _completedCalculations = nil;
+    PDFTraceEnd(span, @"PDFFormContainer.calculate");
+}
+
+
+-(void)scheduleCalculationsDependingOnFormWithName:(NSString*)name
+{
+    NSMutableIndexSet* indexes = [NSMutableIndexSet indexSet];
+    [indexes addIndexes:_unrecordedCalculations];
+    if(_calculationDependents[name])[indexes addIndexes:_calculationDependents[name]];
+    [indexes removeIndexes:_completedCalculations];
+    [_pendingCalculations addIndexes:indexes];
+}
+
+
+-(void)runCalculationAtIndex:(NSUInteger)index
+{
+    NSString* name = _calculationOrder[index];
+    PDFFormAction* action = _calculationActions[index];
+    
+    [self setDocumentValue:[self valueForFormWithName:name] ForKey:@"EventValue"];
+    
+    _recordedReads = [NSMutableSet set];
+    BOOL completed = [self.scriptEngine evaluateScript:action.string WithForms:self];
+    NSMutableSet* reads = _recordedReads;
+    _recordedReads = nil;
+    
+    // The reads of the latest run replace the previous ones, since a script may read different fields depending on their values.
+    [reads removeObject:name];
+    for(NSString* read in _calculationReads[index])[_calculationDependents[read] removeIndex:index];
+    for(NSString* read in reads)
+    {
+        if(_calculationDependents[read] == nil)_calculationDependents[read] = [NSMutableIndexSet indexSet];
+        [_calculationDependents[read] addIndex:index];
     }
+    _calculationReads[index] = [NSSet setWithSet:reads];
+    [_unrecordedCalculations removeIndex:index];
+    
+    // The result is the value the script left in event.value.
+    if(completed)[self setValue:[self getDocumentValueForKey:@"EventValue"] ForFormWithName:name];
 }
 
 #pragma mark - formXML
@@ -326,33 +460,96 @@
 -(NSString*)formXML
 {
     NSMutableString* ret = [NSMutableString stringWithString:@"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r<fields>"];
-    [ret appendString:[self formXMLForFormsWithRootNode:_nameTree]];
+    [self appendFormXMLForFormsWithName:nil ToString:ret];
     [ret appendString:@"\r</fields>"];
-    return [[[ret stringByReplacingOccurrencesOfString:@"&" withString:@"&amp;"] stringByReplacingOccurrencesOfString:@"&amp;#60;" withString:@"&#60;"] stringByReplacingOccurrencesOfString:@"&amp;#62;" withString:@"&#62;"];
+    return ret;
 }
 
 
--(NSString*)formXMLForFormsWithRootNode:(NSDictionary*)node
+// Appends text with '&' written as '&amp;' and, for values, '<' and '>' written as character references, in a single pass.
+
+static void PDFFormContainerAppendEscaped(NSMutableString* xml, NSString* text, BOOL isValue)
 {
-    NSMutableString* ret = [NSMutableString string];
-    for(NSString* key in [node allKeys])
+    static NSCharacterSet* valueSpecials = nil;
+    static NSCharacterSet* nameSpecials = nil;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        valueSpecials = [NSCharacterSet characterSetWithCharactersInString:@"&<>"];
+        nameSpecials = [NSCharacterSet characterSetWithCharactersInString:@"&"];
+    });
+    
+    NSCharacterSet* specials = (isValue?valueSpecials:nameSpecials);
+    NSUInteger length = [text length];
+    NSUInteger start = 0;
+    
+    while(start < length)
     {
-        id obj = node[key];
-        if([obj isKindOfClass:[NSMutableArray class]])
+        NSRange special = [text rangeOfCharacterFromSet:specials options:0 range:NSMakeRange(start, length-start)];
+        if(special.location == NSNotFound)
         {
-            PDFForm* form = (PDFForm*)[obj lastObject];
-            if([form.value length])[ret appendFormat:@"\r<%@>%@</%@>",key,[PDFUtility urlEncodeStringXML: form.value],key];
+            [xml appendString:(start?[text substringFromIndex:start]:text)];
+            break;
         }
-        else
+        
+        if(special.location > start)[xml appendString:[text substringWithRange:NSMakeRange(start, special.location-start)]];
+        switch([text characterAtIndex:special.location])
         {
-            NSString* val = [self formXMLForFormsWithRootNode:obj];
-            if([val length])[ret appendFormat:@"\r<%@>%@</%@>",key,val,key];
+            case '&': [xml appendString:@"&amp;"]; break;
+            case '<': [xml appendString:@"&#60;"]; break;
+            default: [xml appendString:@"&#62;"]; break;
         }
+        start = NSMaxRange(special);
+    }
+}
+
+
+// Returns NO, leaving xml unchanged, if none of the forms below name has a value.
+
+-(BOOL)appendFormXMLForFormsWithName:(NSString*)name ToString:(NSMutableString*)xml
+{
+    BOOL ret = NO;
+    for(NSString* key in [_nameTree childComponentsOfName:name])
+    {
+        NSString* fullName = (name?[NSString stringWithFormat:@"%@.%@",name,key]:key);
+        NSUInteger mark = [xml length];
+        
+        [xml appendString:@"\r<"];
+        PDFFormContainerAppendEscaped(xml, key, NO);
+        [xml appendString:@">"];
+        
+        BOOL written = NO;
+        if([[_nameTree childComponentsOfName:fullName] count] == 0)
+        {
+            PDFForm* form = (PDFForm*)[[_nameTree formsWithName:fullName] lastObject];
+            if([form.value length])
+            {
+                PDFFormContainerAppendEscaped(xml, form.value, YES);
+                written = YES;
+            }
+        }
+        else written = [self appendFormXMLForFormsWithName:fullName ToString:xml];
+        
+        if(written == NO)
+        {
+            [xml deleteCharactersInRange:NSMakeRange(mark, [xml length]-mark)];
+            continue;
+        }
+        
+        [xml appendString:@"</"];
+        PDFFormContainerAppendEscaped(xml, key, NO);
+        [xml appendString:@">"];
+        ret = YES;
     }
     return ret;
 }
 
 
+-(NSArray*)childComponentsOfName:(NSString*)name
+{
+    return [_nameTree childComponentsOfName:name];
+}
+
+
 #pragma mark - NSFastEnumeration
 
 
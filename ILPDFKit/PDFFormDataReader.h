@@ -0,0 +1,65 @@
+#import <Foundation/Foundation.h>
+
+@class PDFFormContainer;
+
+
+/** The PDFFormDataReader class imports form values from XFDF or FDF data.
+ XFDF is read with an event driven parser and FDF is scanned token by token. Each value is applied to the forms as soon as its field has been read, through setValue:ForFormWithName:, so no tree of the imported data is built and the calculations that depend on a field are run as usual.
+
+     PDFFormDataReader* reader = [[PDFFormDataReader alloc] initWithForms:document.forms];
+     if([reader readXFDFFromStream:[NSInputStream inputStreamWithFileAtPath:path]])
+     {
+        NSLog(@"%u values imported",(unsigned int)reader.numberOfValuesApplied);
+     }
+
+ Values for fields that the document does not have are ignored. Only the first value of a field with several values, such as a list box with several selections, is applied.
+ */
+@interface PDFFormDataReader : NSObject
+
+
+/** The forms the values are applied to.
+ */
+@property(nonatomic,readonly) PDFFormContainer* forms;
+
+/** The number of values applied to fields of the document by the last read.
+ */
+@property(nonatomic,readonly) NSUInteger numberOfValuesApplied;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Creating a PDFFormDataReader
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Creates a new instance of PDFFormDataReader.
+
+ @param forms The forms to apply values to.
+ @return A new PDFFormDataReader.
+ */
+-(id)initWithForms:(PDFFormContainer*)forms;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Reading
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Reads an XFDF document.
+
+ @param stream The stream to read. It is opened and closed by the parser.
+ @return YES if successful, NO if the document is not well formed. Values read before an error remain applied.
+ @discussion The name of a field is the dot separated path of the field elements that contain it, so both nested elements and fully qualified names are accepted.
+ */
+-(BOOL)readXFDFFromStream:(NSInputStream*)stream;
+
+
+/** Reads an FDF file.
+
+ @param data The contents of the file. A file mapped with NSDataReadingMappedAlways is read without being loaded into memory.
+ @return YES if successful, NO if the 'Fields' array cannot be found or is malformed. Values read before an error remain applied.
+ @discussion Field dictionaries must be written directly in the 'Fields' and 'Kids' arrays. Button values are read from names and other values from strings.
+ */
+-(BOOL)readFDFFromData:(NSData*)data;
+
+
+@end
@@ -0,0 +1,247 @@
+#import "PDFFormDataReader.h"
+#import "PDFFormContainer.h"
+#import "PDFLexer.h"
+#import "PDFUtility.h"
+
+// Fields nested deeper than this are treated as malformed rather than risking the stack.
+#define PDFFormDataReaderMaximumDepth 256
+
+
+@interface PDFFormDataReader()<NSXMLParserDelegate>
+    -(void)applyValue:(NSString*)value ToFieldWithName:(NSString*)name;
+    -(BOOL)readFieldsWithParentName:(NSString*)parentName Depth:(NSUInteger)depth;
+    -(BOOL)readFieldWithParentName:(NSString*)parentName Depth:(NSUInteger)depth;
+    -(NSString*)textOfToken:(PDFToken)token;
+    -(BOOL)token:(PDFToken)token IsName:(const char*)name;
+@end
+
+
+@implementation PDFFormDataReader
+{
+    PDFLexer* _lexer;
+    NSMutableArray* _names;
+    NSMutableString* _value;
+    BOOL _fieldHasValue;
+}
+
+
+-(id)initWithForms:(PDFFormContainer*)forms
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _forms = forms;
+    }
+    return self;
+}
+
+
+-(BOOL)readXFDFFromStream:(NSInputStream*)stream
+{
+    _numberOfValuesApplied = 0;
+    _names = [NSMutableArray array];
+    _value = nil;
+
+    NSXMLParser* parser = [[NSXMLParser alloc] initWithStream:stream];
+    parser.delegate = self;
+    BOOL ret = [parser parse];
+
+    _names = nil;
+    _value = nil;
+    return ret;
+}
+
+
+-(BOOL)readFDFFromData:(NSData*)data
+{
+    _numberOfValuesApplied = 0;
+    _lexer = [[PDFLexer alloc] initWithData:data];
+
+    BOOL ret = NO;
+    while(YES)
+    {
+        PDFToken token = [_lexer nextToken];
+        if(token.type == PDFTokenTypeEnd)break;
+        if(token.type != PDFTokenTypeName || [self token:token IsName:"Fields"] == NO)continue;
+
+        if([_lexer nextToken].type == PDFTokenTypeArrayOpen)ret = [self readFieldsWithParentName:nil Depth:0];
+        break;
+    }
+
+    _lexer = nil;
+    return ret;
+}
+
+
+#pragma mark - Hidden
+
+
+-(void)applyValue:(NSString*)value ToFieldWithName:(NSString*)name
+{
+    if([name length] == 0 || [[_forms formsWithName:name] count] == 0)return;
+    [_forms setValue:value ForFormWithName:name];
+    _numberOfValuesApplied++;
+}
+
+
+// Reads the field dictionaries of an array whose opening bracket has just been read, up to and including its closing bracket.
+
+-(BOOL)readFieldsWithParentName:(NSString*)parentName Depth:(NSUInteger)depth
+{
+    while(YES)
+    {
+        PDFToken token = [_lexer nextToken];
+        if(token.type == PDFTokenTypeArrayClose)return YES;
+        if(token.type == PDFTokenTypeEnd)return NO;
+
+        if(token.type == PDFTokenTypeDictionaryOpen)
+        {
+            if([self readFieldWithParentName:parentName Depth:depth] == NO)return NO;
+            continue;
+        }
+
+        // Anything else, such as a reference to a field stored elsewhere, is skipped.
+        _lexer.position = token.offset;
+        if([_lexer skipObject].location == NSNotFound)return NO;
+    }
+}
+
+
+// The partial name may follow the value or the kids, so the kids are read once the whole dictionary has been scanned.
+
+-(BOOL)readFieldWithParentName:(NSString*)parentName Depth:(NSUInteger)depth
+{
+    NSString* partialName = nil;
+    NSString* value = nil;
+    BOOL hasValue = NO;
+    NSUInteger kidsPosition = NSNotFound;
+
+    while(YES)
+    {
+        PDFToken key = [_lexer nextToken];
+        if(key.type == PDFTokenTypeDictionaryClose)break;
+        if(key.type == PDFTokenTypeEnd)return NO;
+        if(key.type != PDFTokenTypeName)continue;
+
+        NSUInteger valuePosition = _lexer.position;
+        PDFToken valueToken = [_lexer peekToken];
+
+        if([self token:key IsName:"T"])partialName = [self textOfToken:valueToken];
+        else if([self token:key IsName:"V"])
+        {
+            value = [self textOfToken:valueToken];
+            hasValue = (value != nil);
+        }
+        else if([self token:key IsName:"Kids"] && valueToken.type == PDFTokenTypeArrayOpen)kidsPosition = valueToken.offset;
+
+        _lexer.position = valuePosition;
+        if([_lexer skipObject].location == NSNotFound)return NO;
+    }
+
+    NSString* name = partialName;
+    if([parentName length])name = ([partialName length]?[NSString stringWithFormat:@"%@.%@",parentName,partialName]:parentName);
+
+    if(hasValue)[self applyValue:value ToFieldWithName:name];
+
+    if(kidsPosition != NSNotFound)
+    {
+        if(depth >= PDFFormDataReaderMaximumDepth)return NO;
+
+        NSUInteger end = _lexer.position;
+        _lexer.position = kidsPosition;
+        [_lexer nextToken];
+        if([self readFieldsWithParentName:name Depth:depth+1] == NO)return NO;
+        _lexer.position = end;
+    }
+
+    return YES;
+}
+
+
+// The text of a string or name. For an array, such as the selections of a list box, the text of its first element.
+
+-(NSString*)textOfToken:(PDFToken)token
+{
+    const unsigned char* bytes = _lexer.bytes;
+    switch(token.type)
+    {
+        case PDFTokenTypeString:
+        {
+            BOOL terminated = (token.length >= 2 && bytes[token.offset+token.length-1] == ')');
+            return [PDFUtility stringWithPDFStringBytes:bytes+token.offset+1 Length:token.length-1-terminated Hexadecimal:NO];
+        }
+        case PDFTokenTypeHexString:
+        {
+            BOOL terminated = (token.length >= 2 && bytes[token.offset+token.length-1] == '>');
+            return [PDFUtility stringWithPDFStringBytes:bytes+token.offset+1 Length:token.length-1-terminated Hexadecimal:YES];
+        }
+        case PDFTokenTypeName:
+            return [PDFUtility stringWithPDFNameBytes:bytes+token.offset+1 Length:token.length-1];
+        case PDFTokenTypeArrayOpen:
+        {
+            NSUInteger position = _lexer.position;
+            _lexer.position = token.offset+token.length;
+            PDFToken first = [_lexer nextToken];
+            NSString* ret = (first.type == PDFTokenTypeArrayOpen?nil:[self textOfToken:first]);
+            _lexer.position = position;
+            return ret;
+        }
+        default:
+            return nil;
+    }
+}
+
+
+-(BOOL)token:(PDFToken)token IsName:(const char*)name
+{
+    size_t length = strlen(name);
+    return (token.type == PDFTokenTypeName && token.length == length+1 && memcmp(_lexer.bytes+token.offset+1, name, length) == 0);
+}
+
+
+#pragma mark - NSXMLParserDelegate
+
+
+-(void)parser:(NSXMLParser*)parser didStartElement:(NSString*)elementName namespaceURI:(NSString*)namespaceURI qualifiedName:(NSString*)qName attributes:(NSDictionary*)attributeDict
+{
+    if([elementName isEqualToString:@"field"])
+    {
+        [_names addObject:(attributeDict[@"name"]?attributeDict[@"name"]:@"")];
+        _fieldHasValue = NO;
+    }
+    else if([elementName isEqualToString:@"value"] && [_names count] && _fieldHasValue == NO)
+    {
+        _value = [NSMutableString string];
+    }
+}
+
+
+-(void)parser:(NSXMLParser*)parser foundCharacters:(NSString*)string
+{
+    [_value appendString:string];
+}
+
+
+-(void)parser:(NSXMLParser*)parser didEndElement:(NSString*)elementName namespaceURI:(NSString*)namespaceURI qualifiedName:(NSString*)qName
+{
+    if([elementName isEqualToString:@"field"])
+    {
+        [_names removeLastObject];
+        _fieldHasValue = NO;
+    }
+    else if([elementName isEqualToString:@"value"] && _value != nil)
+    {
+        NSMutableArray* components = [NSMutableArray arrayWithCapacity:[_names count]];
+        for(NSString* component in _names)
+        {
+            if([component length])[components addObject:component];
+        }
+
+        [self applyValue:[NSString stringWithString:_value] ToFieldWithName:[components componentsJoinedByString:@"."]];
+        _value = nil;
+        _fieldHasValue = YES;
+    }
+}
+
+
+@end
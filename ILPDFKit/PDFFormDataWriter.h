@@ -0,0 +1,61 @@
+#import <Foundation/Foundation.h>
+
+@class PDFFormContainer;
+
+
+/** The PDFFormDataWriter class exports the values of a document's forms as XFDF or FDF.
+ The field hierarchy is walked in document order and written as it is walked, through a fixed size buffer, so no representation of the whole export is built in memory. Text is escaped in the same pass that writes it.
+
+     NSOutputStream* stream = [NSOutputStream outputStreamToFileAtPath:path append:NO];
+     [stream open];
+     PDFFormDataWriter* writer = [[PDFFormDataWriter alloc] initWithOutputStream:stream];
+     BOOL written = [writer writeXFDFForForms:document.forms];
+     [stream close];
+
+ Each terminal field is written once, with the value shared by its forms. Fields without a value are written without one, so importing the data leaves them unchanged. PDFFormDataReader imports both formats.
+ */
+@interface PDFFormDataWriter : NSObject
+
+
+/** The destination stream.
+ */
+@property(nonatomic,readonly) NSOutputStream* stream;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Creating a PDFFormDataWriter
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Creates a new instance of PDFFormDataWriter.
+
+ @param stream The destination stream. It is opened if needed, and is left open.
+ @return A new PDFFormDataWriter.
+ */
+-(id)initWithOutputStream:(NSOutputStream*)stream;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Writing
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Writes the values of forms as an XFDF document.
+
+ @param forms The forms to export.
+ @return YES if successful, NO if the stream failed.
+ @discussion Nested fields are written as nested field elements named by their partial names. The document is UTF-8 encoded.
+ */
+-(BOOL)writeXFDFForForms:(PDFFormContainer*)forms;
+
+
+/** Writes the values of forms as an FDF file.
+
+ @param forms The forms to export.
+ @return YES if successful, NO if the stream failed.
+ @discussion Nested fields are written as field dictionaries with 'Kids'. Button values are written as names and other values as strings.
+ */
+-(BOOL)writeFDFForForms:(PDFFormContainer*)forms;
+
+
+@end
@@ -0,0 +1,225 @@
+#import "PDFFormDataWriter.h"
+#import "PDFFormContainer.h"
+#import "PDFForm.h"
+#import "PDFUtility.h"
+
+// Output is collected up to this many bytes before it is written to the stream.
+#define PDFFormDataWriterBufferSize 65536
+
+
+@interface PDFFormDataWriter()
+    -(void)appendBytes:(const void*)bytes Length:(NSUInteger)length;
+    -(void)appendString:(NSString*)str;
+    -(void)appendEscapedXML:(NSString*)text;
+    -(BOOL)flush;
+    -(void)writeXFDFFieldsWithName:(NSString*)name Forms:(PDFFormContainer*)forms;
+    -(void)writeFDFFieldsWithName:(NSString*)name Forms:(PDFFormContainer*)forms;
+@end
+
+
+@implementation PDFFormDataWriter
+{
+    NSMutableData* _buffer;
+    NSStringEncoding _encoding;
+    BOOL _failed;
+}
+
+
+-(id)initWithOutputStream:(NSOutputStream*)stream
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _stream = stream;
+        _buffer = [[NSMutableData alloc] initWithCapacity:PDFFormDataWriterBufferSize];
+    }
+    return self;
+}
+
+
+-(BOOL)writeXFDFForForms:(PDFFormContainer*)forms
+{
+    if([_stream streamStatus] == NSStreamStatusNotOpen)[_stream open];
+    _failed = NO;
+    _encoding = NSUTF8StringEncoding;
+
+    [self appendString:@"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<xfdf xmlns=\"http://ns.adobe.com/xfdf/\" xml:space=\"preserve\">\n<fields>\n"];
+    [self writeXFDFFieldsWithName:nil Forms:forms];
+    [self appendString:@"</fields>\n</xfdf>\n"];
+
+    return [self flush];
+}
+
+
+-(BOOL)writeFDFForForms:(PDFFormContainer*)forms
+{
+    if([_stream streamStatus] == NSStreamStatusNotOpen)[_stream open];
+    _failed = NO;
+    _encoding = NSISOLatin1StringEncoding;
+
+    // The comment after the header holds bytes above 127, marking the file as binary.
+    const unsigned char header[] = "%FDF-1.2\n%\xE2\xE3\xCF\xD3\n1 0 obj\n<< /FDF << /Fields [\n";
+    [self appendBytes:header Length:sizeof(header)-1];
+    [self writeFDFFieldsWithName:nil Forms:forms];
+    [self appendString:@"] >> >>\nendobj\ntrailer\n<< /Root 1 0 R >>\n%%EOF\n"];
+
+    return [self flush];
+}
+
+
+#pragma mark - Hidden
+
+
+-(void)writeXFDFFieldsWithName:(NSString*)name Forms:(PDFFormContainer*)forms
+{
+    for(NSString* key in [forms childComponentsOfName:name])
+    {
+        NSString* fullName = (name?[NSString stringWithFormat:@"%@.%@",name,key]:key);
+
+        [self appendString:@"<field name=\""];
+        [self appendEscapedXML:key];
+
+        if([[forms childComponentsOfName:fullName] count])
+        {
+            [self appendString:@"\">\n"];
+            [self writeXFDFFieldsWithName:fullName Forms:forms];
+            [self appendString:@"</field>\n"];
+            continue;
+        }
+
+        NSString* value = [(PDFForm*)[[forms formsWithName:fullName] lastObject] value];
+        if(value == nil)
+        {
+            [self appendString:@"\"/>\n"];
+            continue;
+        }
+
+        [self appendString:@"\"><value>"];
+        [self appendEscapedXML:value];
+        [self appendString:@"</value></field>\n"];
+    }
+}
+
+
+-(void)writeFDFFieldsWithName:(NSString*)name Forms:(PDFFormContainer*)forms
+{
+    for(NSString* key in [forms childComponentsOfName:name])
+    {
+        NSString* fullName = (name?[NSString stringWithFormat:@"%@.%@",name,key]:key);
+
+        [self appendString:@"<< /T "];
+        [self appendString:[PDFUtility pdfStringFromString:key]];
+
+        if([[forms childComponentsOfName:fullName] count])
+        {
+            [self appendString:@" /Kids [\n"];
+            [self writeFDFFieldsWithName:fullName Forms:forms];
+            [self appendString:@"] >>\n"];
+            continue;
+        }
+
+        PDFForm* form = (PDFForm*)[[forms formsWithName:fullName] lastObject];
+        if(form.value != nil)
+        {
+            [self appendString:@" /V "];
+            [self appendString:(form.formType == PDFFormTypeButton?[PDFUtility pdfNameFromString:form.value]:[PDFUtility pdfStringFromString:form.value])];
+        }
+        [self appendString:@" >>\n"];
+    }
+}
+
+
+-(void)appendBytes:(const void*)bytes Length:(NSUInteger)length
+{
+    if(_failed)return;
+    if([_buffer length]+length > PDFFormDataWriterBufferSize && [self flush] == NO)return;
+
+    if(length >= PDFFormDataWriterBufferSize)
+    {
+        // Large pieces bypass the buffer.
+        NSUInteger written = 0;
+        while(written < length)
+        {
+            NSInteger count = [_stream write:(const uint8_t*)bytes+written maxLength:length-written];
+            if(count <= 0)
+            {
+                _failed = YES;
+                return;
+            }
+            written += count;
+        }
+        return;
+    }
+
+    [_buffer appendBytes:bytes length:length];
+}
+
+
+// XFDF is written as UTF-8. FDF is written as ISO Latin 1, the encoding of the literal strings made by PDFUtility.
+
+-(void)appendString:(NSString*)str
+{
+    if(_encoding == NSUTF8StringEncoding)
+    {
+        const char* utf8 = [str UTF8String];
+        if(utf8)[self appendBytes:utf8 Length:strlen(utf8)];
+        return;
+    }
+
+    NSData* data = [str dataUsingEncoding:_encoding allowLossyConversion:YES];
+    [self appendBytes:[data bytes] Length:[data length]];
+}
+
+
+// Markup characters are written as entity references and control characters that XML cannot represent are dropped. Carriage returns are written as character references so that parsers do not normalize them.
+
+-(void)appendEscapedXML:(NSString*)text
+{
+    const unsigned char* c = (const unsigned char*)[text UTF8String];
+    if(c == NULL)return;
+
+    NSUInteger run = 0;
+    NSUInteger i = 0;
+    for( ; c[i] != 0 ; i++)
+    {
+        const char* replacement = NULL;
+        switch(c[i])
+        {
+            case '&': replacement = "&amp;"; break;
+            case '<': replacement = "&lt;"; break;
+            case '>': replacement = "&gt;"; break;
+            case '"': replacement = "&quot;"; break;
+            case '\'': replacement = "&apos;"; break;
+            case '\r': replacement = "&#13;"; break;
+            case '\t': case '\n': break;
+            default: if(c[i] < 0x20)replacement = ""; break;
+        }
+        if(replacement == NULL)continue;
+
+        if(i > run)[self appendBytes:c+run Length:i-run];
+        [self appendBytes:replacement Length:strlen(replacement)];
+        run = i+1;
+    }
+    if(i > run)[self appendBytes:c+run Length:i-run];
+}
+
+
+-(BOOL)flush
+{
+    const uint8_t* bytes = [_buffer bytes];
+    NSUInteger length = [_buffer length];
+    NSUInteger written = 0;
+
+    while(_failed == NO && written < length)
+    {
+        NSInteger count = [_stream write:bytes+written maxLength:length-written];
+        if(count <= 0)_failed = YES;
+        else written += count;
+    }
+
+    [_buffer setLength:0];
+    return (_failed == NO);
+}
+
+
+@end
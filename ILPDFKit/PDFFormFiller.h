@@ -0,0 +1,93 @@
+#import <Foundation/Foundation.h>
+
+@class PDFDocument;
+
+
+/** The PDFFormFiller class fills a template document with many sets of form values.
+ Filling a template with a new PDFDocument per record parses the file, builds the forms and locates every field object again for each record. PDFFormFiller does that work once. When it is created, it reads the field objects of the template and splits each one around its value, so the code of a filled field is built by concatenation. Each filled document is the unchanged template followed by a single incremental update holding the fields set by the record.
+
+     PDFFormFiller* filler = [[PDFFormFiller alloc] initWithDocument:[[PDFDocument alloc] initWithPath:templatePath]];
+     NSIndexSet* failed = [filler writeDocumentsWithRecords:records PathForRecord:^NSString*(NSUInteger index) {
+         return [outputDirectory stringByAppendingPathComponent:[NSString stringWithFormat:@"%u.pdf",(unsigned int)index]];
+     }];
+
+ A record is a dictionary whose keys are fully qualified field names and whose values are NSString objects, or NSNull to clear the field. Fields not named by a record keep the value they have in the template file. Form scripts are not run and the template itself is never modified.
+
+ Records are written concurrently. At most maximumConcurrentRecords records are in progress at any time, and the template bytes are shared by all of them, so memory use does not grow with the number of records.
+ */
+@interface PDFFormFiller : NSObject
+
+
+/** The template document.
+ */
+@property(nonatomic,readonly) PDFDocument* document;
+
+/** The maximum number of records written at the same time. The default is the number of active processors.
+ */
+@property(nonatomic) NSUInteger maximumConcurrentRecords;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Creating a PDFFormFiller
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Creates a new instance of PDFFormFiller.
+
+ @param document The template document. Unsaved changes to its forms are not part of the template.
+ @return A new PDFFormFiller, or nil if the template cannot be filled, for example because its cross-reference information cannot be read.
+ */
+-(id)initWithDocument:(PDFDocument*)document;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Filling a Single Record
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Writes the template filled with a record to a file.
+
+ @param values The record.
+ @param path The destination path.
+ @return YES if successful, NO if failed. The record fails if it names a field whose object cannot be located in the template.
+ @discussion The file is written through a PDFFileWriter, so path is never left partially written. This method can be called from several threads at once.
+ */
+-(BOOL)writeDocumentWithValues:(NSDictionary*)values ToPath:(NSString*)path;
+
+
+/** Writes the template filled with a record to a stream.
+
+ @param values The record.
+ @param stream The destination stream. It is opened if needed, and is left open.
+ @return YES if successful, NO if failed.
+ @discussion This method can be called from several threads at once, with different streams.
+ */
+-(BOOL)writeDocumentWithValues:(NSDictionary*)values ToStream:(NSOutputStream*)stream;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Filling Many Records
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Writes the template filled with each record to a file.
+
+ @param records The records. They are enumerated on the calling thread only as fast as they are written, so a lazy NSEnumerator keeps the whole sequence out of memory.
+ @param pathForRecord Returns the destination path of the record at an index. It is called on the calling thread. If it returns nil, the record is skipped.
+ @return The indexes of the records that could not be written.
+ @discussion Returns once every record has been written.
+ */
+-(NSIndexSet*)writeDocumentsWithRecords:(id<NSFastEnumeration>)records PathForRecord:(NSString* (^)(NSUInteger index))pathForRecord;
+
+
+/** Writes the template filled with each record to a stream.
+
+ @param records The records, enumerated as for writeDocumentsWithRecords:PathForRecord:.
+ @param streamForRecord Returns the destination stream of the record at an index. It is called on the calling thread. If it returns nil, the record is skipped.
+ @return The indexes of the records that could not be written.
+ @discussion Each stream is closed once its record has been written.
+ */
+-(NSIndexSet*)writeDocumentsWithRecords:(id<NSFastEnumeration>)records StreamForRecord:(NSOutputStream* (^)(NSUInteger index))streamForRecord;
+
+
+@end
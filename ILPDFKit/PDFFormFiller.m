@@ -0,0 +1,231 @@
+#import "PDFFormFiller.h"
+#import "PDFDocument.h"
+#import "PDFForm.h"
+#import "PDFFormContainer.h"
+#import "PDFFileWriter.h"
+
+// The size of the pieces in which the template is written to a stream.
+#define PDFFormFillerStreamChunkSize 65536
+
+
+/* The saving methods of PDFDocument used to build the update of each record.
+ */
+@interface PDFDocument(PDFFormFiller)
+    -(NSData*)completeFileData;
+    -(NSArray*)fieldCodePartsWithNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber;
+    -(NSString*)pdfValueFromString:(NSString*)value Type:(PDFFormType)type;
+    -(NSData*)incrementalUpdateWithCodes:(NSDictionary*)objects GenerationNumbers:(NSDictionary*)generationNumbers Offset:(NSUInteger)dataLength Trailer:(NSString*)trailer;
+    -(NSString*)incrementalUpdateTrailer;
+@end
+
+
+/* A field object of the template, split around its value.
+ */
+@interface PDFFormFillerField : NSObject
+    @property(nonatomic) NSUInteger objectNumber;
+    @property(nonatomic) NSUInteger generationNumber;
+    @property(nonatomic) PDFFormType formType;
+    @property(nonatomic,strong) NSString* head;
+    @property(nonatomic,strong) NSString* tail;
+@end
+
+@implementation PDFFormFillerField
+@end
+
+
+
+@interface PDFFormFiller()
+    -(NSData*)updateForValues:(NSDictionary*)values;
+    -(BOOL)writeData:(NSData*)data ToStream:(NSOutputStream*)stream;
+    -(NSIndexSet*)writeDocumentsWithRecords:(id<NSFastEnumeration>)records Destination:(id (^)(NSUInteger index))destinationForRecord Write:(BOOL (^)(NSDictionary* values, id destination))write;
+@end
+
+
+@implementation PDFFormFiller
+{
+    NSData* _templateData;
+    NSString* _trailer;
+    NSDictionary* _fields;
+    NSSet* _unlocatedNames;
+}
+
+
+-(id)initWithDocument:(PDFDocument*)document
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _document = document;
+        _maximumConcurrentRecords = MAX([[NSProcessInfo processInfo] activeProcessorCount], 1);
+        _templateData = [[document completeFileData] copy];
+        _trailer = [document incrementalUpdateTrailer];
+        if(_templateData == nil || _trailer == nil)return nil;
+
+        NSMutableDictionary* fields = [NSMutableDictionary dictionary];
+        NSMutableSet* unlocatedNames = [NSMutableSet set];
+        NSMutableSet* objectNumbers = [NSMutableSet set];
+
+        for(PDFForm* form in document.forms)
+        {
+            if(form.name == nil)continue;
+            if(form.objectNumber == NSNotFound)
+            {
+                [unlocatedNames addObject:form.name];
+                continue;
+            }
+
+            // Widgets of one field share its object, which is written once.
+            if([objectNumbers containsObject:@(form.objectNumber)])continue;
+            [objectNumbers addObject:@(form.objectNumber)];
+
+            NSArray* parts = [document fieldCodePartsWithNumber:form.objectNumber GenerationNumber:form.generationNumber];
+            if(parts == nil)
+            {
+                [unlocatedNames addObject:form.name];
+                continue;
+            }
+
+            PDFFormFillerField* field = [[PDFFormFillerField alloc] init];
+            field.objectNumber = form.objectNumber;
+            field.generationNumber = form.generationNumber;
+            field.formType = form.formType;
+            field.head = parts[0];
+            field.tail = parts[1];
+
+            if(fields[form.name] == nil)fields[form.name] = [NSMutableArray array];
+            [fields[form.name] addObject:field];
+        }
+
+        _fields = [NSDictionary dictionaryWithDictionary:fields];
+        _unlocatedNames = [NSSet setWithSet:unlocatedNames];
+    }
+    return self;
+}
+
+
+-(BOOL)writeDocumentWithValues:(NSDictionary*)values ToPath:(NSString*)path
+{
+    NSData* update = [self updateForValues:values];
+    if(update == nil)return NO;
+
+    PDFFileWriter* writer = [[PDFFileWriter alloc] initWithPath:path];
+    if([writer appendData:_templateData] == NO || [writer appendData:update] == NO || [writer commit] == NO)
+    {
+        [writer cancel];
+        return NO;
+    }
+    return YES;
+}
+
+
+-(BOOL)writeDocumentWithValues:(NSDictionary*)values ToStream:(NSOutputStream*)stream
+{
+    NSData* update = [self updateForValues:values];
+    if(update == nil || stream == nil)return NO;
+
+    if([stream streamStatus] == NSStreamStatusNotOpen)[stream open];
+    return ([self writeData:_templateData ToStream:stream] && [self writeData:update ToStream:stream]);
+}
+
+
+-(NSIndexSet*)writeDocumentsWithRecords:(id<NSFastEnumeration>)records PathForRecord:(NSString* (^)(NSUInteger index))pathForRecord
+{
+    return [self writeDocumentsWithRecords:records Destination:pathForRecord Write:^BOOL(NSDictionary* values, id destination) {
+        return [self writeDocumentWithValues:values ToPath:destination];
+    }];
+}
+
+
+-(NSIndexSet*)writeDocumentsWithRecords:(id<NSFastEnumeration>)records StreamForRecord:(NSOutputStream* (^)(NSUInteger index))streamForRecord
+{
+    return [self writeDocumentsWithRecords:records Destination:streamForRecord Write:^BOOL(NSDictionary* values, id destination) {
+        BOOL ret = [self writeDocumentWithValues:values ToStream:destination];
+        [destination close];
+        return ret;
+    }];
+}
+
+
+#pragma mark - Hidden
+
+
+// Returns nil if the record names a field that cannot be written.
+
+-(NSData*)updateForValues:(NSDictionary*)values
+{
+    NSMutableDictionary* codes = [NSMutableDictionary dictionary];
+    NSMutableDictionary* generationNumbers = [NSMutableDictionary dictionary];
+
+    for(NSString* name in values)
+    {
+        if([_unlocatedNames containsObject:name])return nil;
+
+        id value = values[name];
+        if([value isKindOfClass:[NSNull class]])value = nil;
+        else if([value isKindOfClass:[NSString class]] == NO)return nil;
+
+        for(PDFFormFillerField* field in _fields[name])
+        {
+            NSString* pdfValue = [_document pdfValueFromString:value Type:field.formType];
+            codes[@(field.objectNumber)] = [NSString stringWithFormat:@"%@%@%@",field.head,pdfValue,field.tail];
+            generationNumbers[@(field.objectNumber)] = @(field.generationNumber);
+        }
+    }
+
+    return [_document incrementalUpdateWithCodes:codes GenerationNumbers:generationNumbers Offset:[_templateData length] Trailer:_trailer];
+}
+
+
+-(BOOL)writeData:(NSData*)data ToStream:(NSOutputStream*)stream
+{
+    const uint8_t* bytes = [data bytes];
+    NSUInteger length = [data length];
+    NSUInteger written = 0;
+
+    while(written < length)
+    {
+        NSInteger count = [stream write:bytes+written maxLength:MIN(length-written, (NSUInteger)PDFFormFillerStreamChunkSize)];
+        if(count <= 0)return NO;
+        written += count;
+    }
+    return YES;
+}
+
+
+// Records are enumerated and their destinations obtained on the calling thread, and each record is written on a worker. The semaphore holds back enumeration while maximumConcurrentRecords records are in progress.
+
+-(NSIndexSet*)writeDocumentsWithRecords:(id<NSFastEnumeration>)records Destination:(id (^)(NSUInteger index))destinationForRecord Write:(BOOL (^)(NSDictionary* values, id destination))write
+{
+    NSMutableIndexSet* failed = [NSMutableIndexSet indexSet];
+    dispatch_semaphore_t slots = dispatch_semaphore_create(MAX(_maximumConcurrentRecords, 1));
+    dispatch_group_t group = dispatch_group_create();
+    dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    NSUInteger index = 0;
+
+    for(NSDictionary* values in records)
+    {
+        NSUInteger recordIndex = index++;
+        id destination = destinationForRecord(recordIndex);
+        if(destination == nil)continue;
+
+        dispatch_semaphore_wait(slots, DISPATCH_TIME_FOREVER);
+        dispatch_group_async(group, queue, ^{
+            @autoreleasepool {
+                BOOL written = ([values isKindOfClass:[NSDictionary class]] && write(values, destination));
+                if(written == NO)
+                {
+                    @synchronized(failed) {
+                        [failed addIndex:recordIndex];
+                    }
+                }
+            }
+            dispatch_semaphore_signal(slots);
+        });
+    }
+
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    return failed;
+}
+
+
+@end
@@ -0,0 +1,58 @@
+#import <Foundation/Foundation.h>
+
+@class PDFForm;
+
+
+/** The PDFFormNameTree class indexes the forms of a PDFFormContainer by their fully qualified names.
+ Names are split into their period separated components only when a form is added. Components are interned, so a component shared by many fields, such as 'Row' or 'Page1', is stored once. Every node of the tree is also registered under its full name, so a lookup is a single hash table probe and the name is never split again.
+ 
+     PDFFormNameTree* tree = [[PDFFormNameTree alloc] init];
+     [tree addForm:form];
+     NSArray* forms = [tree formsWithName:@"Address.City"];
+ 
+ The forms are kept in a single array ordered depth first, in which the descendants of each node occupy a contiguous range. The array of descendants returned for a partial name is made once from that range and reused until the tree changes, so repeated lookups do not allocate.
+ */
+@interface PDFFormNameTree : NSObject
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Adding and Removing Forms
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Adds a form under its name.
+ 
+ @param form The form to add.
+ */
+-(void)addForm:(PDFForm*)form;
+
+
+/** Removes a form.
+ 
+ @param form The form to remove.
+ */
+-(void)removeForm:(PDFForm*)form;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Finding Forms
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Returns the forms with a name, or descending from it.
+ 
+ @param name A fully qualified name, or the first components of one.
+ @return The forms called name if there are any, otherwise all forms whose names begin with the components of name, in the order they were added. Returns nil if no form name begins with those components.
+ */
+-(NSArray*)formsWithName:(NSString*)name;
+
+
+/** Returns the next components of the names below a name.
+ 
+ @param name A fully qualified name, the first components of one, or nil for the root of the tree.
+ @return The components that follow name in the names of the forms, in the order they were first added. If name is the full name of forms and no longer names extend it, the array is empty.
+ */
+-(NSArray*)childComponentsOfName:(NSString*)name;
+
+
+@end
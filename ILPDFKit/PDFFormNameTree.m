@@ -0,0 +1,155 @@
+#import "PDFFormNameTree.h"
+#import "PDFForm.h"
+
+
+/* A node of the name tree. Nodes are only created and read by PDFFormNameTree.
+ */
+@interface PDFFormNameTreeNode : NSObject
+    @property(nonatomic,strong) NSString* name;
+    @property(nonatomic,readonly) NSMutableArray* forms;
+    @property(nonatomic,readonly) NSMutableArray* childComponents;
+    @property(nonatomic,readonly) NSMutableDictionary* children;
+    @property(nonatomic) NSRange range;
+    @property(nonatomic,strong) NSArray* descendants;
+@end
+
+
+@implementation PDFFormNameTreeNode
+
+-(id)init
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _forms = [[NSMutableArray alloc] init];
+        _childComponents = [[NSMutableArray alloc] init];
+        _children = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+}
+
+@end
+
+
+
+@interface PDFFormNameTree()
+    -(PDFFormNameTreeNode*)nodeForName:(NSString*)name;
+    -(void)indexNode:(PDFFormNameTreeNode*)node;
+@end
+
+
+@implementation PDFFormNameTree
+{
+    PDFFormNameTreeNode* _root;
+    NSMutableDictionary* _nodesByName;
+    NSMutableSet* _components;
+    NSMutableArray* _orderedForms;
+    BOOL _indexed;
+}
+
+
+-(id)init
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _root = [[PDFFormNameTreeNode alloc] init];
+        _nodesByName = [[NSMutableDictionary alloc] init];
+        _components = [[NSMutableSet alloc] init];
+        _orderedForms = [[NSMutableArray alloc] init];
+    }
+    return self;
+}
+
+
+-(void)addForm:(PDFForm*)form
+{
+    [[self nodeForName:(form.name?form.name:@"")].forms addObject:form];
+    _indexed = NO;
+}
+
+
+-(void)removeForm:(PDFForm*)form
+{
+    PDFFormNameTreeNode* node = _nodesByName[(form.name?form.name:@"")];
+    if(node == nil)return;
+    [node.forms removeObject:form];
+    _indexed = NO;
+}
+
+
+-(NSArray*)formsWithName:(NSString*)name
+{
+    PDFFormNameTreeNode* node = (name?_nodesByName[name]:nil);
+    if(node == nil)return nil;
+    if([node.forms count] || [node.childComponents count] == 0)return node.forms;
+    
+    if(_indexed == NO)
+    {
+        [_orderedForms removeAllObjects];
+        [self indexNode:_root];
+        _indexed = YES;
+    }
+    
+    if(node.descendants == nil)node.descendants = [_orderedForms subarrayWithRange:node.range];
+    return node.descendants;
+}
+
+
+-(NSArray*)childComponentsOfName:(NSString*)name
+{
+    PDFFormNameTreeNode* node = (name?_nodesByName[name]:_root);
+    return node.childComponents;
+}
+
+
+#pragma mark - Hidden
+
+
+// Only called when a name is not in the tree yet, so names are split once.
+
+-(PDFFormNameTreeNode*)nodeForName:(NSString*)name
+{
+    PDFFormNameTreeNode* ret = _nodesByName[name];
+    if(ret)return ret;
+    
+    ret = _root;
+    for(NSString* comp in [name componentsSeparatedByString:@"."])
+    {
+        NSString* component = [_components member:comp];
+        if(component == nil)
+        {
+            component = [comp copy];
+            [_components addObject:component];
+        }
+        
+        PDFFormNameTreeNode* child = ret.children[component];
+        if(child == nil)
+        {
+            child = [[PDFFormNameTreeNode alloc] init];
+            child.name = (ret == _root?component:[NSString stringWithFormat:@"%@.%@",ret.name,component]);
+            ret.children[component] = child;
+            [ret.childComponents addObject:component];
+            _nodesByName[child.name] = child;
+        }
+        ret = child;
+    }
+    
+    return ret;
+}
+
+
+// Lays out the forms depth first, so each node's descendants form one range of the array.
+
+-(void)indexNode:(PDFFormNameTreeNode*)node
+{
+    NSUInteger start = [_orderedForms count];
+    [_orderedForms addObjectsFromArray:node.forms];
+    for(NSString* component in node.childComponents)[self indexNode:node.children[component]];
+    
+    node.range = NSMakeRange(start, [_orderedForms count]-start);
+    node.descendants = nil;
+}
+
+
+@end
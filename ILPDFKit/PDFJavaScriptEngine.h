@@ -0,0 +1,15 @@
+#import <Foundation/Foundation.h>
+#import "PDFScriptEngine.h"
+
+
+/** The PDFJavaScriptEngine class runs form scripts in process with JavaScriptCore.
+ Fields are native host objects bound to the PDFForm objects of the container, so reading or assigning field.value is a direct call rather than a round trip through a web view, and no field is copied in or out of the interpreter unless the script asks for it. The engine needs no view or run loop, so scripts also run headless.
+ 
+     PDFJavaScriptEngine* engine = [[PDFJavaScriptEngine alloc] init];
+     [engine evaluateScript:@"getField('Total').value = 42;" WithForms:document.forms];
+ 
+ One JavaScript context is kept for the life of the engine, so globals defined by one script are visible to later scripts.
+ */
+@interface PDFJavaScriptEngine : NSObject<PDFScriptEngine>
+
+@end
@@ -0,0 +1,203 @@
+#import "PDFJavaScriptEngine.h"
+#import "PDFFormContainer.h"
+#import "PDFForm.h"
+#import "PDFTrace.h"
+#import <JavaScriptCore/JavaScriptCore.h>
+
+
+/* The properties and methods of a field visible to scripts.
+ */
+@protocol PDFJavaScriptFieldExports <JSExport>
+    @property(nonatomic,readonly) NSString* name;
+    @property(nonatomic,readonly) NSString* type;
+    @property(nonatomic,strong) id value;
+    @property(nonatomic,readonly) NSArray* items;
+    @property(nonatomic,readonly) NSUInteger numItems;
+    -(void)clearItems;
+    JSExportAs(insertItemAt, -(void)insertItem:(NSString*)item At:(id)index);
+    JSExportAs(setAction, -(void)setAction:(NSString*)trigger Script:(NSString*)script);
+@end
+
+
+/* A field as seen by scripts. It holds no state of its own, so every access reads or writes the forms with its name.
+ */
+@interface PDFJavaScriptField : NSObject<PDFJavaScriptFieldExports>
+    -(id)initWithName:(NSString*)name Container:(PDFFormContainer*)container;
+@end
+
+
+@implementation PDFJavaScriptField
+{
+    __weak PDFFormContainer* _container;
+}
+
+@synthesize name = _name;
+
+
+-(id)initWithName:(NSString*)name Container:(PDFFormContainer*)container
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _name = [name copy];
+        _container = container;
+    }
+    return self;
+}
+
+
+-(NSString*)type
+{
+    PDFTraceCount(PDFTraceCounterBridgeCalls, 1);
+    switch([(PDFForm*)[[_container formsWithName:_name] lastObject] formType])
+    {
+        case PDFFormTypeText: return @"text";
+        case PDFFormTypeButton: return @"button";
+        case PDFFormTypeChoice: return @"combobox";
+        case PDFFormTypeSignature: return @"signature";
+        default: return nil;
+    }
+}
+
+
+-(id)value
+{
+    PDFTraceCount(PDFTraceCounterBridgeCalls, 1);
+    return [_container valueForFormWithName:_name];
+}
+
+
+-(void)setValue:(id)value
+{
+    PDFTraceCount(PDFTraceCounterBridgeCalls, 1);
+    // Scripts may assign numbers, which are stored as their text.
+    NSString* val = nil;
+    if([value isKindOfClass:[NSString class]])val = value;
+    else if([value isKindOfClass:[NSNumber class]])val = [value stringValue];
+    [_container setValue:val ForFormWithName:_name];
+}
+
+
+-(NSArray*)items
+{
+    PDFTraceCount(PDFTraceCounterBridgeCalls, 1);
+    NSArray* ret = [(PDFForm*)[[_container formsWithName:_name] lastObject] options];
+    return (ret?ret:@[]);
+}
+
+
+-(NSUInteger)numItems
+{
+    return [self.items count];
+}
+
+
+-(void)clearItems
+{
+    PDFTraceCount(PDFTraceCounterBridgeCalls, 1);
+    for(PDFForm* form in [_container formsWithName:_name])form.options = nil;
+}
+
+
+-(void)insertItem:(NSString*)item At:(id)index
+{
+    PDFTraceCount(PDFTraceCounterBridgeCalls, 1);
+    if([item isKindOfClass:[NSString class]] == NO)return;
+
+    // Without an index, or with one out of range, the item is appended.
+    NSMutableArray* items = [NSMutableArray arrayWithArray:self.items];
+    NSInteger position = ([index isKindOfClass:[NSNumber class]]?[index integerValue]:-1);
+    if(position < 0 || position > (NSInteger)[items count])position = [items count];
+    [items insertObject:item atIndex:position];
+
+    for(PDFForm* form in [_container formsWithName:_name])form.options = [NSArray arrayWithArray:items];
+}
+
+
+-(void)setAction:(NSString*)trigger Script:(NSString*)script
+{
+    // Actions are read from the document only.
+}
+
+
+@end
+
+
+
+@interface PDFJavaScriptEngine()
+    -(void)loadContext;
+@end
+
+
+@implementation PDFJavaScriptEngine
+{
+    JSContext* _context;
+    __weak PDFFormContainer* _container;
+}
+
+
+-(BOOL)evaluateScript:(NSString*)script WithForms:(PDFFormContainer*)container
+{
+    PDFTraceBegin(span);
+    if(_context == nil)[self loadContext];
+
+    // A script that changes a field can trigger calculation scripts before it finishes, so the state of the outer script is restored afterwards.
+    PDFFormContainer* outerContainer = _container;
+    JSValue* outerEvent = _context[@"event"];
+    _container = container;
+
+    NSString* eventValue = [container getDocumentValueForKey:@"EventValue"];
+    JSValue* event = [JSValue valueWithObject:@{@"value":(eventValue?eventValue:@""),@"willCommit":@YES} inContext:_context];
+    _context[@"event"] = event;
+
+    _context.exception = nil;
+    [_context evaluateScript:script];
+    BOOL ret = (_context.exception == nil);
+
+    JSValue* result = event[@"value"];
+    [container setDocumentValue:(([result isUndefined] || [result isNull])?nil:[result toString]) ForKey:@"EventValue"];
+
+    _context[@"event"] = outerEvent;
+    _container = outerContainer;
+    PDFTraceEnd(span, @"PDFJavaScriptEngine.evaluateScript");
+    return ret;
+}
+
+
+#pragma mark - Hidden
+
+
+// The host functions look up the container at call time, so the context never retains it.
+
+-(void)loadContext
+{
+    _context = [[JSContext alloc] init];
+    __weak PDFJavaScriptEngine* weakSelf = self;
+
+    _context[@"getField"] = ^id(NSString* cName) {
+        PDFTraceCount(PDFTraceCounterBridgeCalls, 1);
+        PDFJavaScriptEngine* engine = weakSelf;
+        PDFFormContainer* container = (engine?engine->_container:nil);
+        if(container == nil || [[container formsWithName:cName] count] == 0)return [NSNull null];
+        return [[PDFJavaScriptField alloc] initWithName:cName Container:container];
+    };
+
+    _context[@"submitForm"] = ^(JSValue* param) {
+        PDFTraceCount(PDFTraceCounterBridgeCalls, 1);
+        PDFJavaScriptEngine* engine = weakSelf;
+        PDFFormContainer* container = (engine?engine->_container:nil);
+        NSDictionary* entries = ([param isObject]?[param toDictionary]:nil);
+
+        NSMutableString* output = [NSMutableString string];
+        for(NSString* key in entries)[output appendFormat:@"%@:%@;",key,entries[key]];
+        [container setDocumentValue:output ForKey:@"SubmitForm"];
+    };
+
+    _context[@"print"] = ^(JSValue* param) {};
+    _context[@"getPrintParams"] = ^id() {
+        return [NSNull null];
+    };
+}
+
+
+@end
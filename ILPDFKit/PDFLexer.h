@@ -0,0 +1,191 @@
+#import <Foundation/Foundation.h>
+
+
+typedef enum PDFTokenType
+{
+    PDFTokenTypeEnd = 0,
+    PDFTokenTypeNumber,
+    PDFTokenTypeName,
+    PDFTokenTypeString,
+    PDFTokenTypeHexString,
+    PDFTokenTypeKeyword,
+    PDFTokenTypeArrayOpen,
+    PDFTokenTypeArrayClose,
+    PDFTokenTypeDictionaryOpen,
+    PDFTokenTypeDictionaryClose,
+    PDFTokenTypeProcedureOpen,
+    PDFTokenTypeProcedureClose
+
+} PDFTokenType;
+
+
+/** A token produced by PDFLexer.
+
+ - type: The token type.
+ - offset: The offset of the first byte of the token in the lexer data, including any delimiters such as '(' or '/'.
+ - length: The number of bytes spanned by the token, including its delimiters.
+ */
+typedef struct
+{
+    PDFTokenType type;
+    NSUInteger offset;
+    NSUInteger length;
+}
+PDFToken;
+
+
+
+/** The PDFLexer class splits the bytes of a PDF file into tokens without copying them.
+ The lexer works directly on the bytes of its NSData, which is typically the memory mapped file of a PDFDocument. Tokens are returned as spans into that data, so nothing is materialized as a string unless a caller explicitly asks for the text of a span.
+
+     PDFLexer* lexer = [[PDFLexer alloc] initWithData:document.documentData];
+     lexer.position = offset;
+     PDFToken token = [lexer nextToken];
+     if([lexer token:token IsKeyword:"xref"])
+     {
+        // Read the cross-reference section.
+     }
+
+ Comments are treated as white space. Stream data is not tokenized; use skipStreamData once the 'stream' keyword has been read.
+ */
+@interface PDFLexer : NSObject
+
+
+/** The data being tokenized.
+ */
+@property(nonatomic,readonly) NSData* data;
+
+/** The raw bytes of data.
+ */
+@property(nonatomic,readonly) const unsigned char* bytes;
+
+/** The offset one past the last byte the lexer may read.
+ */
+@property(nonatomic,readonly) NSUInteger end;
+
+/** The offset at which the next token will be read.
+ */
+@property(nonatomic) NSUInteger position;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Creating a PDFLexer
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Creates a new instance of PDFLexer over all of data.
+
+ @param data The bytes to tokenize.
+ @return A new PDFLexer positioned at the start of data.
+ */
+-(id)initWithData:(NSData*)data;
+
+
+/** Creates a new instance of PDFLexer over a range of data.
+
+ @param data The bytes to tokenize.
+ @param range The range of data the lexer may read.
+ @return A new PDFLexer positioned at the start of range.
+ */
+-(id)initWithData:(NSData*)data Range:(NSRange)range;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Reading Tokens
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Reads the next token and advances position past it.
+
+ @return The next token. At the end of the data, a token of type PDFTokenTypeEnd.
+ */
+-(PDFToken)nextToken;
+
+
+/** Reads the next token without advancing position.
+
+ @return The next token.
+ */
+-(PDFToken)peekToken;
+
+
+/** Skips a complete object, including nested arrays and dictionaries. An indirect reference such as '12 0 R' counts as one object.
+
+ @return The span of the skipped object, or a range with location NSNotFound if no complete object follows position.
+ */
+-(NSRange)skipObject;
+
+
+/** Skips the data of a stream whose 'stream' keyword has just been read.
+
+ @param length The value of the stream dictionary's 'Length' entry, or NSNotFound if it is unknown. If length does not lead to an 'endstream' keyword, the data is searched for one.
+ @return The span of the stream data.
+ */
+-(NSRange)skipStreamDataWithLength:(NSUInteger)length;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Interpreting Tokens
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Tests a keyword token.
+
+ @param token The token.
+ @param keyword A NUL terminated keyword such as "obj".
+ @return YES if token is a keyword token equal to keyword.
+ */
+-(BOOL)token:(PDFToken)token IsKeyword:(const char*)keyword;
+
+
+/** Returns the integer value of a number token.
+
+ @param token The token.
+ @return The integer value, or 0 if token is not a number.
+ */
+-(NSInteger)integerValueOfToken:(PDFToken)token;
+
+
+/** Returns the value of a number token.
+
+ @param token The token.
+ @return The value, or 0 if token is not a number.
+ */
+-(double)realValueOfToken:(PDFToken)token;
+
+
+/** Returns the text of a span.
+
+ @param range A range of data.
+ @return A new string with the bytes of range interpreted as ISO Latin 1, so that every byte is preserved.
+ */
+-(NSString*)stringWithRange:(NSRange)range;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Searching
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Finds a byte sequence.
+
+ @param pattern The bytes to find.
+ @param patternLength The number of bytes in pattern.
+ @param range The range of data to search.
+ @param backwards If YES, the last occurence in range is found.
+ @return The offset of the occurence, or NSNotFound.
+ */
+-(NSUInteger)offsetOfBytes:(const void*)pattern Length:(NSUInteger)patternLength InRange:(NSRange)range Backwards:(BOOL)backwards;
+
+
+/** Finds a keyword.
+
+ @param keyword A NUL terminated keyword.
+ @param range The range of data to search.
+ @param backwards If YES, the last occurence in range is found.
+ @return The offset of the occurence, or NSNotFound.
+ */
+-(NSUInteger)offsetOfKeyword:(const char*)keyword InRange:(NSRange)range Backwards:(BOOL)backwards;
+
+
+@end
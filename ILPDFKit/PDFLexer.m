@@ -0,0 +1,369 @@
+
+#import "PDFLexer.h"
+
+#define isDelim(c) ((c) == '(' || (c) == ')' || (c) == '<' || (c) == '>' || (c) == '[' || (c) == ']' || (c) == '{' || (c) == '}' || (c) == '/' ||  (c) == '%')
+#define isWS(c) ((c) == 0 || (c) == 9 || (c) == 10 || (c) == 12 || (c) == 13 || (c) == 32)
+#define isRegular(c) (!isWS(c) && !isDelim(c))
+#define isNumeric(c) (((c) >= '0' && (c) <= '9') || (c) == '+' || (c) == '-' || (c) == '.')
+
+
+@interface PDFLexer()
+    -(NSUInteger)skipWhiteSpaceFrom:(NSUInteger)index;
+@end
+
+
+@implementation PDFLexer
+{
+    NSUInteger _start;
+}
+
+
+-(id)initWithData:(NSData*)data
+{
+    return [self initWithData:data Range:NSMakeRange(0, [data length])];
+}
+
+
+-(id)initWithData:(NSData*)data Range:(NSRange)range
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _data = data;
+        _bytes = [data bytes];
+        _start = range.location;
+        _end = MIN(NSMaxRange(range), [data length]);
+        _position = _start;
+    }
+    return self;
+}
+
+
+#pragma mark - Reading Tokens
+
+
+-(PDFToken)nextToken
+{
+    NSUInteger c = [self skipWhiteSpaceFrom:_position];
+    PDFToken token = {PDFTokenTypeEnd, c, 0};
+
+    if(c >= _end)
+    {
+        _position = _end;
+        token.offset = _end;
+        return token;
+    }
+
+    unsigned char ch = _bytes[c];
+    NSUInteger index = c+1;
+
+    switch(ch)
+    {
+        case '(':
+        {
+            NSUInteger nestCount = 1;
+            while(index < _end && nestCount > 0)
+            {
+                if(_bytes[index] == '\\')index++;
+                else if(_bytes[index] == '(')nestCount++;
+                else if(_bytes[index] == ')')nestCount--;
+                index++;
+            }
+            
+            // A backslash ending the data skips past its end.
+            if(index > _end)index = _end;
+            token.type = PDFTokenTypeString;
+        }
+            break;
+        case '<':
+            if(index < _end && _bytes[index] == '<')
+            {
+                index++;
+                token.type = PDFTokenTypeDictionaryOpen;
+            }
+            else
+            {
+                while(index < _end && _bytes[index] != '>')index++;
+                if(index < _end)index++;
+                token.type = PDFTokenTypeHexString;
+            }
+            break;
+        case '>':
+            if(index < _end && _bytes[index] == '>')
+            {
+                index++;
+                token.type = PDFTokenTypeDictionaryClose;
+            }
+            else token.type = PDFTokenTypeKeyword;
+            break;
+        case '[':
+            token.type = PDFTokenTypeArrayOpen;
+            break;
+        case ']':
+            token.type = PDFTokenTypeArrayClose;
+            break;
+        case '{':
+            token.type = PDFTokenTypeProcedureOpen;
+            break;
+        case '}':
+            token.type = PDFTokenTypeProcedureClose;
+            break;
+        case '/':
+            while(index < _end && isRegular(_bytes[index]))index++;
+            token.type = PDFTokenTypeName;
+            break;
+        case ')':
+            token.type = PDFTokenTypeKeyword;
+            break;
+        default:
+        {
+            BOOL numeric = isNumeric(ch);
+            while(index < _end && isRegular(_bytes[index]))
+            {
+                numeric = numeric && isNumeric(_bytes[index]);
+                index++;
+            }
+            token.type = (numeric?PDFTokenTypeNumber:PDFTokenTypeKeyword);
+        }
+            break;
+    }
+
+    token.length = index-c;
+    _position = index;
+    return token;
+}
+
+
+-(PDFToken)peekToken
+{
+    NSUInteger position = _position;
+    PDFToken ret = [self nextToken];
+    _position = position;
+    return ret;
+}
+
+
+-(NSRange)skipObject
+{
+    NSUInteger nestCount = 0;
+    NSUInteger location = NSNotFound;
+    NSUInteger position = _position;
+
+    while(YES)
+    {
+        PDFToken token = [self nextToken];
+        if(token.type == PDFTokenTypeEnd)
+        {
+            _position = position;
+            return NSMakeRange(NSNotFound, 0);
+        }
+        if(location == NSNotFound)location = token.offset;
+
+        if(token.type == PDFTokenTypeDictionaryOpen || token.type == PDFTokenTypeArrayOpen || token.type == PDFTokenTypeProcedureOpen)nestCount++;
+        else if(token.type == PDFTokenTypeDictionaryClose || token.type == PDFTokenTypeArrayClose || token.type == PDFTokenTypeProcedureClose)
+        {
+            if(nestCount == 0)
+            {
+                _position = position;
+                return NSMakeRange(NSNotFound, 0);
+            }
+            nestCount--;
+        }
+
+        if(nestCount == 0)
+        {
+            NSUInteger end = token.offset+token.length;
+            
+            // An indirect reference such as '12 0 R' is a single object.
+            if(token.type == PDFTokenTypeNumber)
+            {
+                NSUInteger afterNumber = _position;
+                PDFToken generationToken = [self nextToken];
+                PDFToken referenceToken = [self nextToken];
+                if(generationToken.type == PDFTokenTypeNumber && [self token:referenceToken IsKeyword:"R"])end = referenceToken.offset+referenceToken.length;
+                else _position = afterNumber;
+            }
+            
+            return NSMakeRange(location, end-location);
+        }
+    }
+}
+
+
+-(NSRange)skipStreamDataWithLength:(NSUInteger)length
+{
+    NSUInteger start = _position;
+
+    // The 'stream' keyword is followed by CRLF or LF only.
+    if(start < _end && _bytes[start] == 13)start++;
+    if(start < _end && _bytes[start] == 10)start++;
+
+    if(length != NSNotFound && start+length <= _end)
+    {
+        _position = start+length;
+        PDFToken token = [self nextToken];
+        if([self token:token IsKeyword:"endstream"])return NSMakeRange(start, length);
+    }
+
+    NSUInteger endMarker = [self offsetOfKeyword:"endstream" InRange:NSMakeRange(start, _end-start) Backwards:NO];
+    if(endMarker == NSNotFound)
+    {
+        _position = _end;
+        return NSMakeRange(start, _end-start);
+    }
+
+    _position = endMarker+strlen("endstream");
+
+    // The end of line marker preceding 'endstream' is not part of the data.
+    NSUInteger dataEnd = endMarker;
+    if(dataEnd > start && _bytes[dataEnd-1] == 10)dataEnd--;
+    if(dataEnd > start && _bytes[dataEnd-1] == 13)dataEnd--;
+    return NSMakeRange(start, dataEnd-start);
+}
+
+
+#pragma mark - Interpreting Tokens
+
+
+-(BOOL)token:(PDFToken)token IsKeyword:(const char*)keyword
+{
+    if(token.type != PDFTokenTypeKeyword)return NO;
+    NSUInteger keywordLength = strlen(keyword);
+    return token.length == keywordLength && memcmp(_bytes+token.offset, keyword, keywordLength) == 0;
+}
+
+
+-(NSInteger)integerValueOfToken:(PDFToken)token
+{
+    if(token.type != PDFTokenTypeNumber)return 0;
+
+    NSInteger ret = 0;
+    NSInteger sign = 1;
+    NSUInteger c = token.offset;
+    NSUInteger end = token.offset+token.length;
+
+    if(_bytes[c] == '-' || _bytes[c] == '+')
+    {
+        if(_bytes[c] == '-')sign = -1;
+        c++;
+    }
+
+    while(c < end && _bytes[c] >= '0' && _bytes[c] <= '9')
+    {
+        ret = ret*10+(_bytes[c]-'0');
+        c++;
+    }
+
+    return sign*ret;
+}
+
+
+-(double)realValueOfToken:(PDFToken)token
+{
+    if(token.type != PDFTokenTypeNumber)return 0;
+
+    double ret = 0;
+    double sign = 1;
+    double scale = 0;
+    NSUInteger c = token.offset;
+    NSUInteger end = token.offset+token.length;
+
+    for(; c < end ; c++)
+    {
+        unsigned char ch = _bytes[c];
+        if(ch == '-')sign = -1;
+        else if(ch == '.')scale = 1;
+        else if(ch >= '0' && ch <= '9')
+        {
+            ret = ret*10+(ch-'0');
+            if(scale > 0)scale *= 10;
+        }
+    }
+
+    return sign*(scale > 0?ret/scale:ret);
+}
+
+
+-(NSString*)stringWithRange:(NSRange)range
+{
+    if(range.location == NSNotFound || NSMaxRange(range) > [_data length])return nil;
+    return [[NSString alloc] initWithBytes:_bytes+range.location length:range.length encoding:NSISOLatin1StringEncoding];
+}
+
+
+#pragma mark - Searching
+
+
+-(NSUInteger)offsetOfBytes:(const void*)pattern Length:(NSUInteger)patternLength InRange:(NSRange)range Backwards:(BOOL)backwards
+{
+    NSUInteger start = MAX(range.location, _start);
+    NSUInteger end = MIN(NSMaxRange(range), _end);
+    if(patternLength == 0 || end < start || end-start < patternLength)return NSNotFound;
+
+    const unsigned char* p = pattern;
+    NSUInteger last = end-patternLength;
+
+    if(backwards)
+    {
+        NSUInteger c = last+1;
+        while(c-- > start)
+        {
+            if(_bytes[c] == p[0] && memcmp(_bytes+c, p, patternLength) == 0)return c;
+        }
+    }
+    else
+    {
+        const unsigned char* iter = _bytes+start;
+        const unsigned char* stop = _bytes+last+1;
+        while(iter < stop && (iter = memchr(iter, p[0], stop-iter)) != NULL)
+        {
+            if(memcmp(iter, p, patternLength) == 0)return iter-_bytes;
+            iter++;
+        }
+    }
+
+    return NSNotFound;
+}
+
+
+-(NSUInteger)offsetOfKeyword:(const char*)keyword InRange:(NSRange)range Backwards:(BOOL)backwards
+{
+    NSUInteger keywordLength = strlen(keyword);
+
+    while(range.length >= keywordLength)
+    {
+        NSUInteger c = [self offsetOfBytes:keyword Length:keywordLength InRange:range Backwards:backwards];
+        if(c == NSNotFound)return NSNotFound;
+
+        BOOL startsToken = (c == 0 || !isRegular(_bytes[c-1]));
+        BOOL endsToken = (c+keywordLength >= [_data length] || !isRegular(_bytes[c+keywordLength]));
+        if(startsToken && endsToken)return c;
+
+        if(backwards)range.length = c-range.location;
+        else range = NSMakeRange(c+1, NSMaxRange(range)-c-1);
+    }
+
+    return NSNotFound;
+}
+
+
+#pragma mark - Hidden
+
+
+-(NSUInteger)skipWhiteSpaceFrom:(NSUInteger)index
+{
+    while(index < _end)
+    {
+        unsigned char c = _bytes[index];
+        if(isWS(c))index++;
+        else if(c == '%')
+        {
+            while(index < _end && _bytes[index] != 10 && _bytes[index] != 13)index++;
+        }
+        else break;
+    }
+    return index;
+}
+
+
+@end
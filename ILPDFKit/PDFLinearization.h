@@ -0,0 +1,76 @@
+#import <Foundation/Foundation.h>
+
+
+/** The PDFLinearization class reads the linearization dictionary and the primary hint stream of a linearized ('fast web view') PDF.
+ A linearized file starts with everything needed to show its first page: the linearization dictionary, a cross-reference section listing the objects of the first page, and a hint stream that locates every other page. PDFLinearization reads only these, from the start of the file, so a document can resolve its first page, and find the bytes of any other page, before the rest of the file is indexed.
+
+     PDFLinearization* linearization = [[PDFLinearization alloc] initWithData:data];
+     NSRange range = [linearization rangeOfPageAtIndex:3];
+
+ A linearized file that was then updated incrementally is no longer linearized, because its length differs from the length recorded in the dictionary. Such a file is read like any other.
+ */
+@interface PDFLinearization : NSObject
+
+
+/** The length of the file, the 'L' entry of the dictionary.
+ */
+@property(nonatomic,readonly) NSUInteger fileLength;
+
+/** The object number of the page object of the first page, the 'O' entry.
+ */
+@property(nonatomic,readonly) NSUInteger firstPageObjectNumber;
+
+/** The offset of the end of the first page, the 'E' entry.
+ */
+@property(nonatomic,readonly) NSUInteger firstPageEndOffset;
+
+/** The number of pages, the 'N' entry.
+ */
+@property(nonatomic,readonly) NSUInteger numberOfPages;
+
+/** The offset of the cross-reference section that follows the dictionary and lists the objects of the first page.
+ */
+@property(nonatomic,readonly) NSUInteger firstPageCrossReferenceOffset;
+
+/** The location and length of the primary hint stream, the 'H' entry.
+ */
+@property(nonatomic,readonly) NSRange hintStreamRange;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Creating a PDFLinearization
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Reads the linearization of a file.
+
+ @param data The file data of the PDF.
+ @return A new PDFLinearization, or nil if the file is not linearized or has been updated since.
+ @discussion If the hint stream is missing or cannot be decoded, the dictionary is still read, but pages cannot be located.
+ */
+-(id)initWithData:(NSData*)data;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Locating Pages
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Returns the bytes of the objects of a page.
+
+ @param index The index of the page, starting at 0.
+ @return The range of the file holding the page object and the objects only that page uses, or a range with location NSNotFound if the hint tables do not describe the page.
+ @discussion The range of the first page starts at its page object and includes the objects it shares with later pages. Objects shared by several later pages are stored after the last page and are not included.
+ */
+-(NSRange)rangeOfPageAtIndex:(NSUInteger)index;
+
+
+/** Returns the number of objects of a page.
+
+ @param index The index of the page, starting at 0.
+ @return The number of objects in rangeOfPageAtIndex:, or NSNotFound if the hint tables do not describe the page.
+ */
+-(NSUInteger)numberOfObjectsOfPageAtIndex:(NSUInteger)index;
+
+
+@end
@@ -0,0 +1,195 @@
+#import "PDFLinearization.h"
+#import "PDFLexer.h"
+#import "PDFDictionary.h"
+#import "PDFArray.h"
+#import "PDFUtility.h"
+
+// The linearization dictionary must start within this many bytes of the start of the file.
+#define PDFLinearizationDictionaryLimit 1024
+
+// The number of bits of the page offset hint table header after the entries that locate pages.
+#define PDFLinearizationSkippedHeaderBits 160
+
+
+/* Bits read from a hint table, most significant first.
+ */
+typedef struct
+{
+    const unsigned char* bytes;
+    NSUInteger length;
+    NSUInteger position;
+}
+PDFLinearizationBits;
+
+
+// Reads width bits, or returns NSNotFound past the end of the table.
+static NSUInteger PDFLinearizationReadBits(PDFLinearizationBits* bits, NSUInteger width)
+{
+    if(width > 32 || bits->position+width > 8*bits->length)return NSNotFound;
+
+    NSUInteger ret = 0;
+    for(NSUInteger i = 0 ; i < width ; i++, bits->position++)ret = (ret << 1)|((bits->bytes[bits->position >> 3] >> (7-(bits->position & 7))) & 1);
+    return ret;
+}
+
+
+// Each item of a hint table starts on a byte boundary.
+static void PDFLinearizationAlignBits(PDFLinearizationBits* bits)
+{
+    bits->position = (bits->position+7)/8*8;
+}
+
+
+static NSUInteger PDFLinearizationUnsignedValue(id value)
+{
+    return ([value isKindOfClass:[NSNumber class]] && [value integerValue] >= 0?[value unsignedIntegerValue]:NSNotFound);
+}
+
+
+@interface PDFLinearization()
+    -(void)readHintStreamFromData:(NSData*)data;
+    -(NSUInteger)offsetWithHintStream:(NSUInteger)offset;
+@end
+
+
+@implementation PDFLinearization
+{
+    NSData* _pageOffsets;
+    NSData* _pageLengths;
+    NSData* _pageObjectCounts;
+}
+
+
+-(id)initWithData:(NSData*)data
+{
+    self = [super init];
+    if(self != nil)
+    {
+        PDFLexer* lexer = [[PDFLexer alloc] initWithData:data];
+        PDFToken numberToken = [lexer nextToken];
+        PDFToken generationToken = [lexer nextToken];
+        PDFToken marker = [lexer nextToken];
+        if(numberToken.type != PDFTokenTypeNumber || generationToken.type != PDFTokenTypeNumber || [lexer token:marker IsKeyword:"obj"] == NO || marker.offset > PDFLinearizationDictionaryLimit)return nil;
+
+        NSRange dictionaryRange = [lexer skipObject];
+        if(dictionaryRange.location == NSNotFound || [lexer token:[lexer nextToken] IsKeyword:"endobj"] == NO)return nil;
+        _firstPageCrossReferenceOffset = [lexer peekToken].offset;
+
+        // The dictionary is parsed without a parent document, because the file is not indexed yet.
+        PDFDictionary* dictionary = [[PDFDictionary alloc] initWithPDFRepresentation:[lexer stringWithRange:dictionaryRange] Document:nil];
+        if([dictionary objectForKey:@"Linearized"] == nil)return nil;
+
+        // Appending an update changes the length of the file, which tells it apart from a file that is still linearized.
+        _fileLength = PDFLinearizationUnsignedValue([dictionary objectForKey:@"L"]);
+        if(_fileLength != [data length])return nil;
+
+        _firstPageObjectNumber = PDFLinearizationUnsignedValue([dictionary objectForKey:@"O"]);
+        _firstPageEndOffset = PDFLinearizationUnsignedValue([dictionary objectForKey:@"E"]);
+        _numberOfPages = PDFLinearizationUnsignedValue([dictionary objectForKey:@"N"]);
+        if(_firstPageObjectNumber == NSNotFound || _firstPageObjectNumber == 0 || _numberOfPages == NSNotFound || _numberOfPages == 0)return nil;
+
+        NSArray* hint = [[dictionary objectForKey:@"H"] nsa];
+        NSUInteger hintOffset = ([hint count] >= 2?PDFLinearizationUnsignedValue(hint[0]):NSNotFound);
+        NSUInteger hintLength = ([hint count] >= 2?PDFLinearizationUnsignedValue(hint[1]):NSNotFound);
+        _hintStreamRange = (hintOffset != NSNotFound && hintLength != NSNotFound?NSMakeRange(hintOffset, hintLength):NSMakeRange(NSNotFound, 0));
+
+        [self readHintStreamFromData:data];
+    }
+
+    return self;
+}
+
+
+-(NSRange)rangeOfPageAtIndex:(NSUInteger)index
+{
+    if(index >= [_pageLengths length]/sizeof(NSUInteger))return NSMakeRange(NSNotFound, 0);
+    return NSMakeRange(((const NSUInteger*)[_pageOffsets bytes])[index], ((const NSUInteger*)[_pageLengths bytes])[index]);
+}
+
+
+-(NSUInteger)numberOfObjectsOfPageAtIndex:(NSUInteger)index
+{
+    if(index >= [_pageObjectCounts length]/sizeof(NSUInteger))return NSNotFound;
+    return ((const NSUInteger*)[_pageObjectCounts bytes])[index];
+}
+
+
+#pragma mark - Hidden
+
+
+// Only the page offset hint table is read. It gives the number of objects and the length of each page, and the pages follow each other from the page object of the first page.
+
+-(void)readHintStreamFromData:(NSData*)data
+{
+    // Each page has at least one object, so a page count above the file length is corrupt.
+    if(_hintStreamRange.location == NSNotFound || NSMaxRange(_hintStreamRange) > [data length] || _numberOfPages > [data length])return;
+
+    PDFLexer* lexer = [[PDFLexer alloc] initWithData:data];
+    lexer.position = _hintStreamRange.location;
+    PDFToken numberToken = [lexer nextToken];
+    PDFToken generationToken = [lexer nextToken];
+    if(numberToken.type != PDFTokenTypeNumber || generationToken.type != PDFTokenTypeNumber || [lexer token:[lexer nextToken] IsKeyword:"obj"] == NO)return;
+
+    NSRange dictionaryRange = [lexer skipObject];
+    if(dictionaryRange.location == NSNotFound || [lexer token:[lexer nextToken] IsKeyword:"stream"] == NO)return;
+
+    PDFDictionary* dictionary = [[PDFDictionary alloc] initWithPDFRepresentation:[lexer stringWithRange:dictionaryRange] Document:nil];
+    NSRange dataRange = [lexer skipStreamDataWithLength:PDFLinearizationUnsignedValue([dictionary objectForKey:@"Length"])];
+    if(dataRange.location == NSNotFound)return;
+    NSData* table = [PDFUtility decodedDataFromStreamData:[data subdataWithRange:dataRange] Dictionary:dictionary];
+    if(table == nil)return;
+
+    PDFLinearizationBits bits = {[table bytes],[table length],0};
+    NSUInteger leastObjects = PDFLinearizationReadBits(&bits, 32);
+    NSUInteger firstPageOffset = PDFLinearizationReadBits(&bits, 32);
+    NSUInteger objectBits = PDFLinearizationReadBits(&bits, 16);
+    NSUInteger leastLength = PDFLinearizationReadBits(&bits, 32);
+    NSUInteger lengthBits = PDFLinearizationReadBits(&bits, 16);
+    if(lengthBits == NSNotFound || objectBits > 32 || lengthBits > 32)return;
+
+    // Content streams and shared objects are not needed to locate pages.
+    bits.position += PDFLinearizationSkippedHeaderBits;
+
+    NSMutableData* objectCounts = [NSMutableData dataWithLength:_numberOfPages*sizeof(NSUInteger)];
+    NSMutableData* lengths = [NSMutableData dataWithLength:_numberOfPages*sizeof(NSUInteger)];
+    NSMutableData* offsets = [NSMutableData dataWithLength:_numberOfPages*sizeof(NSUInteger)];
+    NSUInteger* count = [objectCounts mutableBytes];
+    NSUInteger* length = [lengths mutableBytes];
+    NSUInteger* offset = [offsets mutableBytes];
+
+    for(NSUInteger p = 0 ; p < _numberOfPages ; p++)
+    {
+        NSUInteger delta = PDFLinearizationReadBits(&bits, objectBits);
+        if(delta == NSNotFound)return;
+        count[p] = leastObjects+delta;
+    }
+    PDFLinearizationAlignBits(&bits);
+
+    for(NSUInteger p = 0 ; p < _numberOfPages ; p++)
+    {
+        NSUInteger delta = PDFLinearizationReadBits(&bits, lengthBits);
+        if(delta == NSNotFound)return;
+        length[p] = leastLength+delta;
+    }
+
+    // Locations in hint tables are given as if the hint stream were absent.
+    NSUInteger location = firstPageOffset;
+    for(NSUInteger p = 0 ; p < _numberOfPages ; p++)
+    {
+        offset[p] = [self offsetWithHintStream:location];
+        location += length[p];
+    }
+
+    _pageObjectCounts = objectCounts;
+    _pageLengths = lengths;
+    _pageOffsets = offsets;
+}
+
+
+-(NSUInteger)offsetWithHintStream:(NSUInteger)offset
+{
+    return (offset >= _hintStreamRange.location?offset+_hintStreamRange.length:offset);
+}
+
+
+@end
@@ -0,0 +1,126 @@
+#import <Foundation/Foundation.h>
+#import "PDFDataSource.h"
+
+
+/** The PDFMappedFile class holds the bytes of a document as the read-only mapping of its file followed by a log of appended incremental updates.
+ The file and the log are laid out next to each other in one reserved range of address space. The whole pages of the file are mapped from the file itself, so only its partial last page and the log live in anonymous memory. Readers therefore see a single contiguous NSData, and appending an update never copies the file.
+
+     PDFMappedFile* file = [[PDFMappedFile alloc] initWithPath:path];
+     [file appendData:update];
+     PDFLexer* lexer = [[PDFLexer alloc] initWithData:file.data];
+
+ Bytes are only ever appended, so every NSData returned by data stays valid and unchanged, even after later appends. When the log outgrows its reservation, a larger range is reserved and the file is mapped into it again. Earlier NSData objects keep the old range alive until they are released.
+
+ Original bytes given as data are kept as they are and only the log is reserved. data then returns the original NSData itself until something is appended, and after that an NSData reading the original bytes and the log in place. Ranges and subdata within either part are served without copying. The two parts are joined into one buffer only when contiguous bytes of the whole are asked for, once per NSData returned.
+
+ A file read from a PDFDataSource starts empty. Its original bytes read as zeros until loadRange: fetches them, after which they appear in place in every NSData returned by data. Readers load the bytes they are about to read, and missing ranges that lie close together are fetched as one read, extended by readAheadLength.
+ */
+@interface PDFMappedFile : NSObject
+
+
+/** The mapped file, or nil if the original bytes were given as data.
+ */
+@property(nonatomic,readonly) NSString* path;
+
+/** The source of the original bytes, or nil if they are all present.
+ */
+@property(nonatomic,readonly) id<PDFDataSource> dataSource;
+
+/** The number of bytes read past the end of each range fetched from dataSource. Defaults to 64 KB.
+ */
+@property(nonatomic) NSUInteger readAheadLength;
+
+/** The length of the original bytes.
+ */
+@property(nonatomic,readonly) NSUInteger originalLength;
+
+/** The length of the original bytes and the appended updates.
+ */
+@property(nonatomic,readonly) NSUInteger length;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Creating a PDFMappedFile
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Maps a file.
+
+ @param path The file to map. It must not be changed while it is mapped.
+ @return A new PDFMappedFile, or nil if the file could not be mapped.
+ */
+-(id)initWithPath:(NSString*)path;
+
+
+/** Reads bytes that are not in a file, without copying them.
+
+ @param data The original bytes. Mutable data is copied once, so later changes to it are not seen.
+ @return A new PDFMappedFile, or nil if memory could not be reserved.
+ */
+-(id)initWithData:(NSData*)data;
+
+
+/** Reserves room for bytes that are read from a source as they are needed.
+
+ @param source The source of the original bytes. Nothing is read from it yet.
+ @return A new PDFMappedFile, or nil if memory could not be reserved.
+ */
+-(id)initWithDataSource:(id<PDFDataSource>)source;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Reading and Appending
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** The original bytes followed by every appended update, without copying.
+
+ @return An immutable NSData of length bytes.
+ @discussion For original bytes given as data, the bytes of the returned NSData are joined into one buffer the first time they are read as a whole. getBytes:range: and subdataWithRange: do not join them.
+ */
+-(NSData*)data;
+
+
+/** The appended updates, without copying.
+
+ @return An immutable NSData of length-originalLength bytes.
+ */
+-(NSData*)appendedData;
+
+
+/** Fetches original bytes from dataSource.
+
+ @param range The bytes to fetch. The part past originalLength, which is always present, is ignored.
+ @return YES if the bytes are present, NO if dataSource failed to read them.
+ @discussion Without a dataSource, nothing is read and YES is returned.
+ */
+-(BOOL)loadRange:(NSRange)range;
+
+
+/** Fetches several ranges of original bytes from dataSource at once.
+
+ @param ranges NSValue objects holding the ranges to fetch.
+ @return YES if the bytes are present, NO if dataSource failed to read them.
+ @discussion The ranges that are missing are merged where they lie within a few kilobytes of each other, so adjacent ranges cost a single read.
+ */
+-(BOOL)loadRanges:(NSArray*)ranges;
+
+
+/** Copies bytes, fetching them first if needed.
+
+ @param buffer The buffer to fill.
+ @param range The bytes to copy.
+ @return The number of bytes copied, which is less than range.length if range passes length, or 0 if the bytes could not be fetched.
+ */
+-(NSUInteger)getBytes:(void*)buffer Range:(NSRange)range;
+
+
+/** Appends bytes to the log.
+
+ @param data The bytes to append.
+ @return YES if successful, NO if memory could not be reserved.
+ */
+-(BOOL)appendData:(NSData*)data;
+
+
+@end
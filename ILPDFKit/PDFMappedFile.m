@@ -0,0 +1,439 @@
+#import "PDFMappedFile.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+
+// The log reserves at least this many bytes of address space. Untouched pages use no memory.
+#define PDFMappedFileMinimumLogCapacity (1 << 20)
+
+// Bytes read past each range fetched from a data source, unless readAheadLength is changed.
+#define PDFMappedFileDefaultReadAhead (64*1024)
+
+// Missing ranges separated by fewer loaded bytes than this are fetched as one read, which fetches the loaded bytes again.
+#define PDFMappedFileCoalescingGap (4*1024)
+
+
+/* A reserved range of address space, unmapped when the last NSData reading it is released.
+ */
+@interface PDFMappedRegion : NSObject
+{
+    @public
+    unsigned char* _base;
+    size_t _size;
+}
+@end
+
+@implementation PDFMappedRegion
+
+-(void)dealloc
+{
+    if(_base)munmap(_base, _size);
+}
+
+@end
+
+
+/* An NSData reading a span of a region, which it keeps alive.
+ */
+@interface PDFMappedRegionData : NSData
+{
+    PDFMappedRegion* _region;
+    const void* _bytes;
+    NSUInteger _length;
+}
+-(id)initWithRegion:(PDFMappedRegion*)region Range:(NSRange)range;
+@end
+
+@implementation PDFMappedRegionData
+
+-(id)initWithRegion:(PDFMappedRegion*)region Range:(NSRange)range
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _region = region;
+        _bytes = region->_base+range.location;
+        _length = range.length;
+    }
+    return self;
+}
+
+-(const void*)bytes
+{
+    return _bytes;
+}
+
+-(NSUInteger)length
+{
+    return _length;
+}
+
+-(id)copyWithZone:(NSZone*)zone
+{
+    return self;
+}
+
+@end
+
+
+/* An NSData reading data given by the caller followed by the log, without copying either. The two are only joined into one buffer the first time contiguous bytes are asked for.
+ */
+@interface PDFMappedConcatenatedData : NSData
+{
+    NSData* _head;
+    NSData* _tail;
+    NSData* _joined;
+}
+-(id)initWithHead:(NSData*)head Tail:(NSData*)tail;
+@end
+
+@implementation PDFMappedConcatenatedData
+
+-(id)initWithHead:(NSData*)head Tail:(NSData*)tail
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _head = head;
+        _tail = tail;
+    }
+    return self;
+}
+
+-(const void*)bytes
+{
+    @synchronized(self)
+    {
+        if(_joined == nil)
+        {
+            NSMutableData* joined = [[NSMutableData alloc] initWithCapacity:[self length]];
+            [joined appendData:_head];
+            [joined appendData:_tail];
+            _joined = joined;
+        }
+        return [_joined bytes];
+    }
+}
+
+-(NSUInteger)length
+{
+    return [_head length]+[_tail length];
+}
+
+-(void)getBytes:(void*)buffer range:(NSRange)range
+{
+    NSUInteger headLength = [_head length];
+    if(range.location < headLength)
+    {
+        NSUInteger count = MIN(range.length, headLength-range.location);
+        [_head getBytes:buffer range:NSMakeRange(range.location, count)];
+        buffer = (unsigned char*)buffer+count;
+        range = NSMakeRange(headLength, range.length-count);
+    }
+    if(range.length > 0)[_tail getBytes:buffer range:NSMakeRange(range.location-headLength, range.length)];
+}
+
+-(NSData*)subdataWithRange:(NSRange)range
+{
+    NSUInteger headLength = [_head length];
+    if(NSMaxRange(range) <= headLength)return [_head subdataWithRange:range];
+    if(range.location >= headLength)return [_tail subdataWithRange:NSMakeRange(range.location-headLength, range.length)];
+    return [super subdataWithRange:range];
+}
+
+-(void)enumerateByteRangesUsingBlock:(void (^)(const void* bytes, NSRange byteRange, BOOL* stop))block
+{
+    BOOL stop = NO;
+    block([_head bytes], NSMakeRange(0, [_head length]), &stop);
+    if(stop == NO && [_tail length] > 0)block([_tail bytes], NSMakeRange([_head length], [_tail length]), &stop);
+}
+
+-(id)copyWithZone:(NSZone*)zone
+{
+    return self;
+}
+
+@end
+
+
+@interface PDFMappedFile()
+    -(PDFMappedRegion*)regionWithCapacity:(NSUInteger)capacity;
+    -(NSData*)dataOfRegionWithRange:(NSRange)range;
+    -(NSArray*)missingRangesForRanges:(NSArray*)ranges;
+@end
+
+
+@implementation PDFMappedFile
+{
+    int _fd;
+    NSData* _originalData;
+    PDFMappedRegion* _region;
+    NSUInteger _regionOffset;
+    NSUInteger _capacity;
+    NSMutableIndexSet* _loadedIndexes;
+}
+
+
+-(void)dealloc
+{
+    if(_fd >= 0)close(_fd);
+}
+
+
+-(id)initWithPath:(NSString*)path
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _fd = open([path fileSystemRepresentation], O_RDONLY);
+        if(_fd < 0)return nil;
+
+        struct stat info;
+        if(fstat(_fd, &info) != 0)return nil;
+
+        _path = [path copy];
+        _originalLength = (NSUInteger)info.st_size;
+        _length = _originalLength;
+        _capacity = _originalLength+PDFMappedFileMinimumLogCapacity;
+        _region = [self regionWithCapacity:_capacity];
+        if(_region == nil)return nil;
+    }
+
+    return self;
+}
+
+
+-(id)initWithData:(NSData*)data
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _fd = -1;
+        _originalData = [data copy];
+        _originalLength = [data length];
+        _length = _originalLength;
+        _regionOffset = _originalLength;
+        _capacity = _originalLength+PDFMappedFileMinimumLogCapacity;
+        _region = [self regionWithCapacity:_capacity];
+        if(_region == nil)return nil;
+    }
+
+    return self;
+}
+
+
+-(id)initWithDataSource:(id<PDFDataSource>)source
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _fd = -1;
+        _dataSource = source;
+        _readAheadLength = PDFMappedFileDefaultReadAhead;
+        _loadedIndexes = [[NSMutableIndexSet alloc] init];
+        _originalLength = [source length];
+        _length = _originalLength;
+        _capacity = _originalLength+PDFMappedFileMinimumLogCapacity;
+        _region = [self regionWithCapacity:_capacity];
+        if(_region == nil)return nil;
+    }
+
+    return self;
+}
+
+
+-(NSData*)data
+{
+    @synchronized(self)
+    {
+        if(_originalData == nil)return [self dataOfRegionWithRange:NSMakeRange(0, _length)];
+        if(_length == _originalLength)return _originalData;
+        return [[PDFMappedConcatenatedData alloc] initWithHead:_originalData Tail:[self dataOfRegionWithRange:NSMakeRange(_originalLength, _length-_originalLength)]];
+    }
+}
+
+
+-(NSData*)appendedData
+{
+    @synchronized(self)
+    {
+        return [self dataOfRegionWithRange:NSMakeRange(_originalLength, _length-_originalLength)];
+    }
+}
+
+
+-(BOOL)appendData:(NSData*)data
+{
+    NSUInteger length = [data length];
+    if(length == 0)return YES;
+
+    @synchronized(self)
+    {
+        if(_length+length > _capacity)
+        {
+            // The log doubles, so a series of appends copies each logged byte a constant number of times. The file itself is mapped again, not copied.
+            NSUInteger capacity = _originalLength+MAX(2*(_length-_originalLength+length), (NSUInteger)PDFMappedFileMinimumLogCapacity);
+            PDFMappedRegion* region = [self regionWithCapacity:capacity];
+            if(region == nil)return NO;
+
+            size_t page = (size_t)getpagesize();
+            NSUInteger copied = (_fd >= 0?_originalLength/page*page:_regionOffset);
+            if(_dataSource)
+            {
+                // Only the bytes fetched so far are copied. The rest is still fetched on demand.
+                PDFMappedRegion* old = _region;
+                [_loadedIndexes enumerateRangesUsingBlock:^(NSRange range, BOOL* stop)
+                {
+                    memcpy(region->_base+range.location, old->_base+range.location, range.length);
+                }];
+                copied = _originalLength;
+            }
+            memcpy(region->_base+copied-_regionOffset, _region->_base+copied-_regionOffset, _length-copied);
+            _region = region;
+            _capacity = capacity;
+        }
+
+        memcpy(_region->_base+_length-_regionOffset, [data bytes], length);
+        _length += length;
+    }
+
+    return YES;
+}
+
+
+-(BOOL)loadRange:(NSRange)range
+{
+    return [self loadRanges:@[[NSValue valueWithRange:range]]];
+}
+
+
+-(BOOL)loadRanges:(NSArray*)ranges
+{
+    if(_dataSource == nil)return YES;
+
+    NSArray* missing = nil;
+    @synchronized(self)
+    {
+        missing = [self missingRangesForRanges:ranges];
+    }
+
+    // The source is read outside the lock, so readers of bytes that are already present do not wait for it. Two threads may fetch the same bytes, which only costs a read.
+    for(NSValue* value in missing)
+    {
+        NSRange range = [value rangeValue];
+        NSData* data = [_dataSource dataWithRange:range];
+        if([data length] != range.length)return NO;
+
+        @synchronized(self)
+        {
+            memcpy(_region->_base+range.location, [data bytes], range.length);
+            [_loadedIndexes addIndexesInRange:range];
+        }
+    }
+
+    return YES;
+}
+
+
+-(NSUInteger)getBytes:(void*)buffer Range:(NSRange)range
+{
+    if(range.location >= _length)return 0;
+    range.length = MIN(range.length, _length-range.location);
+    if([self loadRange:range] == NO)return 0;
+
+    @synchronized(self)
+    {
+        NSUInteger count = 0;
+        if(range.location < _regionOffset)
+        {
+            count = MIN(range.length, _regionOffset-range.location);
+            [_originalData getBytes:buffer range:NSMakeRange(range.location, count)];
+        }
+        memcpy((unsigned char*)buffer+count, _region->_base+range.location+count-_regionOffset, range.length-count);
+    }
+    return range.length;
+}
+
+
+#pragma mark - Hidden
+
+
+// The bytes of range, which must lie past the original data, as an NSData that keeps the region alive.
+
+-(NSData*)dataOfRegionWithRange:(NSRange)range
+{
+    return [[PDFMappedRegionData alloc] initWithRegion:_region Range:NSMakeRange(range.location-_regionOffset, range.length)];
+}
+
+
+// The ranges to read for ranges, in order: each range that is not fully present is extended by the read-ahead, the bytes already present are removed, and what is left is merged across small gaps.
+
+-(NSArray*)missingRangesForRanges:(NSArray*)ranges
+{
+    NSMutableIndexSet* wanted = [NSMutableIndexSet indexSet];
+    for(NSValue* value in ranges)
+    {
+        NSRange range = [value rangeValue];
+        if(range.location >= _originalLength || range.length == 0)continue;
+        range.length = MIN(range.length, _originalLength-range.location);
+        if([_loadedIndexes containsIndexesInRange:range])continue;
+
+        range.length = MIN(range.length+_readAheadLength, _originalLength-range.location);
+        [wanted addIndexesInRange:range];
+    }
+    [wanted removeIndexes:_loadedIndexes];
+
+    NSMutableArray* ret = [NSMutableArray array];
+    __block NSRange run = NSMakeRange(NSNotFound, 0);
+    [wanted enumerateRangesUsingBlock:^(NSRange range, BOOL* stop)
+    {
+        if(run.location != NSNotFound && range.location-NSMaxRange(run) < PDFMappedFileCoalescingGap)run.length = NSMaxRange(range)-run.location;
+        else
+        {
+            if(run.location != NSNotFound)[ret addObject:[NSValue valueWithRange:run]];
+            run = range;
+        }
+    }];
+    if(run.location != NSNotFound)[ret addObject:[NSValue valueWithRange:run]];
+
+    return ret;
+}
+
+
+
+// Reserves room for the first capacity bytes past the original data given by the caller, or for capacity bytes otherwise, and fills in the original bytes of a file: its whole pages are mapped from it and its partial last page is read after them, so the log can follow the last byte directly.
+
+-(PDFMappedRegion*)regionWithCapacity:(NSUInteger)capacity
+{
+    size_t page = (size_t)getpagesize();
+    capacity -= _regionOffset;
+    size_t size = MAX((capacity+page-1)/page*page, page);
+    void* base = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANON, -1, 0);
+    if(base == MAP_FAILED)return nil;
+
+    PDFMappedRegion* ret = [[PDFMappedRegion alloc] init];
+    ret->_base = base;
+    ret->_size = size;
+
+    // Original data given by the caller stays where it is, and the bytes of a data source are filled by the caller.
+    if(_fd < 0)return ret;
+
+    size_t mapped = _originalLength/page*page;
+    if(mapped > 0 && mmap(ret->_base, mapped, PROT_READ, MAP_PRIVATE|MAP_FIXED, _fd, 0) == MAP_FAILED)return nil;
+
+    size_t offset = mapped;
+    while(offset < _originalLength)
+    {
+        ssize_t count = pread(_fd, ret->_base+offset, _originalLength-offset, (off_t)offset);
+        if(count < 0 && errno == EINTR)continue;
+        if(count <= 0)return nil;
+        offset += count;
+    }
+
+    return ret;
+}
+
+
+@end
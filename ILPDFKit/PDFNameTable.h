@@ -0,0 +1,139 @@
+#import <Foundation/Foundation.h>
+
+
+/* Atoms for the names the kit dispatches on. Interning any of these names returns the constant itself, so the keys the kit looks up most are shared by every document.
+ */
+extern NSString* const PDFNameA;
+extern NSString* const PDFNameAA;
+extern NSString* const PDFNameAcroForm;
+extern NSString* const PDFNameAnnots;
+extern NSString* const PDFNameAP;
+extern NSString* const PDFNameAS;
+extern NSString* const PDFNameBtn;
+extern NSString* const PDFNameC;
+extern NSString* const PDFNameCh;
+extern NSString* const PDFNameCO;
+extern NSString* const PDFNameD;
+extern NSString* const PDFNameDA;
+extern NSString* const PDFNameDecodeParms;
+extern NSString* const PDFNameDR;
+extern NSString* const PDFNameDV;
+extern NSString* const PDFNameE;
+extern NSString* const PDFNameEncrypt;
+extern NSString* const PDFNameF;
+extern NSString* const PDFNameFf;
+extern NSString* const PDFNameFields;
+extern NSString* const PDFNameFilter;
+extern NSString* const PDFNameFlateDecode;
+extern NSString* const PDFNameFT;
+extern NSString* const PDFNameID;
+extern NSString* const PDFNameInfo;
+extern NSString* const PDFNameJS;
+extern NSString* const PDFNameJavaScript;
+extern NSString* const PDFNameK;
+extern NSString* const PDFNameKids;
+extern NSString* const PDFNameLength;
+extern NSString* const PDFNameMK;
+extern NSString* const PDFNameN;
+extern NSString* const PDFNameObjStm;
+extern NSString* const PDFNameOff;
+extern NSString* const PDFNameOpt;
+extern NSString* const PDFNameP;
+extern NSString* const PDFNameParent;
+extern NSString* const PDFNamePrev;
+extern NSString* const PDFNameQ;
+extern NSString* const PDFNameRect;
+extern NSString* const PDFNameRoot;
+extern NSString* const PDFNameS;
+extern NSString* const PDFNameSig;
+extern NSString* const PDFNameSize;
+extern NSString* const PDFNameSubtype;
+extern NSString* const PDFNameT;
+extern NSString* const PDFNameTU;
+extern NSString* const PDFNameTx;
+extern NSString* const PDFNameType;
+extern NSString* const PDFNameV;
+extern NSString* const PDFNameWidget;
+extern NSString* const PDFNameXRef;
+
+
+/** Compares a name with an atom.
+ Names interned by the same table are equal only if they are the same object, so the pointer check decides almost every comparison. Names that did not pass through a table, such as those of dictionaries built by the caller, are still compared by value.
+ 
+ @param name The name, which may be nil or not a string.
+ @param atom One of the constants above, or an atom of a table.
+ @return YES if name equals atom.
+ */
+static inline BOOL PDFNameIsEqual(id name, NSString* atom)
+{
+    return (name == atom || [name isEqual:atom]);
+}
+
+
+@class PDFDocument;
+
+
+/** The PDFNameTable class interns the PDF names read from a document.
+ Every dictionary key and name value produced by PDFDictionary, PDFArray and PDFObjectParser for a document passes through the table of that document. Each distinct name is stored once: a name equal to one of the constants above is returned as that constant, and any other name as the string the table stored the first time it saw it. Equal names are therefore the same object, so they compare by pointer with PDFNameIsEqual and dictionary lookups with them succeed on the pointer check of isEqual: without comparing characters.
+ 
+     NSString* type = [fieldDictionary objectForKey:PDFNameFT];
+     if(PDFNameIsEqual(type, PDFNameBtn))
+     {
+        // A button field.
+     }
+ 
+ Each PDFDocument owns its table, so the names of a document are released with it and untrusted documents never accumulate names in the process. Objects that belong to no document, and dictionaries read through CGPDF, use a shared table that only holds the constants and never grows. A table is safe to use from several threads.
+ */
+@interface PDFNameTable : NSObject
+
+
+/** The number of names stored besides the constants.
+ */
+@property(nonatomic,readonly) NSUInteger count;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Finding a Table
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Returns the table to intern the names of a document with.
+ 
+ @param document The document, or nil.
+ @return The nameTable of document, or the shared table of constants if document is nil.
+ */
++(PDFNameTable*)tableForDocument:(PDFDocument*)document;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Interning Names
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Interns a name.
+ 
+ @param name The name, without its leading slash.
+ @return The atom equal to name, or nil if name is nil.
+ */
+-(NSString*)atomForName:(NSString*)name;
+
+
+/** Interns a name given as a NUL terminated UTF-8 string, as returned by the CGPDF functions.
+ 
+ @param name The name, without its leading slash.
+ @return The atom equal to name, or nil if name is NULL or not valid UTF-8.
+ */
+-(NSString*)atomForCString:(const char*)name;
+
+
+/** Interns a name given as bytes of the file, read as ISO Latin 1.
+ 
+ @param bytes The bytes of the name, without its leading slash.
+ @param length The number of bytes.
+ @return The atom equal to the name.
+ @discussion A string is only made the first time a name is seen.
+ */
+-(NSString*)atomForBytes:(const char*)bytes Length:(NSUInteger)length;
+
+
+@end
@@ -0,0 +1,178 @@
+#import "PDFNameTable.h"
+#import "PDFDocument.h"
+#include <pthread.h>
+
+
+NSString* const PDFNameA = @"A";
+NSString* const PDFNameAA = @"AA";
+NSString* const PDFNameAcroForm = @"AcroForm";
+NSString* const PDFNameAnnots = @"Annots";
+NSString* const PDFNameAP = @"AP";
+NSString* const PDFNameAS = @"AS";
+NSString* const PDFNameBtn = @"Btn";
+NSString* const PDFNameC = @"C";
+NSString* const PDFNameCh = @"Ch";
+NSString* const PDFNameCO = @"CO";
+NSString* const PDFNameD = @"D";
+NSString* const PDFNameDA = @"DA";
+NSString* const PDFNameDecodeParms = @"DecodeParms";
+NSString* const PDFNameDR = @"DR";
+NSString* const PDFNameDV = @"DV";
+NSString* const PDFNameE = @"E";
+NSString* const PDFNameEncrypt = @"Encrypt";
+NSString* const PDFNameF = @"F";
+NSString* const PDFNameFf = @"Ff";
+NSString* const PDFNameFields = @"Fields";
+NSString* const PDFNameFilter = @"Filter";
+NSString* const PDFNameFlateDecode = @"FlateDecode";
+NSString* const PDFNameFT = @"FT";
+NSString* const PDFNameID = @"ID";
+NSString* const PDFNameInfo = @"Info";
+NSString* const PDFNameJS = @"JS";
+NSString* const PDFNameJavaScript = @"JavaScript";
+NSString* const PDFNameK = @"K";
+NSString* const PDFNameKids = @"Kids";
+NSString* const PDFNameLength = @"Length";
+NSString* const PDFNameMK = @"MK";
+NSString* const PDFNameN = @"N";
+NSString* const PDFNameObjStm = @"ObjStm";
+NSString* const PDFNameOff = @"Off";
+NSString* const PDFNameOpt = @"Opt";
+NSString* const PDFNameP = @"P";
+NSString* const PDFNameParent = @"Parent";
+NSString* const PDFNamePrev = @"Prev";
+NSString* const PDFNameQ = @"Q";
+NSString* const PDFNameRect = @"Rect";
+NSString* const PDFNameRoot = @"Root";
+NSString* const PDFNameS = @"S";
+NSString* const PDFNameSig = @"Sig";
+NSString* const PDFNameSize = @"Size";
+NSString* const PDFNameSubtype = @"Subtype";
+NSString* const PDFNameT = @"T";
+NSString* const PDFNameTU = @"TU";
+NSString* const PDFNameTx = @"Tx";
+NSString* const PDFNameType = @"Type";
+NSString* const PDFNameV = @"V";
+NSString* const PDFNameWidget = @"Widget";
+NSString* const PDFNameXRef = @"XRef";
+
+
+// The constants, shared by every table. The set is built once and never changes, so it is read without a lock.
+static NSSet* _constants = nil;
+
+// The table of objects without a document, which only holds the constants.
+static PDFNameTable* _constantTable = nil;
+
+
+@interface PDFNameTable()
+    -(id)initGrowing:(BOOL)growing;
+    -(NSString*)atomForProbe:(NSString*)probe Make:(NSString*(^)(void))make;
+@end
+
+
+@implementation PDFNameTable
+{
+    NSMutableSet* _atoms;
+    pthread_mutex_t _lock;
+}
+
+
++(void)initialize
+{
+    if(self != [PDFNameTable class])return;
+    _constants = [[NSSet alloc] initWithArray:@[PDFNameA,PDFNameAA,PDFNameAcroForm,PDFNameAnnots,PDFNameAP,PDFNameAS,PDFNameBtn,PDFNameC,PDFNameCh,PDFNameCO,PDFNameD,PDFNameDA,PDFNameDecodeParms,PDFNameDR,PDFNameDV,PDFNameE,PDFNameEncrypt,PDFNameF,PDFNameFf,PDFNameFields,PDFNameFilter,PDFNameFlateDecode,PDFNameFT,PDFNameID,PDFNameInfo,PDFNameJS,PDFNameJavaScript,PDFNameK,PDFNameKids,PDFNameLength,PDFNameMK,PDFNameN,PDFNameObjStm,PDFNameOff,PDFNameOpt,PDFNameP,PDFNameParent,PDFNamePrev,PDFNameQ,PDFNameRect,PDFNameRoot,PDFNameS,PDFNameSig,PDFNameSize,PDFNameSubtype,PDFNameT,PDFNameTU,PDFNameTx,PDFNameType,PDFNameV,PDFNameWidget,PDFNameXRef]];
+    _constantTable = [[PDFNameTable alloc] initGrowing:NO];
+}
+
+
+-(void)dealloc
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+
+-(id)init
+{
+    return [self initGrowing:YES];
+}
+
+
++(PDFNameTable*)tableForDocument:(PDFDocument*)document
+{
+    PDFNameTable* ret = document.nameTable;
+    return (ret?ret:_constantTable);
+}
+
+
+-(NSUInteger)count
+{
+    pthread_mutex_lock(&_lock);
+    NSUInteger ret = [_atoms count];
+    pthread_mutex_unlock(&_lock);
+    return ret;
+}
+
+
+-(NSString*)atomForName:(NSString*)name
+{
+    if(name == nil)return nil;
+    return [self atomForProbe:name Make:^NSString*{ return [name copy]; }];
+}
+
+
+-(NSString*)atomForCString:(const char*)name
+{
+    if(name == NULL)return nil;
+    
+    // The probe borrows the bytes, so no string is made for names already interned.
+    NSString* probe = [[NSString alloc] initWithBytesNoCopy:(void*)name length:strlen(name) encoding:NSUTF8StringEncoding freeWhenDone:NO];
+    if(probe == nil)return nil;
+    return [self atomForProbe:probe Make:^NSString*{ return [[NSString alloc] initWithUTF8String:name]; }];
+}
+
+
+-(NSString*)atomForBytes:(const char*)bytes Length:(NSUInteger)length
+{
+    NSString* probe = [[NSString alloc] initWithBytesNoCopy:(void*)bytes length:length encoding:NSISOLatin1StringEncoding freeWhenDone:NO];
+    return [self atomForProbe:probe Make:^NSString*{ return [[NSString alloc] initWithBytes:bytes length:length encoding:NSISOLatin1StringEncoding]; }];
+}
+
+
+#pragma mark - Hidden
+
+
+-(id)initGrowing:(BOOL)growing
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _atoms = (growing?[[NSMutableSet alloc] init]:nil);
+        pthread_mutex_init(&_lock, NULL);
+    }
+    
+    return self;
+}
+
+
+// Returns the constant or stored atom equal to probe. Otherwise make is called once, and its string is stored if the table grows.
+
+-(NSString*)atomForProbe:(NSString*)probe Make:(NSString*(^)(void))make
+{
+    NSString* ret = [_constants member:probe];
+    if(ret)return ret;
+    if(_atoms == nil)return make();
+    
+    pthread_mutex_lock(&_lock);
+    ret = [_atoms member:probe];
+    if(ret == nil)
+    {
+        ret = make();
+        if(ret)[_atoms addObject:ret];
+    }
+    pthread_mutex_unlock(&_lock);
+    
+    return ret;
+}
+
+
+@end
@@ -58,6 +58,17 @@ Note that Strings and Numbers may be presented as generic PDFObject instances in
 -(id)initWithPDFRepresentation:(NSString*)rep Document:(PDFDocument*)parentDocument;
 
 
+/**
+ Initializes a pdf object based on a range of PDF code. The representation is only extracted from data when it is first requested.
+ @param range The range of data spanned by the object.
+ @param data The ISO Latin 1 encoded PDF code containing the object.
+ @param parentDocument The parent document containing the object.
+ @return The representation of the object as it is defined in its parent document.
+ */
+
+-(id)initWithPDFRepresentationRange:(NSRange)range OfData:(NSData*)data Document:(PDFDocument*)parentDocument;
+
+
 /**
  Initializes a pdf object based on its object number generation number and containing document.  Looks up the representation in the cross reference table.
  @param objNumber The object number of the PDF object.
@@ -5,17 +5,32 @@
 #import "PDFDictionary.h"
 #import "PDFArray.h"
 #import "PDFDocument.h"
+#import "PDFStream.h"
+#import "PDFLexer.h"
+#import "PDFNameTable.h"
 
 @implementation PDFObject
 {
     NSString* _representation;
+    NSData* _sourceData;
+    NSRange _sourceRange;
 }
 
 
 
 -(NSString*)pdfFileRepresentation
 {
-    return _representation;
+    // Cached objects are shared by the threads that read form fields, so the source bytes are only released under the lock.
+    @synchronized(self)
+    {
+        if(_representation == nil && _sourceData != nil)
+        {
+            _representation = [[NSString alloc] initWithBytes:(const char*)[_sourceData bytes]+_sourceRange.location length:_sourceRange.length encoding:NSISOLatin1StringEncoding];
+            _sourceData = nil;
+        }
+        
+        return _representation;
+    }
 }
 
 #pragma mark - Object Creation
@@ -26,7 +41,10 @@
     if(test.length>=2)
     {
         if([test characterAtIndex:0] == '<' && [test characterAtIndex:1] == '<')
-            return [[PDFDictionary alloc] initWithPDFRepresentation:rep Document:parentDocument];
+        {
+            PDFStream* stream = ([test rangeOfString:@"stream"].location != NSNotFound?[PDFObject createStreamWithPDFRepresentation:test Document:parentDocument]:nil);
+            return (stream?stream:[[PDFDictionary alloc] initWithPDFRepresentation:rep Document:parentDocument]);
+        }
         if([test characterAtIndex:0] == '[')
             return [[PDFArray alloc] initWithPDFRepresentation:rep Document:parentDocument];
     }
@@ -35,6 +53,21 @@
 }
 
 
+// The code of a stream object is its dictionary followed by the 'stream' keyword and the encoded data, which is kept undecoded until it is read.
+
++(PDFStream*)createStreamWithPDFRepresentation:(NSString*)rep Document:(PDFDocument*)parentDocument
+{
+    NSData* data = [PDFUtility dataWithObjectCode:rep];
+    PDFLexer* lexer = [[PDFLexer alloc] initWithData:data];
+    NSRange dictionaryRange = [lexer skipObject];
+    if(dictionaryRange.location == NSNotFound || [lexer token:[lexer nextToken] IsKeyword:"stream"] == NO)return nil;
+    
+    PDFDictionary* dictionary = [[PDFDictionary alloc] initWithPDFRepresentation:[lexer stringWithRange:dictionaryRange] Document:parentDocument];
+    NSRange dataRange = [lexer skipStreamDataWithLength:[PDFUtility lengthOfStreamWithDictionary:dictionary]];
+    return [[PDFStream alloc] initWithDictionary:dictionary EncodedData:[data subdataWithRange:dataRange]];
+}
+
+
 -(id)initWithPDFRepresentation:(NSString*)rep Document:(PDFDocument*)parentDocument
 {
     self = [super init];
@@ -51,6 +84,20 @@
 }
 
 
+-(id)initWithPDFRepresentationRange:(NSRange)range OfData:(NSData*)data Document:(PDFDocument*)parentDocument
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _sourceData = data;
+        _sourceRange = range;
+        _parentDocument = parentDocument;
+    }
+    
+    return self;
+}
+
+
 -(id)initWithPDFObject:(CGPDFObjectRef)obj
 {
     self = [super init];
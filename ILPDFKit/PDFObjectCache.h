@@ -0,0 +1,128 @@
+#import <Foundation/Foundation.h>
+
+
+/** The PDFObjectCache class keeps objects resolved from a document, keyed by object number and generation number.
+ Each object is stored with a cost, normally the number of bytes of its code. While the total cost of the cached objects exceeds byteBudget, the least recently used objects are evicted. Pinned objects are never evicted, so the structure every operation walks through, such as the catalog, the form dictionary and the page tree, stays resolved however many fields are read.
+
+     PDFObjectCache* cache = document.objectCache;
+     cache.byteBudget = 16*1024*1024;
+     [cache pinObjectWithNumber:rootNumber GenerationNumber:0];
+     NSLog(@"%u hits, %u misses",(unsigned int)cache.hits,(unsigned int)cache.misses);
+
+ A PDFObjectCache is thread safe.
+ */
+@interface PDFObjectCache : NSObject
+
+
+/** The total cost the cache may hold before it evicts objects. Setting it evicts objects as needed.
+ @discussion Pinned objects count towards the total but are never evicted. An object whose cost alone exceeds the budget is not cached.
+ */
+@property(nonatomic) NSUInteger byteBudget;
+
+/** The total cost of the cached objects, pinned or not.
+ */
+@property(nonatomic,readonly) NSUInteger totalCost;
+
+/** The number of cached objects.
+ */
+@property(nonatomic,readonly) NSUInteger count;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Statistics
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** The number of lookups that found an object.
+ */
+@property(nonatomic,readonly) NSUInteger hits;
+
+/** The number of lookups that found nothing.
+ */
+@property(nonatomic,readonly) NSUInteger misses;
+
+/** The number of objects evicted to stay within byteBudget.
+ */
+@property(nonatomic,readonly) NSUInteger evictions;
+
+
+/** Sets hits, misses and evictions to 0.
+ */
+-(void)resetStatistics;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Creating a PDFObjectCache
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Creates a new empty cache.
+
+ @param budget The initial byteBudget.
+ @return A new PDFObjectCache.
+ */
+-(id)initWithByteBudget:(NSUInteger)budget;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Caching Objects
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Looks up an object and marks it as the most recently used.
+
+ @param objectNumber The object number.
+ @param generationNumber The generation number.
+ @return The cached object, or nil.
+ */
+-(id)objectWithNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber;
+
+
+/** Caches an object, replacing any object with the same numbers.
+
+ @param object The object to cache.
+ @param cost The cost of the object, normally its size in bytes.
+ @param objectNumber The object number.
+ @param generationNumber The generation number.
+ */
+-(void)setObject:(id)object Cost:(NSUInteger)cost ForNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber;
+
+
+/** Removes every object and every pin.
+ @discussion A document calls this whenever its data changes, because saving may give new content to existing object numbers.
+ */
+-(void)removeAllObjects;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Pinning Objects
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Keeps an object from being evicted.
+
+ @param objectNumber The object number.
+ @param generationNumber The generation number.
+ @discussion The object need not be cached yet. It is pinned as soon as it is.
+ */
+-(void)pinObjectWithNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber;
+
+
+/** Lets a pinned object be evicted again.
+
+ @param objectNumber The object number.
+ @param generationNumber The generation number.
+ */
+-(void)unpinObjectWithNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber;
+
+
+/** Determines if an object is pinned.
+
+ @param objectNumber The object number.
+ @param generationNumber The generation number.
+ @return YES if the object is pinned.
+ */
+-(BOOL)isObjectPinnedWithNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber;
+
+
+@end
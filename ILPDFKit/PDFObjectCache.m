@@ -0,0 +1,244 @@
+#import "PDFObjectCache.h"
+
+
+/* A cached object. Unpinned entries form a list from the most to the least recently used.
+ */
+@interface PDFObjectCacheEntry : NSObject
+{
+    @public
+    NSNumber* _key;
+    id _object;
+    NSUInteger _cost;
+    BOOL _pinned;
+    __unsafe_unretained PDFObjectCacheEntry* _previous;
+    __unsafe_unretained PDFObjectCacheEntry* _next;
+}
+@end
+
+@implementation PDFObjectCacheEntry
+@end
+
+
+@interface PDFObjectCache()
+    -(void)unlinkEntry:(PDFObjectCacheEntry*)entry;
+    -(void)linkEntryAtHead:(PDFObjectCacheEntry*)entry;
+    -(void)evictToBudget;
+@end
+
+
+// Object numbers are shifted past the 16 bit generation number to form the key.
+static NSNumber* PDFObjectCacheKey(NSUInteger objectNumber, NSUInteger generationNumber)
+{
+    return @(((unsigned long long)objectNumber << 16)|(generationNumber & 0xFFFF));
+}
+
+
+@implementation PDFObjectCache
+{
+    NSMutableDictionary* _entries;
+    NSMutableSet* _pinnedKeys;
+    __unsafe_unretained PDFObjectCacheEntry* _head;
+    __unsafe_unretained PDFObjectCacheEntry* _tail;
+}
+
+
+-(id)initWithByteBudget:(NSUInteger)budget
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _byteBudget = budget;
+        _entries = [[NSMutableDictionary alloc] init];
+        _pinnedKeys = [[NSMutableSet alloc] init];
+    }
+    return self;
+}
+
+
+-(id)init
+{
+    return [self initWithByteBudget:NSUIntegerMax];
+}
+
+
+-(void)setByteBudget:(NSUInteger)byteBudget
+{
+    @synchronized(self)
+    {
+        _byteBudget = byteBudget;
+        [self evictToBudget];
+    }
+}
+
+
+-(NSUInteger)count
+{
+    @synchronized(self)
+    {
+        return [_entries count];
+    }
+}
+
+
+-(void)resetStatistics
+{
+    @synchronized(self)
+    {
+        _hits = 0;
+        _misses = 0;
+        _evictions = 0;
+    }
+}
+
+
+-(id)objectWithNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber
+{
+    NSNumber* key = PDFObjectCacheKey(objectNumber, generationNumber);
+    @synchronized(self)
+    {
+        PDFObjectCacheEntry* entry = _entries[key];
+        if(entry == nil)
+        {
+            _misses++;
+            return nil;
+        }
+
+        _hits++;
+        if(entry->_pinned == NO && entry != _head)
+        {
+            [self unlinkEntry:entry];
+            [self linkEntryAtHead:entry];
+        }
+        return entry->_object;
+    }
+}
+
+
+-(void)setObject:(id)object Cost:(NSUInteger)cost ForNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber
+{
+    if(object == nil)return;
+    NSNumber* key = PDFObjectCacheKey(objectNumber, generationNumber);
+
+    @synchronized(self)
+    {
+        PDFObjectCacheEntry* entry = _entries[key];
+        if(entry != nil)
+        {
+            if(entry->_pinned == NO)[self unlinkEntry:entry];
+            _totalCost -= entry->_cost;
+            [_entries removeObjectForKey:key];
+        }
+
+        BOOL pinned = [_pinnedKeys containsObject:key];
+
+        // Caching an object larger than the budget would only flush everything else.
+        if(pinned == NO && cost > _byteBudget)return;
+
+        entry = [[PDFObjectCacheEntry alloc] init];
+        entry->_key = key;
+        entry->_object = object;
+        entry->_cost = cost;
+        entry->_pinned = pinned;
+        _entries[key] = entry;
+        _totalCost += cost;
+        if(pinned == NO)[self linkEntryAtHead:entry];
+        [self evictToBudget];
+    }
+}
+
+
+-(void)removeAllObjects
+{
+    @synchronized(self)
+    {
+        _head = nil;
+        _tail = nil;
+        [_entries removeAllObjects];
+        [_pinnedKeys removeAllObjects];
+        _totalCost = 0;
+    }
+}
+
+
+-(void)pinObjectWithNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber
+{
+    NSNumber* key = PDFObjectCacheKey(objectNumber, generationNumber);
+    @synchronized(self)
+    {
+        [_pinnedKeys addObject:key];
+        PDFObjectCacheEntry* entry = _entries[key];
+        if(entry != nil && entry->_pinned == NO)
+        {
+            [self unlinkEntry:entry];
+            entry->_pinned = YES;
+        }
+    }
+}
+
+
+-(void)unpinObjectWithNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber
+{
+    NSNumber* key = PDFObjectCacheKey(objectNumber, generationNumber);
+    @synchronized(self)
+    {
+        [_pinnedKeys removeObject:key];
+        PDFObjectCacheEntry* entry = _entries[key];
+        if(entry != nil && entry->_pinned)
+        {
+            entry->_pinned = NO;
+            [self linkEntryAtHead:entry];
+            [self evictToBudget];
+        }
+    }
+}
+
+
+-(BOOL)isObjectPinnedWithNumber:(NSUInteger)objectNumber GenerationNumber:(NSUInteger)generationNumber
+{
+    @synchronized(self)
+    {
+        return [_pinnedKeys containsObject:PDFObjectCacheKey(objectNumber, generationNumber)];
+    }
+}
+
+
+#pragma mark - Hidden
+
+
+// The list only holds weak links. Entries are owned by the dictionary.
+
+-(void)unlinkEntry:(PDFObjectCacheEntry*)entry
+{
+    if(entry->_previous)entry->_previous->_next = entry->_next;
+    else _head = entry->_next;
+    if(entry->_next)entry->_next->_previous = entry->_previous;
+    else _tail = entry->_previous;
+    entry->_previous = nil;
+    entry->_next = nil;
+}
+
+
+-(void)linkEntryAtHead:(PDFObjectCacheEntry*)entry
+{
+    entry->_previous = nil;
+    entry->_next = _head;
+    if(_head)_head->_previous = entry;
+    _head = entry;
+    if(_tail == nil)_tail = entry;
+}
+
+
+-(void)evictToBudget
+{
+    while(_totalCost > _byteBudget && _tail != nil)
+    {
+        PDFObjectCacheEntry* entry = _tail;
+        [self unlinkEntry:entry];
+        _totalCost -= entry->_cost;
+        _evictions++;
+        [_entries removeObjectForKey:entry->_key];
+    }
+}
+
+
+@end
@@ -11,7 +11,7 @@ about, the type of the PDF object represented in str.
 As an example:
  
      NSString* dictionaryString = @"<</Key1 (value1) /Key2 (value2) /Key3 [32 /aname]>>"
-     PDFObjectParser* parser = [PDFObjectParser parserWithString:dictionaryString Parent:parentDocument];
+     PDFObjectParser* parser = [PDFObjectParser parserWithString:dictionaryString Document:parentDocument];
      NSMutableArray* keysAndValues = [NSMutableArray array];
      
      for(id token in parser)
@@ -20,6 +20,8 @@ As an example:
      }
      // From here we can extract all keys and corresponding values using the NSArray
  
+ The input is parsed by recursive descent in a single pass over its bytes. Indirect references such as '12 0 R' are recognized while parsing, and nested dictionaries and arrays are created with their contents already filled in, so no part of the input is tokenized twice.
+ 
  PDFObjectParser is not meant to replace the Core Graphics PDF functions but rather provide of means of extracting more data related to the PDF file structure such as specific object and generation numbers.
  */
 
@@ -30,4 +32,17 @@ As an example:
 -(id)initWithString:(NSString*)strg Document:(PDFDocument*)parentDocument;
 +(PDFObjectParser*)parserWithString:(NSString*)strg Document:(PDFDocument*)parentDocument;
 
+/** Creates a parser over a range of ISO Latin 1 encoded PDF code, such as the bytes of a document, without copying it.
+ @param data The PDF code.
+ @param range The range of data to parse.
+ @param parentDocument The document used to resolve indirect references.
+ @return A new PDFObjectParser.
+ */
+-(id)initWithData:(NSData*)data Range:(NSRange)range Document:(PDFDocument*)parentDocument;
+
+/** Parses the first object of the input.
+ @return The object. Dictionaries and arrays are returned as PDFDictionary and PDFArray instances with all nested objects parsed. Returns nil for null or if the input does not begin with an object.
+ */
+-(id)parseObject;
+
 @end
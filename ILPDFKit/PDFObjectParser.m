@@ -1,218 +1,229 @@
-
 #import "PDFObjectParser.h"
 #import "PDFUtility.h"
 #import "PDFDocument.h"
 #import "PDFObject.h"
+#import "PDFDictionary.h"
+#import "PDFArray.h"
+#import "PDFLexer.h"
+#import "PDFNameTable.h"
 
 
-#define isDelim(c) ((c) == '(' || (c) == ')' || (c) == '<' || (c) == '>' || (c) == '[' || (c) == ']' || (c) == '{' || (c) == '}' || (c) == '/' ||  (c) == '%')
-#define isWS(c) ((c) == 0 || (c) == 9 || (c) == 10 || (c) == 12 || (c) == 13 || (c) == 32)
-#define isODelim(c) ((c) == '(' ||  (c) == '<' ||  (c) == '[')
-#define isCDelim(c) ((c) == ')' ||  (c) == '>' ||  (c) == ']')
-
-
-typedef struct
-{
-    NSUInteger index;
-    NSUInteger nestCount;
-    NSUInteger startOfScanIndex;
-}
-PDFObjectParserState;
+// Containers nested deeper than this are treated as malformed rather than risking the stack.
+#define PDFObjectParserMaximumDepth 512
 
 
 @interface PDFObjectParser()
--(id)pdfObjectFromString:(NSString*)st;
--(id)parseNextElement:(PDFObjectParserState*)state;
+-(id)objectFromToken:(PDFToken)token;
+-(NSDictionary*)dictionaryEntries;
+-(NSArray*)arrayElements;
+-(NSNumber*)numberFromToken:(PDFToken)token;
+-(NSArray*)elements;
 @end
 
 
 @implementation PDFObjectParser
 {
-    NSString* _str;
+    PDFLexer* _lexer;
     PDFDocument* _parentDocument;
+    PDFNameTable* _names;
+    NSUInteger _depth;
+    NSArray* _elements;
 }
 
 
 +(PDFObjectParser*)parserWithString:(NSString *)strg Document:(PDFDocument*)parentDocument
 {
     return [[PDFObjectParser alloc] initWithString:strg Document:parentDocument];
-    
+
 }
 
 -(id)initWithString:(NSString *)strg Document:(PDFDocument*)parentDocument
+{
+    NSData* data = [PDFUtility dataWithObjectCode:strg];
+    return [self initWithData:data Range:NSMakeRange(0, [data length]) Document:parentDocument];
+}
+
+-(id)initWithData:(NSData*)data Range:(NSRange)range Document:(PDFDocument*)parentDocument
 {
     self = [super init];
     if(self!=nil)
     {
-      
         _parentDocument = parentDocument;
-        
-        if([strg characterAtIndex:0]=='<')
-        {
-            _str = [strg substringWithRange:NSMakeRange(1, strg.length-2)] ;
-        }
-        else _str = strg;
-        
-        if(_str)
-        {
-            
-            //Here we replace indirect object references with a representation that is more easily parsed on the next step.
-            NSRegularExpression* regex = [[NSRegularExpression alloc] initWithPattern:@"(\\d+)\\s+(\\d+)\\s+[R]\\W" options:0 error:NULL];
-            _str = [regex stringByReplacingMatchesInString:_str options:0 range:NSMakeRange(0, _str.length) withTemplate:@"($1,$2,ioref)"];
-        }
-        
+        _names = [PDFNameTable tableForDocument:parentDocument];
+        _lexer = [[PDFLexer alloc] initWithData:data Range:range];
     }
     return self;
 }
 
--(id)parseNextElement:(PDFObjectParserState*)state
+
+-(id)parseObject
+{
+    id ret = [self objectFromToken:[_lexer nextToken]];
+    return ([ret isKindOfClass:[NSNull class]]?nil:ret);
+}
+
+
+#pragma mark - Hidden
+
+
+// Returns NSNull for the null object and nil for anything that is not the start of an object.
+
+-(id)objectFromToken:(PDFToken)token
 {
-    NSUInteger index = state->index;
-    NSUInteger nestCount = state -> nestCount;
-    NSUInteger startOfScanIndex = state -> startOfScanIndex;
-    id ret = nil;
-    
-    while(index < _str.length)
+    switch(token.type)
     {
-    
-        NSRange range = {0,0};
-        
-        unichar cur = [_str characterAtIndex:index];
-        
-        BOOL found = NO;
-        BOOL ws = isWS(cur);
-        BOOL od = isODelim(cur);
-        BOOL cd = isCDelim(cur);
-        BOOL dl = isDelim(cur);
-        if(od)nestCount++;
-        if(cd)nestCount--;
-        
-        if(startOfScanIndex == 0)
+        case PDFTokenTypeNumber:
         {
-            if(ws == NO && (nestCount-od) == 1)startOfScanIndex = index;
-        }
-        else
-        {
-
-            range.location = startOfScanIndex;
-            range.length = index - startOfScanIndex;
-            found = YES;
-            
-            if(nestCount == 1 && (ws||cd))
+            NSUInteger afterNumber = _lexer.position;
+            PDFToken generationToken = [_lexer nextToken];
+            if(generationToken.type == PDFTokenTypeNumber && [_lexer token:[_lexer nextToken] IsKeyword:"R"])
             {
-                startOfScanIndex = 0;
-                range.length+=cd;
+                return [[PDFObject alloc] initWithObjectNumber:[_lexer integerValueOfToken:token] GenerationNumber:[_lexer integerValueOfToken:generationToken] Document:_parentDocument];
             }
-            else if(((nestCount <= 1) && dl)||(nestCount == 2 && od))
-            {
-                startOfScanIndex = index; 
-            }
-            else found = NO;
+            _lexer.position = afterNumber;
+            return [self numberFromToken:token];
+        }
+        case PDFTokenTypeName:
+            return [_names atomForBytes:(const char*)_lexer.bytes+token.offset+1 Length:token.length-1];
+        case PDFTokenTypeString:
+        {
+            // Strings are returned as they appear in the file, without their enclosing parentheses.
+            BOOL terminated = (token.length >= 2 && _lexer.bytes[token.offset+token.length-1] == ')');
+            return [_lexer stringWithRange:NSMakeRange(token.offset+1, token.length-1-terminated)];
+        }
+        case PDFTokenTypeHexString:
+        {
+            BOOL terminated = (token.length >= 2 && _lexer.bytes[token.offset+token.length-1] == '>');
+            return [_lexer.data subdataWithRange:NSMakeRange(token.offset+1, token.length-1-terminated)];
+        }
+        case PDFTokenTypeDictionaryOpen:
+        {
+            if(_depth >= PDFObjectParserMaximumDepth)return nil;
+            _depth++;
+            NSDictionary* entries = [self dictionaryEntries];
+            _depth--;
+            return [[PDFDictionary alloc] initWithEntries:entries PDFRepresentationRange:NSMakeRange(token.offset, _lexer.position-token.offset) OfData:_lexer.data Document:_parentDocument];
+        }
+        case PDFTokenTypeArrayOpen:
+        {
+            if(_depth >= PDFObjectParserMaximumDepth)return nil;
+            _depth++;
+            NSArray* elements = [self arrayElements];
+            _depth--;
+            return [[PDFArray alloc] initWithElements:elements PDFRepresentationRange:NSMakeRange(token.offset, _lexer.position-token.offset) OfData:_lexer.data Document:_parentDocument];
         }
-        
-        index++;
-            
-        if(found)
+        case PDFTokenTypeProcedureOpen:
         {
-            ret =  [self pdfObjectFromString:[_str substringWithRange:range]];
-            break;
+            _lexer.position = token.offset;
+            NSRange range = [_lexer skipObject];
+            if(range.location == NSNotFound)return nil;
+            return [[PDFObject alloc] initWithPDFRepresentationRange:range OfData:_lexer.data Document:_parentDocument];
         }
-        
+        case PDFTokenTypeKeyword:
+            if([_lexer token:token IsKeyword:"true"])return @YES;
+            if([_lexer token:token IsKeyword:"false"])return @NO;
+            if([_lexer token:token IsKeyword:"null"])return [NSNull null];
+            return [[PDFObject alloc] initWithPDFRepresentationRange:NSMakeRange(token.offset, token.length) OfData:_lexer.data Document:_parentDocument];
+        default:
+            return nil;
     }
-    
-    state->index = index;
-    state->nestCount = nestCount;
-    state->startOfScanIndex = startOfScanIndex;
-    return ret;
 }
 
-// the string passed musn't include an indirect object definition header. eg ' 7 0 obj '
 
--(id)pdfObjectFromString:(NSString*)st
+-(NSDictionary*)dictionaryEntries
 {
-    
-    NSString* work = [st stringByTrimmingCharactersInSet:[PDFUtility whiteSpaceCharacterSet]];
-    
-    if([work rangeOfString:@"ioref"].location!= NSNotFound)
+    NSMutableDictionary* ret = [NSMutableDictionary dictionary];
+
+    while(YES)
     {
-        NSArray* tokens = [[work substringWithRange:NSMakeRange(1, work.length-1)] componentsSeparatedByString:@","];
-        PDFObject* ret = [[PDFObject alloc] initWithObjectNumber:[tokens[0] integerValue] GenerationNumber:[tokens[1] integerValue] Document:_parentDocument];
-      
-      
-        return ret;
+        PDFToken key = [_lexer nextToken];
+        if(key.type == PDFTokenTypeEnd || key.type == PDFTokenTypeDictionaryClose)break;
+        if(key.type != PDFTokenTypeName)continue;
+
+        PDFToken valueToken = [_lexer nextToken];
+        if(valueToken.type == PDFTokenTypeEnd || valueToken.type == PDFTokenTypeDictionaryClose)break;
+
+        // A null value is equivalent to the key being absent.
+        id value = [self objectFromToken:valueToken];
+        if(value != nil && [value isKindOfClass:[NSNull class]] == NO)
+        {
+            ret[[_names atomForBytes:(const char*)_lexer.bytes+key.offset+1 Length:key.length-1]] = value;
+        }
     }
 
-    if([work characterAtIndex:0] == '(' && [work characterAtIndex:work.length-1] == ')')
-        return [work substringWithRange:NSMakeRange(1, work.length-2)]; // String
-    
-    if([work characterAtIndex:0] == '<' && [work characterAtIndex:work.length-1] == '>' && [work characterAtIndex:1] != '<')
-        return [[work substringWithRange:NSMakeRange(1, work.length-2)] dataUsingEncoding:NSUTF8StringEncoding]; // HexString
-    
-    if([work characterAtIndex:0] == '/')
-        return [work substringWithRange:NSMakeRange(1, work.length-1)]; // Name
-    
-    if( [work rangeOfCharacterFromSet:[[NSCharacterSet characterSetWithCharactersInString:@"0987654321+-."] invertedSet]].location == NSNotFound) // Real or Integer
+    return ret;
+}
+
+
+-(NSArray*)arrayElements
+{
+    NSMutableArray* ret = [NSMutableArray array];
+
+    while(YES)
     {
-        NSNumberFormatter * f = [[NSNumberFormatter alloc] init];
-        [f setNumberStyle:NSNumberFormatterDecimalStyle];
-        NSNumber * rn = [f numberFromString:work];
-        return rn;
+        PDFToken token = [_lexer nextToken];
+        if(token.type == PDFTokenTypeEnd || token.type == PDFTokenTypeArrayClose)break;
+
+        id element = [self objectFromToken:token];
+        if(element != nil && [element isKindOfClass:[NSNull class]] == NO)[ret addObject:element];
     }
-    
-    //Boolean
-    
-    if([work isEqualToString:@"true"])return @YES;
-    if([work isEqualToString:@"false"])return @NO;
-    if([work isEqualToString:@"null"])return nil;
-    
-    return [PDFObject createWithPDFRepresentation:work Document:_parentDocument];
-    
-    
+
+    return ret;
 }
 
-#pragma mark - NSFastEnumeration
 
+-(NSNumber*)numberFromToken:(PDFToken)token
+{
+    if(memchr(_lexer.bytes+token.offset, '.', token.length) != NULL)return @([_lexer realValueOfToken:token]);
+    return @([_lexer integerValueOfToken:token]);
+}
 
-    
-- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state objects:(id __unsafe_unretained [])stackbuf count:(NSUInteger)len;
+
+// The elements enumerated are the contents of the outermost container, flattened to alternating keys and values for a dictionary.
+
+-(NSArray*)elements
 {
-    PDFObjectParserState parserState;
-    
-    if(state->state == 0)
-    {
-        parserState.index = 0;
-        parserState.nestCount = 0;
-        parserState.startOfScanIndex = 0;
-        
-    }
-    else
+    if(_elements == nil)
     {
-        parserState.index = (NSUInteger)(state->state);
-        parserState.nestCount = (NSUInteger)((state->extra)[0]);
-        parserState.startOfScanIndex = (NSUInteger)((state->extra)[1]);
-        
-    }
-    
+        NSMutableArray* temp = [NSMutableArray array];
+        PDFToken token = [_lexer nextToken];
 
-    NSUInteger batchCount = 0;
-    while (parserState.index < _str.length && batchCount < len)
-    {
-        id obj = [self parseNextElement:&parserState];
-        if(obj)
+        if(token.type == PDFTokenTypeDictionaryOpen)
         {
-            stackbuf[batchCount] = obj;
-            batchCount++;
+            NSDictionary* entries = [self dictionaryEntries];
+            for(NSString* key in entries)
+            {
+                [temp addObject:key];
+                [temp addObject:entries[key]];
+            }
+        }
+        else if(token.type == PDFTokenTypeArrayOpen)
+        {
+            [temp addObjectsFromArray:[self arrayElements]];
+        }
+        else
+        {
+            while(token.type != PDFTokenTypeEnd)
+            {
+                id obj = [self objectFromToken:token];
+                if(obj != nil && [obj isKindOfClass:[NSNull class]] == NO)[temp addObject:obj];
+                token = [_lexer nextToken];
+            }
         }
+
+        _elements = [NSArray arrayWithArray:temp];
     }
-    
-    state->state = (unsigned long)parserState.index;
-    ((state->extra)[0]) = (unsigned long)parserState.nestCount;
-    ((state->extra)[1]) = (unsigned long)parserState.startOfScanIndex;
-    
-//    state->itemsPtr = (__unsafe_unretained)stackbuf;
-//    state->mutationsPtr = (__bridge unsigned long *)self;
-    
-    return batchCount;
+
+    return _elements;
+}
+
+#pragma mark - NSFastEnumeration
+
+
+
+- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state objects:(id __unsafe_unretained [])stackbuf count:(NSUInteger)len;
+{
+    return [[self elements] countByEnumeratingWithState:state objects:stackbuf count:len];
 }
 
 
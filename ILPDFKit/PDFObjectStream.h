@@ -0,0 +1,62 @@
+#import <Foundation/Foundation.h>
+
+@class PDFDictionary;
+
+
+/** The PDFObjectStream class represents a decoded PDF 1.5 object stream.
+ An object stream packs the definitions of several indirect objects into a single compressed stream. PDFObjectStream holds the inflated data of one such stream together with the offsets of the objects it contains, so any number of objects can be read from it after a single decode.
+ 
+     PDFObjectStream* objectStream = [[PDFObjectStream alloc] initWithData:decodedData Dictionary:streamDictionary];
+     NSString* code = [objectStream codeForObjectAtIndex:3];
+ 
+ A PDFDocument keeps the object streams it has decoded, keyed by object number, until its data changes.
+ */
+@interface PDFObjectStream : NSObject
+
+
+/** The decoded data of the stream.
+ */
+@property(nonatomic,readonly) NSData* data;
+
+
+/** The number of objects in the stream.
+ */
+@property(nonatomic,readonly) NSUInteger count;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Creating a PDFObjectStream
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Creates a new instance of PDFObjectStream.
+ 
+ @param data The decoded stream data.
+ @param dictionary The stream dictionary, which must define the 'N' and 'First' entries.
+ @return A new PDFObjectStream, or nil if the header of data could not be read.
+ */
+-(id)initWithData:(NSData*)data Dictionary:(PDFDictionary*)dictionary;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Reading Objects
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Returns the object number of an object in the stream.
+ 
+ @param index The index of the object in the stream.
+ @return The object number, or NSNotFound if index is out of bounds.
+ */
+-(NSUInteger)objectNumberAtIndex:(NSUInteger)index;
+
+
+/** Returns the code of an object in the stream.
+ 
+ @param index The index of the object in the stream.
+ @return The PDF code of the object, or nil if index is out of bounds. Objects in object streams have no 'obj' and 'endobj' keywords, so the code is directly comparable to the result of [PDFDocument codeForObjectWithNumber:GenerationNumber:].
+ */
+-(NSString*)codeForObjectAtIndex:(NSUInteger)index;
+
+
+@end
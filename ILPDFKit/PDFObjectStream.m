@@ -0,0 +1,80 @@
+
+#import "PDFObjectStream.h"
+#import "PDFDictionary.h"
+#import "PDFLexer.h"
+
+
+@implementation PDFObjectStream
+{
+    NSUInteger* _objectNumbers;
+    NSUInteger* _offsets;
+}
+
+
+-(void)dealloc
+{
+    free(_objectNumbers);
+    free(_offsets);
+}
+
+
+-(id)initWithData:(NSData*)data Dictionary:(PDFDictionary*)dictionary
+{
+    self = [super init];
+    if(self != nil)
+    {
+        NSInteger count = [[dictionary objectForKey:@"N"] integerValue];
+        NSUInteger first = [[dictionary objectForKey:@"First"] unsignedIntegerValue];
+        if(first > [data length])return nil;
+        
+        // Each pair of the header takes at least four bytes, two digits and two separators, the last of which may be missing, so a larger 'N' is malformed.
+        if(count < 0 || (NSUInteger)count > (first+1)/4)return nil;
+        
+        _data = data;
+        _objectNumbers = malloc(MAX(count,1)*sizeof(NSUInteger));
+        _offsets = malloc(MAX(count,1)*sizeof(NSUInteger));
+        if(_objectNumbers == NULL || _offsets == NULL)return nil;
+        
+        // The header is a sequence of N pairs of integers: the object number and the offset of the object relative to 'First'.
+        PDFLexer* lexer = [[PDFLexer alloc] initWithData:data Range:NSMakeRange(0, first)];
+        
+        for(NSUInteger i = 0 ; i < count ; i++)
+        {
+            PDFToken numberToken = [lexer nextToken];
+            PDFToken offsetToken = [lexer nextToken];
+            if(numberToken.type != PDFTokenTypeNumber || offsetToken.type != PDFTokenTypeNumber)return nil;
+            
+            NSInteger objectNumber = [lexer integerValueOfToken:numberToken];
+            NSInteger offset = [lexer integerValueOfToken:offsetToken];
+            if(objectNumber < 0 || offset < 0)return nil;
+            
+            _objectNumbers[i] = objectNumber;
+            _offsets[i] = MIN(first+MIN((NSUInteger)offset, [data length]), [data length]);
+        }
+        
+        _count = count;
+    }
+    
+    return self;
+}
+
+
+-(NSUInteger)objectNumberAtIndex:(NSUInteger)index
+{
+    if(index >= _count)return NSNotFound;
+    return _objectNumbers[index];
+}
+
+
+-(NSString*)codeForObjectAtIndex:(NSUInteger)index
+{
+    if(index >= _count)return nil;
+    
+    // Objects are normally stored in increasing offset order, but the next offset is only a bound, so never let it precede the start.
+    NSUInteger start = _offsets[index];
+    NSUInteger end = (index+1 < _count?MAX(_offsets[index+1], start):[_data length]);
+    return [[NSString alloc] initWithBytes:(const char*)[_data bytes]+start length:end-start encoding:NSISOLatin1StringEncoding];
+}
+
+
+@end
@@ -0,0 +1,30 @@
+#import <Foundation/Foundation.h>
+
+@class PDFFormContainer;
+
+
+/** The PDFScriptEngine protocol is adopted by objects that run the JavaScript actions of a document's forms.
+ A PDFFormContainer hands every script to its scriptEngine, so the interpreter can be replaced, for example by an embedded interpreter on platforms without JavaScriptCore, or by an engine that records scripts for testing. PDFJavaScriptEngine is the default.
+ 
+ An engine exposes the subset of the Acrobat JavaScript API supported by the kit:
+ 
+ - getField(cName): The field called cName, or null. A field has the properties name, type, value, items and numItems, and the methods clearItems(), insertItemAt(cName,nIdx) and setAction(cTrigger,cScript).
+ - event: An object whose value is the document value for the key 'EventValue' and whose willCommit is true. When the script finishes, event.value is stored back as the document value for 'EventValue', which is how calculation scripts return their result.
+ - submitForm(param): Stores the entries of param, formatted as 'key:value;' pairs, as the document value for the key 'SubmitForm'.
+ - print(param) and getPrintParams(): No operation.
+ 
+ Field objects must read values with valueForFormWithName: and write them with setValue:ForFormWithName:, so a script only touches the fields it accesses and the container can track which fields each calculation depends on. Engines must allow evaluateScript:WithForms: to be called again while a script is running.
+ */
+@protocol PDFScriptEngine <NSObject>
+
+
+/** Runs a script.
+ 
+ @param script The JavaScript code.
+ @param container The forms the script can access.
+ @return YES if the script ran to completion, NO if it raised an exception.
+ */
+-(BOOL)evaluateScript:(NSString*)script WithForms:(PDFFormContainer*)container;
+
+
+@end
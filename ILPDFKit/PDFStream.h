@@ -5,7 +5,7 @@
 
 
 /** The PDFStream class encapsulates a PDF stream object contained in a PDFDocument.
- Essentially, is is a wrapper class for a CGPDFStreamRef.
+ It wraps either a CGPDFStreamRef or a stream read directly from the file, whose data is decoded by PDFStreamDecoder.
  
     CGPDFStreamRef pdfSRef = myCGPDFStreamRef;
     PDFStream* pdfStream = [[PDFStream alloc] initWithStream:pdfSRef];
@@ -15,6 +15,7 @@
 
 
 @class PDFDictionary;
+@class PDFStreamDecoder;
 
 @interface PDFStream : PDFObject
 
@@ -46,6 +47,38 @@
 -(id)initWithStream:(CGPDFStreamRef)pstrm;
 
 
+/** Creates a new instance of PDFStream from a stream read directly from the file.
+ 
+ @param dictionary The stream dictionary.
+ @param data The encoded stream data, as it appears between the 'stream' and 'endstream' keywords.
+ @return A new PDFStream object.
+ @discussion The data is decoded when it is first read. A final DCTDecode or JPXDecode filter is left in place and reflected by dataFormat.
+ */
+-(id)initWithDictionary:(PDFDictionary*)dictionary EncodedData:(NSData*)data;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Reading Part of the Data
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Creates a decoder positioned at the start of the stream content.
+ 
+ @return A new PDFStreamDecoder, or nil if the stream uses a filter that is not supported.
+ @discussion A stream wrapping a CGPDFStreamRef can only be decoded as a whole, so its decoder reads the decoded data.
+ */
+-(PDFStreamDecoder*)decoder;
+
+
+/** Decodes the start of the stream content.
+ 
+ @param length The maximum number of bytes to decode.
+ @return Up to length bytes of data, or nil if the stream could not be decoded.
+ @discussion Only as much of a stream read from the file is decoded as is returned.
+ */
+-(NSData*)dataWithMaximumLength:(NSUInteger)length;
+
+
 
 @end
 
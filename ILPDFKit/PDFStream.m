@@ -2,11 +2,21 @@
 
 #import "PDFStream.h"
 #import "PDFDictionary.h"
+#import "PDFArray.h"
+#import "PDFNameTable.h"
+#import "PDFStreamDecoder.h"
+
+@interface PDFStream()
+    -(void)readFilters;
+@end
 
 @implementation PDFStream
 {
     CGPDFStreamRef _strm;
     NSData* _data;
+    NSData* _encodedData;
+    NSArray* _filters;
+    NSArray* _decodeParameters;
     PDFDictionary* _dictionary;
     CGPDFDataFormat _dataFormat;
 }
@@ -24,11 +34,25 @@
     return self;
 }
 
+
+-(id)initWithDictionary:(PDFDictionary*)dictionary EncodedData:(NSData*)data
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _dictionary = dictionary;
+        _encodedData = data;
+        [self readFilters];
+    }
+    
+    return self;
+}
+
 #pragma mark - Getter
 
 -(PDFDictionary*)dictionary
 {
-    if(_dictionary == nil)
+    if(_dictionary == nil && _strm != NULL)
     {
         CGPDFDictionaryRef dict = CGPDFStreamGetDictionary(_strm);
         if(dict)
@@ -40,6 +64,12 @@
 }
 
 - (void)_readData {
+    if(_strm == NULL)
+    {
+        _data = [[self decoder] readDataOfMaximumLength:NSNotFound];
+        return;
+    }
+    
     CFDataRef dat = CGPDFStreamCopyData(_strm, &_dataFormat);
     _data = ((__bridge NSData*)dat);
     CFRelease(dat);
@@ -48,7 +78,7 @@
 
 -(CGPDFDataFormat)dataFormat
 {
-    if(_data == nil)
+    if(_data == nil && _strm != NULL)
     {
         [self _readData];
     }
@@ -66,4 +96,47 @@
     return _data;
 }
 
+#pragma mark - Reading Part of the Data
+
+-(PDFStreamDecoder*)decoder
+{
+    if(_strm != NULL)
+    {
+        NSData* data = self.data;
+        return (data?[[PDFStreamDecoder alloc] initWithData:data Filters:nil DecodeParameters:nil]:nil);
+    }
+    
+    return [[PDFStreamDecoder alloc] initWithData:_encodedData Filters:_filters DecodeParameters:_decodeParameters];
+}
+
+
+-(NSData*)dataWithMaximumLength:(NSUInteger)length
+{
+    if(_data == nil && _strm != NULL)[self _readData];
+    if(_data != nil)return ([_data length] > length?[_data subdataWithRange:NSMakeRange(0, length)]:_data);
+    
+    return [[self decoder] readDataOfMaximumLength:length];
+}
+
+#pragma mark - Hidden
+
+// Image filters are not decoded. The filters before them are, and dataFormat tells the caller how to read the rest.
+
+-(void)readFilters
+{
+    id filter = [_dictionary objectForKey:PDFNameFilter];
+    id parameters = [_dictionary objectForKey:PDFNameDecodeParms];
+    NSMutableArray* filters = [NSMutableArray arrayWithArray:([filter isKindOfClass:[PDFArray class]]?[filter nsa]:(filter?@[filter]:@[]))];
+    NSArray* parameterList = ([parameters isKindOfClass:[PDFArray class]]?[parameters nsa]:(parameters?@[parameters]:@[]));
+    
+    _dataFormat = CGPDFDataFormatRaw;
+    NSString* last = [filters lastObject];
+    if([last isEqual:@"DCTDecode"] || [last isEqual:@"DCT"])_dataFormat = CGPDFDataFormatJPEGEncoded;
+    else if([last isEqual:@"JPXDecode"])_dataFormat = CGPDFDataFormatJPEG2000;
+    if(_dataFormat != CGPDFDataFormatRaw)[filters removeLastObject];
+    
+    _filters = filters;
+    _decodeParameters = parameterList;
+}
+
 @end
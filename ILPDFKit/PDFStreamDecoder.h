@@ -0,0 +1,86 @@
+#import <Foundation/Foundation.h>
+
+@class PDFDictionary;
+
+
+/** The PDFStreamDecoder class decodes the data of a PDF stream incrementally.
+ The FlateDecode, LZWDecode, ASCIIHexDecode, ASCII85Decode and RunLengthDecode filters are supported, with their abbreviated names, as are the PNG and TIFF predictors of FlateDecode and LZWDecode. Filters are chained in the order the stream lists them.
+
+ Each filter pulls bytes from the one before it through a fixed size buffer taken from a shared pool, and returns the buffer when the decoder is released. Only as much of the stream as is read is decoded, so reading a prefix of a large stream is cheap and decoding any stream uses a constant amount of memory.
+
+     PDFStreamDecoder* decoder = [[PDFStreamDecoder alloc] initWithData:encodedData Dictionary:streamDictionary];
+     char buffer[512];
+     NSInteger length = [decoder readBytes:buffer MaxLength:sizeof(buffer)];
+ */
+@interface PDFStreamDecoder : NSObject
+
+
+/** YES if a read failed because the data is corrupt. Once set, every read returns -1.
+ */
+@property(nonatomic,readonly) BOOL failed;
+
+/** YES once every decoded byte has been read.
+ */
+@property(nonatomic,readonly) BOOL atEnd;
+
+/** The number of decoded bytes read so far.
+ */
+@property(nonatomic,readonly) NSUInteger numberOfBytesRead;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Creating a PDFStreamDecoder
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Creates a new decoder for the data of a stream.
+
+ @param data The encoded stream data, as it appears between the 'stream' and 'endstream' keywords. It is retained, not copied.
+ @param dictionary The stream dictionary, whose 'Filter' and 'DecodeParms' entries describe the encoding.
+ @return A new PDFStreamDecoder, or nil if the stream uses a filter that is not supported.
+ */
+-(id)initWithData:(NSData*)data Dictionary:(PDFDictionary*)dictionary;
+
+
+/** Creates a new decoder for data encoded with a list of filters.
+
+ @param data The encoded data. It is retained, not copied.
+ @param filters The names of the filters, in the order they were applied when the data was read. May be empty.
+ @param parameters The decode parameters of each filter, as PDFDictionary or NSNull. May be shorter than filters, or nil.
+ @return A new PDFStreamDecoder, or nil if a filter is not supported.
+ */
+-(id)initWithData:(NSData*)data Filters:(NSArray*)filters DecodeParameters:(NSArray*)parameters;
+
+
+/** Determines if a filter can be decoded.
+
+ @param name The name of the filter, such as 'FlateDecode' or 'AHx'.
+ @return YES if the filter is supported.
+ */
++(BOOL)supportsFilter:(NSString*)name;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Reading
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Decodes bytes into a buffer.
+
+ @param buffer The destination.
+ @param length The size of buffer.
+ @return The number of bytes decoded, which is less than length only at the end of the data. 0 at the end of the data, or -1 if the data is corrupt.
+ @discussion A truncated Flate stream ends after the last byte that could be inflated, as most readers allow.
+ */
+-(NSInteger)readBytes:(void*)buffer MaxLength:(NSUInteger)length;
+
+
+/** Decodes up to a number of bytes.
+
+ @param length The maximum number of bytes to decode, or NSNotFound to decode the rest of the data.
+ @return The decoded bytes, or nil if the data is corrupt.
+ */
+-(NSData*)readDataOfMaximumLength:(NSUInteger)length;
+
+
+@end
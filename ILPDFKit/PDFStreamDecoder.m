@@ -0,0 +1,720 @@
+#import "PDFStreamDecoder.h"
+#import "PDFDictionary.h"
+#import "PDFArray.h"
+#import "PDFNameTable.h"
+#include <pthread.h>
+#import <zlib.h>
+
+// Every stage reads from and writes to buffers of this many bytes.
+#define PDFStreamDecoderBufferSize 16384
+
+// Up to this many released buffers are kept for the next decoder.
+#define PDFStreamDecoderPoolCapacity 16
+
+// LZW codes are at most 12 bits wide, and no string is longer than the table.
+#define PDFStreamDecoderLZWTableSize 4096
+
+
+typedef enum PDFStreamDecoderFilter
+{
+    PDFStreamDecoderFilterFlate = 0,
+    PDFStreamDecoderFilterLZW,
+    PDFStreamDecoderFilterASCIIHex,
+    PDFStreamDecoderFilterASCII85,
+    PDFStreamDecoderFilterRunLength,
+    PDFStreamDecoderFilterPredictor
+
+} PDFStreamDecoderFilter;
+
+
+/* One filter of a chain. The first stage reads the encoded data in place. Every other stage reads the output of its source through its own input buffer.
+ */
+typedef struct PDFStreamDecoderStage
+{
+    PDFStreamDecoderFilter filter;
+    struct PDFStreamDecoderStage* source;
+
+    const unsigned char* input;
+    unsigned char* inputBuffer;
+    NSUInteger inputStart;
+    NSUInteger inputEnd;
+    BOOL inputEnded;
+
+    unsigned char* output;
+    unsigned char* outputBuffer;
+    NSUInteger outputStart;
+    NSUInteger outputEnd;
+    BOOL ended;
+
+    z_stream zstream;
+    BOOL zstreamInitialized;
+
+    int nibble;
+
+    unsigned char group[5];
+    NSUInteger groupCount;
+
+    uint16_t* prefixes;
+    unsigned char* suffixes;
+    unsigned char* firsts;
+    uint16_t* lengths;
+    NSUInteger nextCode;
+    NSUInteger codeWidth;
+    NSInteger previousCode;
+    NSUInteger earlyChange;
+    uint32_t bits;
+    NSUInteger bitCount;
+
+    NSInteger predictor;
+    NSUInteger bytesPerPixel;
+    NSUInteger rowLength;
+    NSUInteger rowFill;
+    unsigned char* row;
+    unsigned char* previousRow;
+}
+PDFStreamDecoderStage;
+
+
+static NSInteger PDFStreamDecoderRead(PDFStreamDecoderStage* stage, unsigned char* buffer, NSUInteger length);
+
+
+#pragma mark - Buffer Pool
+
+
+static unsigned char* PDFStreamDecoderPool[PDFStreamDecoderPoolCapacity];
+static NSUInteger PDFStreamDecoderPoolCount = 0;
+static pthread_mutex_t PDFStreamDecoderPoolLock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static unsigned char* PDFStreamDecoderTakeBuffer(void)
+{
+    unsigned char* ret = NULL;
+    pthread_mutex_lock(&PDFStreamDecoderPoolLock);
+    if(PDFStreamDecoderPoolCount > 0)ret = PDFStreamDecoderPool[--PDFStreamDecoderPoolCount];
+    pthread_mutex_unlock(&PDFStreamDecoderPoolLock);
+    return (ret?ret:malloc(PDFStreamDecoderBufferSize));
+}
+
+
+static void PDFStreamDecoderReturnBuffer(unsigned char* buffer)
+{
+    if(buffer == NULL)return;
+    pthread_mutex_lock(&PDFStreamDecoderPoolLock);
+    if(PDFStreamDecoderPoolCount < PDFStreamDecoderPoolCapacity)
+    {
+        PDFStreamDecoderPool[PDFStreamDecoderPoolCount++] = buffer;
+        buffer = NULL;
+    }
+    pthread_mutex_unlock(&PDFStreamDecoderPoolLock);
+    free(buffer);
+}
+
+
+#pragma mark - Input
+
+
+// Returns the number of input bytes available, reading more from the source when none are left. 0 at the end of the input, -1 if the source failed.
+static NSInteger PDFStreamDecoderFillInput(PDFStreamDecoderStage* stage)
+{
+    if(stage->inputStart < stage->inputEnd)return stage->inputEnd-stage->inputStart;
+    if(stage->inputEnded)return 0;
+
+    NSInteger count = PDFStreamDecoderRead(stage->source, stage->inputBuffer, PDFStreamDecoderBufferSize);
+    if(count < 0)return -1;
+    stage->inputStart = 0;
+    stage->inputEnd = count;
+    if(count == 0)stage->inputEnded = YES;
+    return count;
+}
+
+
+// The next input byte, -1 at the end of the input or -2 if the source failed.
+static int PDFStreamDecoderNextByte(PDFStreamDecoderStage* stage)
+{
+    NSInteger available = PDFStreamDecoderFillInput(stage);
+    if(available <= 0)return (available == 0?-1:-2);
+    return stage->input[stage->inputStart++];
+}
+
+
+static BOOL PDFStreamDecoderIsWhiteSpace(int c)
+{
+    return (c == 0 || c == 9 || c == 10 || c == 12 || c == 13 || c == 32);
+}
+
+
+#pragma mark - Filters
+
+
+// Each filter decodes into the empty output of its stage until it has produced some bytes, reached the end of its data or failed.
+
+static BOOL PDFStreamDecoderInflate(PDFStreamDecoderStage* stage)
+{
+    z_stream* z = &stage->zstream;
+    while(stage->outputEnd == 0 && stage->ended == NO)
+    {
+        NSInteger available = PDFStreamDecoderFillInput(stage);
+        if(available < 0)return NO;
+
+        z->next_in = (Bytef*)stage->input+stage->inputStart;
+        z->avail_in = (uInt)available;
+        z->next_out = stage->output;
+        z->avail_out = PDFStreamDecoderBufferSize;
+        int status = inflate(z, Z_NO_FLUSH);
+        stage->inputStart += available-z->avail_in;
+        stage->outputEnd = PDFStreamDecoderBufferSize-z->avail_out;
+
+        if(status == Z_STREAM_END)stage->ended = YES;
+        else if(status == Z_BUF_ERROR && available == 0)
+        {
+            // Truncated streams are common, so whatever was inflated before the input ran out is kept.
+            if(z->total_out == 0)return NO;
+            stage->ended = YES;
+        }
+        else if(status != Z_OK && status != Z_BUF_ERROR)return NO;
+    }
+    return YES;
+}
+
+
+static BOOL PDFStreamDecoderDecodeLZW(PDFStreamDecoderStage* stage)
+{
+    // Room is kept for the longest string a single code can produce.
+    while(stage->ended == NO && stage->outputEnd+PDFStreamDecoderLZWTableSize <= PDFStreamDecoderBufferSize)
+    {
+        while(stage->bitCount < stage->codeWidth)
+        {
+            int byte = PDFStreamDecoderNextByte(stage);
+            if(byte == -2)return NO;
+            if(byte == -1)break;
+            stage->bits = (stage->bits << 8)|(uint32_t)byte;
+            stage->bitCount += 8;
+        }
+
+        // A missing end of data code is tolerated.
+        if(stage->bitCount < stage->codeWidth)
+        {
+            stage->ended = YES;
+            break;
+        }
+
+        NSUInteger code = (stage->bits >> (stage->bitCount-stage->codeWidth))&((1 << stage->codeWidth)-1);
+        stage->bitCount -= stage->codeWidth;
+
+        if(code == 256)
+        {
+            stage->nextCode = 258;
+            stage->codeWidth = 9;
+            stage->previousCode = -1;
+            continue;
+        }
+        if(code == 257)
+        {
+            stage->ended = YES;
+            break;
+        }
+
+        if(stage->previousCode < 0)
+        {
+            if(code > 255)return NO;
+            stage->output[stage->outputEnd++] = (unsigned char)code;
+            stage->previousCode = code;
+            continue;
+        }
+
+        // A code one past the table is the previous string followed by its own first byte.
+        if(code > stage->nextCode || (code == stage->nextCode && stage->nextCode >= PDFStreamDecoderLZWTableSize))return NO;
+        NSUInteger previous = stage->previousCode;
+        if(stage->nextCode < PDFStreamDecoderLZWTableSize)
+        {
+            NSUInteger next = stage->nextCode;
+            stage->prefixes[next] = (uint16_t)previous;
+            stage->suffixes[next] = stage->firsts[(code < next?code:previous)];
+            stage->firsts[next] = stage->firsts[previous];
+            stage->lengths[next] = stage->lengths[previous]+1;
+            stage->nextCode++;
+            if(stage->nextCode+stage->earlyChange >= (NSUInteger)(1 << stage->codeWidth) && stage->codeWidth < 12)stage->codeWidth++;
+        }
+
+        NSUInteger length = stage->lengths[code];
+        NSUInteger c = code;
+        for(NSUInteger i = length ; i > 0 ; i--)
+        {
+            stage->output[stage->outputEnd+i-1] = stage->suffixes[c];
+            c = stage->prefixes[c];
+        }
+        stage->outputEnd += length;
+        stage->previousCode = code;
+    }
+    return YES;
+}
+
+
+static BOOL PDFStreamDecoderDecodeASCIIHex(PDFStreamDecoderStage* stage)
+{
+    while(stage->ended == NO && stage->outputEnd < PDFStreamDecoderBufferSize)
+    {
+        int byte = PDFStreamDecoderNextByte(stage);
+        if(byte == -2)return NO;
+        if(byte == -1 || byte == '>')
+        {
+            // A final odd digit is followed by an implied 0.
+            if(stage->nibble >= 0)stage->output[stage->outputEnd++] = (unsigned char)(stage->nibble << 4);
+            stage->ended = YES;
+            break;
+        }
+
+        int value = -1;
+        if(byte >= '0' && byte <= '9')value = byte-'0';
+        else if(byte >= 'a' && byte <= 'f')value = byte-'a'+10;
+        else if(byte >= 'A' && byte <= 'F')value = byte-'A'+10;
+        else if(PDFStreamDecoderIsWhiteSpace(byte))continue;
+        else return NO;
+
+        if(stage->nibble < 0)stage->nibble = value;
+        else
+        {
+            stage->output[stage->outputEnd++] = (unsigned char)((stage->nibble << 4)|value);
+            stage->nibble = -1;
+        }
+    }
+    return YES;
+}
+
+
+static BOOL PDFStreamDecoderDecodeASCII85(PDFStreamDecoderStage* stage)
+{
+    while(stage->ended == NO && stage->outputEnd+4 <= PDFStreamDecoderBufferSize)
+    {
+        int byte = PDFStreamDecoderNextByte(stage);
+        if(byte == -2)return NO;
+        if(PDFStreamDecoderIsWhiteSpace(byte))continue;
+
+        if(byte == -1 || byte == '~')
+        {
+            // A final partial group of n characters is padded with 'u' and gives n-1 bytes.
+            if(stage->groupCount == 1)return NO;
+            if(stage->groupCount > 1)
+            {
+                NSUInteger count = stage->groupCount;
+                while(stage->groupCount < 5)stage->group[stage->groupCount++] = 'u'-'!';
+                uint64_t value = 0;
+                for(NSUInteger i = 0 ; i < 5 ; i++)value = value*85+stage->group[i];
+                for(NSUInteger i = 0 ; i < count-1 ; i++)stage->output[stage->outputEnd++] = (unsigned char)(value >> (24-8*i));
+            }
+            stage->ended = YES;
+            break;
+        }
+
+        if(byte == 'z' && stage->groupCount == 0)
+        {
+            memset(stage->output+stage->outputEnd, 0, 4);
+            stage->outputEnd += 4;
+            continue;
+        }
+        if(byte < '!' || byte > 'u')return NO;
+
+        stage->group[stage->groupCount++] = (unsigned char)(byte-'!');
+        if(stage->groupCount < 5)continue;
+
+        uint64_t value = 0;
+        for(NSUInteger i = 0 ; i < 5 ; i++)value = value*85+stage->group[i];
+        if(value > 0xFFFFFFFF)return NO;
+        for(NSUInteger i = 0 ; i < 4 ; i++)stage->output[stage->outputEnd++] = (unsigned char)(value >> (24-8*i));
+        stage->groupCount = 0;
+    }
+    return YES;
+}
+
+
+static BOOL PDFStreamDecoderDecodeRunLength(PDFStreamDecoderStage* stage)
+{
+    // A run is at most 128 bytes long. A missing end of data marker or a truncated run is tolerated.
+    while(stage->ended == NO && stage->outputEnd+128 <= PDFStreamDecoderBufferSize)
+    {
+        int length = PDFStreamDecoderNextByte(stage);
+        if(length == -2)return NO;
+        if(length == -1 || length == 128)
+        {
+            stage->ended = YES;
+            break;
+        }
+
+        if(length < 128)
+        {
+            for(int i = 0 ; i <= length ; i++)
+            {
+                int byte = PDFStreamDecoderNextByte(stage);
+                if(byte == -2)return NO;
+                if(byte == -1)
+                {
+                    stage->ended = YES;
+                    break;
+                }
+                stage->output[stage->outputEnd++] = (unsigned char)byte;
+            }
+            continue;
+        }
+
+        int byte = PDFStreamDecoderNextByte(stage);
+        if(byte == -2)return NO;
+        if(byte == -1)
+        {
+            stage->ended = YES;
+            break;
+        }
+        memset(stage->output+stage->outputEnd, byte, 257-length);
+        stage->outputEnd += 257-length;
+    }
+    return YES;
+}
+
+
+// The output of a predictor stage is the row it has just decoded.
+
+static BOOL PDFStreamDecoderUndoPredictor(PDFStreamDecoderStage* stage)
+{
+    BOOL png = (stage->predictor >= 10);
+    NSUInteger rowSize = stage->rowLength+(png?1:0);
+
+    while(stage->outputEnd == 0 && stage->ended == NO)
+    {
+        while(stage->rowFill < rowSize)
+        {
+            NSInteger available = PDFStreamDecoderFillInput(stage);
+            if(available < 0)return NO;
+            if(available == 0)break;
+
+            NSUInteger count = MIN((NSUInteger)available, rowSize-stage->rowFill);
+            memcpy(stage->row+stage->rowFill, stage->input+stage->inputStart, count);
+            stage->inputStart += count;
+            stage->rowFill += count;
+        }
+
+        // A partial last row is dropped by the PNG predictors and decoded as far as it goes by the TIFF predictor.
+        NSUInteger length = stage->rowLength;
+        if(stage->rowFill < rowSize)
+        {
+            stage->ended = YES;
+            if(png || stage->rowFill == 0)break;
+            length = stage->rowFill;
+        }
+        stage->rowFill = 0;
+
+        NSUInteger bpp = stage->bytesPerPixel;
+        if(png == NO)
+        {
+            unsigned char* out = stage->row;
+            for(NSUInteger c = bpp ; c < length ; c++)out[c] += out[c-bpp];
+            stage->output = out;
+            stage->outputEnd = length;
+            continue;
+        }
+
+        // Rows are decoded in place, each after its filter type byte.
+        unsigned char* out = stage->row+1;
+        const unsigned char* up = stage->previousRow;
+        unsigned char filter = stage->row[0];
+        for(NSUInteger c = 0 ; c < length ; c++)
+        {
+            int a = (c >= bpp?out[c-bpp]:0);
+            int b = up[c];
+            int d = (c >= bpp?up[c-bpp]:0);
+
+            switch(filter)
+            {
+                case 0: break;
+                case 1: out[c] += a; break;
+                case 2: out[c] += b; break;
+                case 3: out[c] += (a+b)/2; break;
+                case 4:
+                {
+                    int p = a+b-d;
+                    int pa = abs(p-a), pb = abs(p-b), pc = abs(p-d);
+                    out[c] += ((pa <= pb && pa <= pc)?a:(pb <= pc?b:d));
+                }
+                    break;
+                default: return NO;
+            }
+        }
+
+        memcpy(stage->previousRow, out, length);
+        stage->output = out;
+        stage->outputEnd = length;
+    }
+    return YES;
+}
+
+
+#pragma mark - Stages
+
+
+static NSInteger PDFStreamDecoderRead(PDFStreamDecoderStage* stage, unsigned char* buffer, NSUInteger length)
+{
+    NSUInteger count = 0;
+    while(count < length)
+    {
+        if(stage->outputStart == stage->outputEnd)
+        {
+            if(stage->ended)break;
+            stage->outputStart = 0;
+            stage->outputEnd = 0;
+
+            BOOL produced = NO;
+            switch(stage->filter)
+            {
+                case PDFStreamDecoderFilterFlate: produced = PDFStreamDecoderInflate(stage); break;
+                case PDFStreamDecoderFilterLZW: produced = PDFStreamDecoderDecodeLZW(stage); break;
+                case PDFStreamDecoderFilterASCIIHex: produced = PDFStreamDecoderDecodeASCIIHex(stage); break;
+                case PDFStreamDecoderFilterASCII85: produced = PDFStreamDecoderDecodeASCII85(stage); break;
+                case PDFStreamDecoderFilterRunLength: produced = PDFStreamDecoderDecodeRunLength(stage); break;
+                case PDFStreamDecoderFilterPredictor: produced = PDFStreamDecoderUndoPredictor(stage); break;
+            }
+            if(produced == NO)return -1;
+            continue;
+        }
+
+        NSUInteger available = MIN(length-count, stage->outputEnd-stage->outputStart);
+        memcpy(buffer+count, stage->output+stage->outputStart, available);
+        stage->outputStart += available;
+        count += available;
+    }
+    return count;
+}
+
+
+static void PDFStreamDecoderDestroyStage(PDFStreamDecoderStage* stage)
+{
+    if(stage == NULL)return;
+    if(stage->zstreamInitialized)inflateEnd(&stage->zstream);
+    PDFStreamDecoderReturnBuffer(stage->inputBuffer);
+    PDFStreamDecoderReturnBuffer(stage->outputBuffer);
+    free(stage->prefixes);
+    free(stage->suffixes);
+    free(stage->firsts);
+    free(stage->lengths);
+    free(stage->row);
+    free(stage->previousRow);
+    free(stage);
+}
+
+
+static PDFStreamDecoderStage* PDFStreamDecoderCreateStage(PDFStreamDecoderFilter filter, PDFStreamDecoderStage* source, NSData* data, PDFDictionary* parameters)
+{
+    PDFStreamDecoderStage* stage = calloc(1, sizeof(PDFStreamDecoderStage));
+    stage->filter = filter;
+    stage->source = source;
+
+    if(source == NULL)
+    {
+        stage->input = [data bytes];
+        stage->inputEnd = [data length];
+        stage->inputEnded = YES;
+    }
+    else
+    {
+        stage->inputBuffer = PDFStreamDecoderTakeBuffer();
+        stage->input = stage->inputBuffer;
+    }
+
+    if(filter != PDFStreamDecoderFilterPredictor)
+    {
+        stage->outputBuffer = PDFStreamDecoderTakeBuffer();
+        stage->output = stage->outputBuffer;
+    }
+
+    switch(filter)
+    {
+        case PDFStreamDecoderFilterFlate:
+            if(inflateInit(&stage->zstream) != Z_OK)
+            {
+                PDFStreamDecoderDestroyStage(stage);
+                return NULL;
+            }
+            stage->zstreamInitialized = YES;
+            break;
+        case PDFStreamDecoderFilterLZW:
+        {
+            id earlyChange = [parameters objectForKey:@"EarlyChange"];
+            stage->earlyChange = ([earlyChange isKindOfClass:[NSNumber class]]?([earlyChange integerValue] != 0):1);
+            stage->prefixes = calloc(PDFStreamDecoderLZWTableSize, sizeof(uint16_t));
+            stage->suffixes = calloc(PDFStreamDecoderLZWTableSize, 1);
+            stage->firsts = calloc(PDFStreamDecoderLZWTableSize, 1);
+            stage->lengths = calloc(PDFStreamDecoderLZWTableSize, sizeof(uint16_t));
+            for(NSUInteger i = 0 ; i < 256 ; i++)
+            {
+                stage->suffixes[i] = (unsigned char)i;
+                stage->firsts[i] = (unsigned char)i;
+                stage->lengths[i] = 1;
+            }
+            stage->nextCode = 258;
+            stage->codeWidth = 9;
+            stage->previousCode = -1;
+        }
+            break;
+        case PDFStreamDecoderFilterASCIIHex:
+            stage->nibble = -1;
+            break;
+        case PDFStreamDecoderFilterPredictor:
+        {
+            NSInteger columns = [[parameters objectForKey:@"Columns"] integerValue];
+            NSInteger colors = [[parameters objectForKey:@"Colors"] integerValue];
+            NSInteger bitsPerComponent = [[parameters objectForKey:@"BitsPerComponent"] integerValue];
+            if(columns <= 0)columns = 1;
+            if(colors <= 0)colors = 1;
+            if(bitsPerComponent <= 0)bitsPerComponent = 8;
+
+            stage->predictor = [[parameters objectForKey:@"Predictor"] integerValue];
+            stage->bytesPerPixel = MAX((NSUInteger)1, (NSUInteger)(colors*bitsPerComponent+7)/8);
+            stage->rowLength = (NSUInteger)(columns*colors*bitsPerComponent+7)/8;
+            stage->row = calloc(stage->rowLength+1, 1);
+            stage->previousRow = calloc(stage->rowLength+1, 1);
+
+            // The TIFF predictor is only supported for 8 bit components.
+            if(stage->predictor == 2 && bitsPerComponent != 8)
+            {
+                PDFStreamDecoderDestroyStage(stage);
+                return NULL;
+            }
+        }
+            break;
+        default:
+            break;
+    }
+
+    return stage;
+}
+
+
+static NSInteger PDFStreamDecoderFilterWithName(NSString* name)
+{
+    if([name isKindOfClass:[NSString class]] == NO)return NSNotFound;
+    if(PDFNameIsEqual(name, PDFNameFlateDecode) || [name isEqualToString:@"Fl"])return PDFStreamDecoderFilterFlate;
+    if([name isEqualToString:@"LZWDecode"] || [name isEqualToString:@"LZW"])return PDFStreamDecoderFilterLZW;
+    if([name isEqualToString:@"ASCIIHexDecode"] || [name isEqualToString:@"AHx"])return PDFStreamDecoderFilterASCIIHex;
+    if([name isEqualToString:@"ASCII85Decode"] || [name isEqualToString:@"A85"])return PDFStreamDecoderFilterASCII85;
+    if([name isEqualToString:@"RunLengthDecode"] || [name isEqualToString:@"RL"])return PDFStreamDecoderFilterRunLength;
+    return NSNotFound;
+}
+
+
+@implementation PDFStreamDecoder
+{
+    NSData* _data;
+    PDFStreamDecoderStage** _stages;
+    NSUInteger _stageCount;
+}
+
+
+-(void)dealloc
+{
+    for(NSUInteger i = 0 ; i < _stageCount ; i++)PDFStreamDecoderDestroyStage(_stages[i]);
+    free(_stages);
+}
+
+
+-(id)initWithData:(NSData*)data Dictionary:(PDFDictionary*)dictionary
+{
+    id filter = [dictionary objectForKey:PDFNameFilter];
+    id parameters = [dictionary objectForKey:PDFNameDecodeParms];
+    NSArray* filters = ([filter isKindOfClass:[PDFArray class]]?[filter nsa]:(filter?@[filter]:@[]));
+    NSArray* parameterList = ([parameters isKindOfClass:[PDFArray class]]?[parameters nsa]:(parameters?@[parameters]:@[]));
+    return [self initWithData:data Filters:filters DecodeParameters:parameterList];
+}
+
+
+-(id)initWithData:(NSData*)data Filters:(NSArray*)filters DecodeParameters:(NSArray*)parameters
+{
+    for(NSString* name in filters)
+    {
+        if(PDFStreamDecoderFilterWithName(name) == NSNotFound)return nil;
+    }
+
+    self = [super init];
+    if(self != nil)
+    {
+        _data = (data?data:[NSData data]);
+
+        // Each filter may be followed by a predictor stage.
+        _stages = calloc(MAX([filters count]*2, (NSUInteger)1), sizeof(PDFStreamDecoderStage*));
+        for(NSUInteger i = 0 ; i < [filters count] ; i++)
+        {
+            PDFStreamDecoderFilter filter = (PDFStreamDecoderFilter)PDFStreamDecoderFilterWithName(filters[i]);
+            PDFDictionary* decodeParms = (i < [parameters count]?parameters[i]:nil);
+            if([decodeParms isKindOfClass:[PDFDictionary class]] == NO)decodeParms = nil;
+
+            PDFStreamDecoderStage* stage = PDFStreamDecoderCreateStage(filter, (_stageCount?_stages[_stageCount-1]:NULL), _data, decodeParms);
+            if(stage == NULL)return nil;
+            _stages[_stageCount++] = stage;
+
+            if((filter == PDFStreamDecoderFilterFlate || filter == PDFStreamDecoderFilterLZW) && [[decodeParms objectForKey:@"Predictor"] integerValue] > 1)
+            {
+                stage = PDFStreamDecoderCreateStage(PDFStreamDecoderFilterPredictor, stage, _data, decodeParms);
+                if(stage == NULL)return nil;
+                _stages[_stageCount++] = stage;
+            }
+        }
+    }
+    return self;
+}
+
+
++(BOOL)supportsFilter:(NSString*)name
+{
+    return (PDFStreamDecoderFilterWithName(name) != NSNotFound);
+}
+
+
+-(NSInteger)readBytes:(void*)buffer MaxLength:(NSUInteger)length
+{
+    if(_failed)return -1;
+    if(_atEnd || length == 0)return 0;
+
+    NSInteger ret = 0;
+    if(_stageCount == 0)
+    {
+        // Unfiltered data is copied as it is.
+        ret = MIN(length, [_data length]-_numberOfBytesRead);
+        memcpy(buffer, (const unsigned char*)[_data bytes]+_numberOfBytesRead, ret);
+    }
+    else ret = PDFStreamDecoderRead(_stages[_stageCount-1], buffer, length);
+
+    if(ret < 0)
+    {
+        _failed = YES;
+        return -1;
+    }
+
+    _numberOfBytesRead += ret;
+    if((NSUInteger)ret < length)_atEnd = YES;
+    return ret;
+}
+
+
+-(NSData*)readDataOfMaximumLength:(NSUInteger)length
+{
+    if(_failed)return nil;
+    if(_stageCount == 0 && _numberOfBytesRead == 0 && length >= [_data length])
+    {
+        _numberOfBytesRead = [_data length];
+        _atEnd = YES;
+        return _data;
+    }
+
+    // The result grows geometrically, so decoding a whole stream copies each byte a constant number of times.
+    NSMutableData* ret = [NSMutableData data];
+    NSUInteger filled = 0;
+    while(_atEnd == NO && filled < length)
+    {
+        NSUInteger chunk = MIN(length-filled, MAX(filled, (NSUInteger)PDFStreamDecoderBufferSize));
+        [ret setLength:filled+chunk];
+        NSInteger count = [self readBytes:(unsigned char*)[ret mutableBytes]+filled MaxLength:chunk];
+        if(count < 0)return nil;
+        filled += count;
+    }
+    [ret setLength:filled];
+    return ret;
+}
+
+
+@end
@@ -0,0 +1,58 @@
+#import <Foundation/Foundation.h>
+
+@class PDFDocument;
+
+
+/** The PDFTemplate class holds a parsed document from which any number of PDFDocument instances are created.
+ Opening a document parses its cross-reference sections, catalog, page tree and field tree. A PDFTemplate does that once and keeps the results. Every document created from it shares the mapped file bytes, the cross-reference index and the decoded object streams, and starts with copies of the template's forms.
+
+     PDFTemplate* template = [[PDFTemplate alloc] initWithPath:path];
+     PDFDocument* document = [template newDocument];
+     [document.forms setValue:@"Lusaka" ForFormWithName:@"City"];
+     [document saveFormsToPath:outputPath];
+
+ Creating a document only takes references to the shared state. Its forms are copied when they are first used. The shared bytes are never modified: a document keeps its own form values and, once saved, its own file or data. A PDFTemplate is immutable once created, so documents can be created from it on any number of threads at once.
+ */
+@interface PDFTemplate : NSObject
+
+
+/** The path of the template file, or nil if the template was created from data.
+ */
+@property(nonatomic,readonly) NSString* path;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Creating a PDFTemplate
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Creates a new instance of PDFTemplate from a file.
+
+ @param path The path of the PDF file. The file is mapped and must not change while the template or any document created from it is in use.
+ @return A new PDFTemplate, or nil if the file is not a PDF document.
+ */
+-(id)initWithPath:(NSString*)path;
+
+
+/** Creates a new instance of PDFTemplate from data.
+
+ @param data The content of the PDF file.
+ @return A new PDFTemplate, or nil if data is not a PDF document.
+ */
+-(id)initWithData:(NSData*)data;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Creating Documents
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Creates a new document from the template.
+
+ @return A new PDFDocument whose forms have the values stored in the template.
+ @discussion This method can be called from several threads at once.
+ */
+-(PDFDocument*)newDocument;
+
+
+@end
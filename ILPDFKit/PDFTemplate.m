@@ -0,0 +1,83 @@
+#import "PDFTemplate.h"
+#import "PDFDocument.h"
+#import "PDFFormContainer.h"
+#import "PDFDictionary.h"
+#import "PDFCrossReferenceTable.h"
+
+
+/* The state of the prototype document that is shared with the documents created from it.
+ */
+@interface PDFDocument(PDFTemplate)
+    @property(nonatomic,readonly) NSData* fileData;
+    @property(nonatomic,readonly) PDFCrossReferenceTable* crossReferenceTable;
+    -(NSData*)completeFileData;
+@end
+
+
+@interface PDFTemplate()
+    -(id)initWithDocument:(PDFDocument*)document;
+    -(PDFDocument*)prototype;
+@end
+
+
+@implementation PDFTemplate
+{
+    PDFDocument* _prototype;
+}
+
+
+-(id)initWithPath:(NSString*)path
+{
+    return [self initWithDocument:[[PDFDocument alloc] initWithPath:path]];
+}
+
+
+-(id)initWithData:(NSData*)data
+{
+    return [self initWithDocument:[[PDFDocument alloc] initWithData:data]];
+}
+
+
+-(PDFDocument*)newDocument
+{
+    return [[PDFDocument alloc] initWithTemplate:self];
+}
+
+
+-(NSString*)path
+{
+    return _prototype.documentPath;
+}
+
+
+#pragma mark - Hidden
+
+
+// Every lazily created part of the prototype is created here, so documents only ever read it.
+
+-(id)initWithDocument:(PDFDocument*)document
+{
+    self = [super init];
+    if(self != nil)
+    {
+        // Documents share the bytes of the prototype, so a prototype read from a data source fetches all of them first.
+        if(document.document == NULL || [document completeFileData] == nil)return nil;
+
+        _prototype = document;
+        [document.crossReferenceTable.trailer pdfFileRepresentation];
+        [document.trailer pdfFileRepresentation];
+        [document catalog];
+        [document pages];
+        [document forms];
+    }
+    return self;
+}
+
+
+-(PDFDocument*)prototype
+{
+    return _prototype;
+}
+
+
+@end
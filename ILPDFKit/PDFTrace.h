@@ -0,0 +1,139 @@
+#import <Foundation/Foundation.h>
+
+
+typedef enum PDFTraceCounter
+{
+    PDFTraceCounterObjectsResolved = 0,
+    PDFTraceCounterBytesScanned,
+    PDFTraceCounterCacheHits,
+    PDFTraceCounterCacheMisses,
+    PDFTraceCounterBridgeCalls,
+    PDFTraceCounterDictionaryHits,
+    PDFTraceCounterDictionaryMisses,
+    PDFTraceCounterObjectStreamHits,
+    PDFTraceCounterObjectStreamMisses,
+    PDFTraceNumberOfCounters
+
+} PDFTraceCounter;
+
+
+/** The PDFTraceSink protocol is adopted by objects that receive the spans recorded by PDFTrace.
+ */
+@protocol PDFTraceSink <NSObject>
+
+
+/** Called when a span ends.
+
+ @param name The name of the span, such as 'PDFDocument.crossReferenceTable'.
+ @param start The start of the span, in microseconds from an arbitrary origin.
+ @param duration The length of the span, in microseconds.
+ @param thread An identifier of the thread the span ran on.
+ @discussion Spans end on whichever thread ran them, so this method must be thread safe. Spans nest, and a span ends before the span containing it. The counters can be read with [PDFTrace valueOfCounter:].
+ */
+-(void)traceSpanWithName:(NSString*)name Start:(uint64_t)start Duration:(uint64_t)duration Thread:(uint64_t)thread;
+
+
+@end
+
+
+/* YES while a sink is set. Read by the macros below, so a disabled trace costs a single load and branch.
+ */
+extern volatile BOOL PDFTraceEnabled;
+
+/* The current time in microseconds, never 0.
+ */
+uint64_t PDFTraceTimestamp(void);
+
+// Declares a span variable holding its start time, or 0 when tracing is disabled.
+#define PDFTraceBegin(span) uint64_t span = (PDFTraceEnabled?PDFTraceTimestamp():0)
+
+// Ends a span begun with PDFTraceBegin. A span begun while tracing was disabled is dropped.
+#define PDFTraceEnd(span,name) do { if(span)[PDFTrace endSpanWithName:(name) Start:(span)]; } while(0)
+
+// Adds to a counter while tracing is enabled.
+#define PDFTraceCount(counter,value) do { if(PDFTraceEnabled)[PDFTrace addValue:(value) ToCounter:(counter)]; } while(0)
+
+
+/** The PDFTrace class records where the kit spends its time.
+ Named spans are recorded around the phases of reading and saving a document: walking the cross-reference sections, resolving objects, materializing dictionaries, enumerating fields, running scripts and saving. Counters accumulate the number of objects resolved, bytes scanned, calls from scripts into the kit, and the hits and misses of each cache: the object cache, the values cached by each dictionary and the decoded object streams.
+
+ Nothing is recorded until a sink is set, and with no sink the instrumentation only tests a flag.
+
+     PDFChromeTraceSink* sink = [[PDFChromeTraceSink alloc] init];
+     [PDFTrace setSink:sink];
+     PDFDocument* document = [[PDFDocument alloc] initWithPath:path];
+     [document.forms setValue:@"Yes" ForFormWithName:@"Agree"];
+     [PDFTrace setSink:nil];
+     [sink writeToPath:tracePath];
+ */
+@interface PDFTrace : NSObject
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Enabling Tracing
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Sets the sink receiving the spans, enabling tracing.
+
+ @param sink The new sink, retained until it is replaced. Pass nil to disable tracing.
+ @discussion The counters are not reset, so they can be read after tracing is disabled.
+ */
++(void)setSink:(id<PDFTraceSink>)sink;
+
+
+/** The current sink.
+
+ @return The sink, or nil if tracing is disabled.
+ */
++(id<PDFTraceSink>)sink;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Recording
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Ends a span and passes it to the sink. Used through the PDFTraceEnd macro.
+
+ @param name The name of the span.
+ @param start The start time returned by PDFTraceTimestamp.
+ */
++(void)endSpanWithName:(NSString*)name Start:(uint64_t)start;
+
+
+/** Adds to a counter. Used through the PDFTraceCount macro.
+
+ @param value The amount to add.
+ @param counter The counter.
+ */
++(void)addValue:(int64_t)value ToCounter:(PDFTraceCounter)counter;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Reading Counters
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Returns the value of a counter.
+
+ @param counter The counter.
+ @return The total added to the counter since it was last reset.
+ */
++(int64_t)valueOfCounter:(PDFTraceCounter)counter;
+
+
+/** Returns the name of a counter, for output.
+
+ @param counter The counter.
+ @return A name such as 'objectsResolved'.
+ */
++(NSString*)nameOfCounter:(PDFTraceCounter)counter;
+
+
+/** Sets every counter to 0.
+ */
++(void)resetCounters;
+
+
+@end
@@ -0,0 +1,93 @@
+#import "PDFTrace.h"
+#import <libkern/OSAtomic.h>
+#import <mach/mach_time.h>
+#import <pthread.h>
+
+
+volatile BOOL PDFTraceEnabled = NO;
+
+static id<PDFTraceSink> PDFTraceCurrentSink = nil;
+static volatile int64_t PDFTraceCounters[PDFTraceNumberOfCounters];
+
+
+uint64_t PDFTraceTimestamp(void)
+{
+    static mach_timebase_info_data_t timebase;
+    if(timebase.denom == 0)mach_timebase_info(&timebase);
+    return mach_absolute_time()*timebase.numer/timebase.denom/1000+1;
+}
+
+
+@implementation PDFTrace
+
+
++(void)setSink:(id<PDFTraceSink>)sink
+{
+    @synchronized(self)
+    {
+        PDFTraceCurrentSink = sink;
+        PDFTraceEnabled = (sink != nil);
+    }
+}
+
+
++(id<PDFTraceSink>)sink
+{
+    @synchronized(self)
+    {
+        return PDFTraceCurrentSink;
+    }
+}
+
+
++(void)endSpanWithName:(NSString*)name Start:(uint64_t)start
+{
+    uint64_t end = PDFTraceTimestamp();
+    id<PDFTraceSink> sink = [self sink];
+    [sink traceSpanWithName:name Start:start Duration:(end > start?end-start:0) Thread:pthread_mach_thread_np(pthread_self())];
+}
+
+
++(void)addValue:(int64_t)value ToCounter:(PDFTraceCounter)counter
+{
+    if(counter >= PDFTraceNumberOfCounters)return;
+    OSAtomicAdd64Barrier(value, &PDFTraceCounters[counter]);
+}
+
+
++(int64_t)valueOfCounter:(PDFTraceCounter)counter
+{
+    if(counter >= PDFTraceNumberOfCounters)return 0;
+    return OSAtomicAdd64Barrier(0, &PDFTraceCounters[counter]);
+}
+
+
++(NSString*)nameOfCounter:(PDFTraceCounter)counter
+{
+    switch(counter)
+    {
+        case PDFTraceCounterObjectsResolved: return @"objectsResolved";
+        case PDFTraceCounterBytesScanned: return @"bytesScanned";
+        case PDFTraceCounterCacheHits: return @"cacheHits";
+        case PDFTraceCounterCacheMisses: return @"cacheMisses";
+        case PDFTraceCounterBridgeCalls: return @"bridgeCalls";
+        case PDFTraceCounterDictionaryHits: return @"dictionaryHits";
+        case PDFTraceCounterDictionaryMisses: return @"dictionaryMisses";
+        case PDFTraceCounterObjectStreamHits: return @"objectStreamHits";
+        case PDFTraceCounterObjectStreamMisses: return @"objectStreamMisses";
+        default: return nil;
+    }
+}
+
+
++(void)resetCounters
+{
+    for(NSUInteger i = 0 ; i < PDFTraceNumberOfCounters ; i++)
+    {
+        int64_t value = PDFTraceCounters[i];
+        while(OSAtomicCompareAndSwap64Barrier(value, 0, &PDFTraceCounters[i]) == NO)value = PDFTraceCounters[i];
+    }
+}
+
+
+@end
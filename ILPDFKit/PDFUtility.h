@@ -2,6 +2,9 @@
 
 #import <Foundation/Foundation.h>
 
+@class PDFDictionary;
+@class PDFMappedFile;
+
 
 /** The PDFUtility class represents a singleton that implements a range of PDF utility functions.
  */
@@ -43,6 +46,12 @@
  */
 +(CGPDFDocumentRef)newPDFDocumentRefFromPath:(NSString*)pathToPdfDoc;
 
+/** Creates a PDF Document that reads a mapped file as Quartz needs its bytes.
+ @param file The file, whose bytes are fetched from its data source when Quartz reads them. The document retains it.
+ @return A new Quartz PDF document, or NULL if a document could not be created. You are responsible for releasing the object using CGPDFDocumentRelease.
+ */
++(CGPDFDocumentRef)newPDFDocumentRefFromMappedFile:(PDFMappedFile*)file;
+
 
 /** Creates a PDF compatible string hash escaped to remove PDF delimeter characters .
  @param stringToEncode The string to encode.
@@ -91,6 +100,71 @@
 +(NSString*)urlEncodeStringXML:(NSString*)str;
 
 
+/**---------------------------------------------------------------------------------------
+ * @name Converting Text
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Writes text as a PDF string object.
+ @param str The text, or nil for an empty string.
+ @return A literal string with its delimiters escaped if str can be represented in ISO Latin 1, otherwise a hexadecimal UTF-16BE string with a byte order mark.
+ */
++(NSString*)pdfStringFromString:(NSString*)str;
+
+/** Writes text as a PDF name object.
+ @param str The text, or nil for an empty name.
+ @return The name, including its leading slash. Every UTF-8 byte outside the regular printable characters is written as a #xx escape.
+ */
++(NSString*)pdfNameFromString:(NSString*)str;
+
+/** Reads the text of a PDF string object.
+ @param bytes The contents of the string, without its enclosing parentheses or angle brackets.
+ @param length The number of bytes.
+ @param hexadecimal YES for a hexadecimal string, NO for a literal string.
+ @return The text. Escape sequences are resolved, and text starting with a UTF-16BE byte order mark is decoded as such. Other text is read as ISO Latin 1.
+ */
++(NSString*)stringWithPDFStringBytes:(const unsigned char*)bytes Length:(NSUInteger)length Hexadecimal:(BOOL)hexadecimal;
+
+/** Reads the text of a PDF name object.
+ @param bytes The name, without its leading slash.
+ @param length The number of bytes.
+ @return The text, with #xx escapes resolved and read as UTF-8, or as ISO Latin 1 if the bytes are not valid UTF-8.
+ */
++(NSString*)stringWithPDFNameBytes:(const unsigned char*)bytes Length:(NSUInteger)length;
+
+/** Converts the code of an object back to the bytes it was read from.
+ @param code Code read from a document. Documents read code as ISO Latin 1, so each character is one byte.
+ @return The bytes, with byte offsets equal to character indexes in code, including any stream data.
+ */
++(NSData*)dataWithObjectCode:(NSString*)code;
+
+
+/**---------------------------------------------------------------------------------------
+ * @name Decoding Stream Data
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/** Decodes the data of a stream read directly from the file.
+ @param data The encoded stream data, as it appears between the 'stream' and 'endstream' keywords.
+ @param dictionary The stream dictionary, whose 'Filter' and 'DecodeParms' entries describe the encoding.
+ @return The decoded data, or nil if the data is corrupt or uses a filter PDFStreamDecoder does not support.
+ @discussion Use PDFStreamDecoder directly to decode only part of a stream.
+ */
++(NSData*)decodedDataFromStreamData:(NSData*)data Dictionary:(PDFDictionary*)dictionary;
+
+/** Reads the length of the data of a stream.
+ @param dictionary The stream dictionary.
+ @return The value of its 'Length' entry, direct or indirect, or NSNotFound if there is none.
+ */
++(NSUInteger)lengthOfStreamWithDictionary:(PDFDictionary*)dictionary;
+
+/** Compresses data for a stream with the FlateDecode filter.
+ @param data The data to compress.
+ @return The zlib compressed data, or nil if compression failed.
+ */
++(NSData*)flateEncodedData:(NSData*)data;
+
+
 
 
 
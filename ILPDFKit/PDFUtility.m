@@ -2,6 +2,26 @@
 #import "PDFUtility.h"
 #import "PDFObject.h"
 #import "PDFDocument.h"
+#import "PDFDictionary.h"
+#import "PDFArray.h"
+#import "PDFNameTable.h"
+#import "PDFStreamDecoder.h"
+#import "PDFMappedFile.h"
+#import <zlib.h>
+
+
+// Quartz reads a mapped file through these callbacks, which own a reference to it.
+
+static size_t PDFUtilityGetMappedBytes(void* info, void* buffer, off_t position, size_t count)
+{
+    PDFMappedFile* file = (__bridge PDFMappedFile*)info;
+    return [file getBytes:buffer Range:NSMakeRange((NSUInteger)position, count)];
+}
+
+static void PDFUtilityReleaseMappedFile(void* info)
+{
+    CFBridgingRelease(info);
+}
 
 
 @implementation PDFUtility
@@ -70,6 +90,21 @@ static PDFUtility* _sharedPDFUtility = nil;
     return pdf;
 }
 
++(CGPDFDocumentRef)newPDFDocumentRefFromMappedFile:(PDFMappedFile*)file
+{
+    CGDataProviderDirectCallbacks callbacks = {0, NULL, NULL, PDFUtilityGetMappedBytes, PDFUtilityReleaseMappedFile};
+    void* info = (void*)CFBridgingRetain(file);
+    CGDataProviderRef dataProvider = CGDataProviderCreateDirect(info, (off_t)file.length, &callbacks);
+    if(dataProvider == NULL)
+    {
+        CFBridgingRelease(info);
+        return NULL;
+    }
+    CGPDFDocumentRef pdf = CGPDFDocumentCreateWithProvider(dataProvider);
+    CGDataProviderRelease(dataProvider);
+    return pdf;
+}
+
 +(CGPDFDocumentRef)newPDFDocumentRefFromResource:(NSString*)name
 {
     NSString *pathToPdfDoc = [[NSBundle mainBundle] pathForResource:name ofType:@"pdf"];
@@ -225,6 +260,175 @@ static PDFUtility* _sharedPDFUtility = nil;
 }
 
 
++(NSString*)pdfStringFromString:(NSString*)str
+{
+    if(str == nil)str = @"";
+    
+    if([str canBeConvertedToEncoding:NSISOLatin1StringEncoding])
+    {
+        NSString* escaped = [str stringByReplacingOccurrencesOfString:@"\\" withString:@"\\\\"];
+        escaped = [escaped stringByReplacingOccurrencesOfString:@"(" withString:@"\\("];
+        escaped = [escaped stringByReplacingOccurrencesOfString:@")" withString:@"\\)"];
+        escaped = [escaped stringByReplacingOccurrencesOfString:@"\r" withString:@"\\r"];
+        return [NSString stringWithFormat:@"(%@)",escaped];
+    }
+    
+    // Text that is not representable in a single byte encoding is written as a UTF-16BE hex string with a byte order mark.
+    NSMutableString* ret = [NSMutableString stringWithString:@"<FEFF"];
+    for(NSUInteger i = 0 ; i < [str length] ; i++)[ret appendFormat:@"%04X",[str characterAtIndex:i]];
+    [ret appendString:@">"];
+    return ret;
+}
+
+
++(NSString*)pdfNameFromString:(NSString*)str
+{
+    NSMutableString* ret = [NSMutableString stringWithString:@"/"];
+    NSData* bytes = [(str?str:@"") dataUsingEncoding:NSUTF8StringEncoding];
+    const unsigned char* c = [bytes bytes];
+    for(NSUInteger i = 0 ; i < [bytes length] ; i++)
+    {
+        if(c[i] > 32 && c[i] < 127 && strchr("()<>[]{}/%#", c[i]) == NULL)[ret appendFormat:@"%c",c[i]];
+        else [ret appendFormat:@"#%02X",c[i]];
+    }
+    return ret;
+}
+
+
+static int hexValue(unsigned char c)
+{
+    if(c >= '0' && c <= '9')return c-'0';
+    if(c >= 'a' && c <= 'f')return c-'a'+10;
+    if(c >= 'A' && c <= 'F')return c-'A'+10;
+    return -1;
+}
+
+
++(NSString*)stringWithPDFStringBytes:(const unsigned char*)bytes Length:(NSUInteger)length Hexadecimal:(BOOL)hexadecimal
+{
+    NSMutableData* decoded = [NSMutableData dataWithCapacity:length];
+    
+    if(hexadecimal)
+    {
+        // White space is ignored and a missing final digit is taken as 0.
+        int high = -1;
+        for(NSUInteger i = 0 ; i < length ; i++)
+        {
+            int digit = hexValue(bytes[i]);
+            if(digit < 0)continue;
+            if(high < 0)high = digit;
+            else
+            {
+                unsigned char byte = (unsigned char)((high << 4) | digit);
+                [decoded appendBytes:&byte length:1];
+                high = -1;
+            }
+        }
+        if(high >= 0)
+        {
+            unsigned char byte = (unsigned char)(high << 4);
+            [decoded appendBytes:&byte length:1];
+        }
+    }
+    else
+    {
+        for(NSUInteger i = 0 ; i < length ; i++)
+        {
+            unsigned char byte = bytes[i];
+            if(byte == '\\' && i+1 < length)
+            {
+                unsigned char escape = bytes[++i];
+                switch(escape)
+                {
+                    case 'n': byte = '\n'; break;
+                    case 'r': byte = '\r'; break;
+                    case 't': byte = '\t'; break;
+                    case 'b': byte = '\b'; break;
+                    case 'f': byte = '\f'; break;
+                    case '\r':
+                        // A backslash at the end of a line continues the string on the next line.
+                        if(i+1 < length && bytes[i+1] == '\n')i++;
+                        continue;
+                    case '\n':
+                        continue;
+                    default:
+                        if(escape >= '0' && escape <= '7')
+                        {
+                            NSUInteger value = escape-'0';
+                            for(NSUInteger digits = 1 ; digits < 3 && i+1 < length && bytes[i+1] >= '0' && bytes[i+1] <= '7' ; digits++)value = value*8+(bytes[++i]-'0');
+                            byte = (unsigned char)value;
+                        }
+                        else byte = escape;
+                        break;
+                }
+            }
+            [decoded appendBytes:&byte length:1];
+        }
+    }
+    
+    const unsigned char* c = [decoded bytes];
+    if([decoded length] >= 2 && c[0] == 0xFE && c[1] == 0xFF)
+    {
+        NSString* ret = [[NSString alloc] initWithBytes:c+2 length:([decoded length]-2)&~(NSUInteger)1 encoding:NSUTF16BigEndianStringEncoding];
+        if(ret)return ret;
+    }
+    return [[NSString alloc] initWithData:decoded encoding:NSISOLatin1StringEncoding];
+}
+
+
++(NSString*)stringWithPDFNameBytes:(const unsigned char*)bytes Length:(NSUInteger)length
+{
+    NSMutableData* decoded = [NSMutableData dataWithCapacity:length];
+    for(NSUInteger i = 0 ; i < length ; i++)
+    {
+        unsigned char byte = bytes[i];
+        if(byte == '#' && i+2 < length && hexValue(bytes[i+1]) >= 0 && hexValue(bytes[i+2]) >= 0)
+        {
+            byte = (unsigned char)((hexValue(bytes[i+1]) << 4) | hexValue(bytes[i+2]));
+            i += 2;
+        }
+        [decoded appendBytes:&byte length:1];
+    }
+    
+    NSString* ret = [[NSString alloc] initWithData:decoded encoding:NSUTF8StringEncoding];
+    return (ret?ret:[[NSString alloc] initWithData:decoded encoding:NSISOLatin1StringEncoding]);
+}
+
+
+
++(NSData*)dataWithObjectCode:(NSString*)code
+{
+    return [code dataUsingEncoding:NSISOLatin1StringEncoding allowLossyConversion:YES];
+}
+
+
++(NSData*)decodedDataFromStreamData:(NSData*)data Dictionary:(PDFDictionary*)dictionary
+{
+    return [[[PDFStreamDecoder alloc] initWithData:data Dictionary:dictionary] readDataOfMaximumLength:NSNotFound];
+}
+
+
++(NSUInteger)lengthOfStreamWithDictionary:(PDFDictionary*)dictionary
+{
+    // An indirect 'Length' resolves to a generic object whose representation is the number.
+    id length = [dictionary objectForKey:PDFNameLength];
+    if([length isKindOfClass:[NSNumber class]])return [length unsignedIntegerValue];
+    if([length isKindOfClass:[PDFObject class]] && [length pdfFileRepresentation])return (NSUInteger)[[length pdfFileRepresentation] integerValue];
+    return NSNotFound;
+}
+
+
++(NSData*)flateEncodedData:(NSData*)data
+{
+    uLongf length = compressBound((uLong)[data length]);
+    NSMutableData* ret = [NSMutableData dataWithLength:length];
+    if(compress2([ret mutableBytes], &length, [data bytes], (uLong)[data length], Z_DEFAULT_COMPRESSION) != Z_OK)return nil;
+    [ret setLength:length];
+    return ret;
+}
+
+
+
 
 
 @end
@@ -0,0 +1,72 @@
+#import <Foundation/Foundation.h>
+
+
+/** The PDFBenchmarkCorpus class describes and generates a synthetic AcroForm document for benchmarking.
+ The document is written byte by byte, without CoreGraphics or ILPDFKit, so the corpus does not depend on the code being measured. It has one page whose widgets are the terminal text fields of a field tree. Every field has a value, and the page carries an unused image of random bytes to make the file large.
+
+     PDFBenchmarkCorpus* corpus = [PDFBenchmarkCorpus corpusWithName:@"deep" FieldCount:10000 Depth:8];
+     corpus.revisionCount = 20;
+     [corpus writeToPath:path];
+ */
+@interface PDFBenchmarkCorpus : NSObject
+
+
+/** The name identifying the document in results.
+ */
+@property(nonatomic,strong) NSString* name;
+
+/** The number of terminal fields.
+ */
+@property(nonatomic) NSUInteger fieldCount;
+
+/** The number of levels of the field tree. With a depth of 1 every field is a top level field. Otherwise the fields are spread evenly under depth-1 levels of non-terminal fields.
+ */
+@property(nonatomic) NSUInteger depth;
+
+/** The number of incremental updates appended to the original file. Each one changes the values of one percent of the fields.
+ */
+@property(nonatomic) NSUInteger revisionCount;
+
+/** If YES, every cross-reference section is written as a cross-reference stream. The default is NO.
+ */
+@property(nonatomic) BOOL usesCrossReferenceStreams;
+
+/** The number of bytes of the binary image stream. The default is 0, for no image.
+ */
+@property(nonatomic) NSUInteger binaryStreamLength;
+
+
+/** Creates a new corpus description.
+
+ @param name The name.
+ @param fieldCount The number of terminal fields.
+ @param depth The number of levels of the field tree.
+ @return A new PDFBenchmarkCorpus without revisions or binary data.
+ */
++(PDFBenchmarkCorpus*)corpusWithName:(NSString*)name FieldCount:(NSUInteger)fieldCount Depth:(NSUInteger)depth;
+
+
+/** The corpus measured by the benchmark suite: flat forms of 1,000 to 100,000 fields, deep hierarchies, documents with many revisions, cross-reference streams and large binary streams.
+
+ @return An array of PDFBenchmarkCorpus.
+ */
++(NSArray*)standardCorpus;
+
+
+/** Returns the fully qualified name of a terminal field.
+
+ @param index The index of the field, from 0 to fieldCount-1.
+ @return The name.
+ */
+-(NSString*)nameOfFieldAtIndex:(NSUInteger)index;
+
+
+/** Writes the document.
+
+ @param path The destination path.
+ @return YES if successful, NO if failed.
+ */
+-(BOOL)writeToPath:(NSString*)path;
+
+
+@end
@@ -0,0 +1,412 @@
+#import "PDFBenchmarkCorpus.h"
+#import <zlib.h>
+
+// The catalog, page tree, form, page and contents are always the first objects.
+#define PDFBenchmarkCorpusPageNumber 4
+#define PDFBenchmarkCorpusImageNumber 6
+
+// Objects are packed into object streams this many at a time when cross-reference streams are used.
+#define PDFBenchmarkCorpusObjectsPerStream 100
+
+// The image is this many bytes wide, so its length is rounded up to a whole row.
+#define PDFBenchmarkCorpusImageWidth 1024
+
+// Each revision changes the values of one field in this many.
+#define PDFBenchmarkCorpusRevisionStep 100
+
+
+typedef struct
+{
+    unsigned char type;
+    NSUInteger field2;
+    NSUInteger field3;
+}
+PDFBenchmarkCorpusEntry;
+
+
+// b raised to the power e, saturating at cap.
+static NSUInteger PDFBenchmarkCorpusPower(NSUInteger b, NSUInteger e, NSUInteger cap)
+{
+    NSUInteger ret = 1;
+    while(e-- > 0)
+    {
+        if(ret >= (cap+b-1)/b)return cap;
+        ret *= b;
+    }
+    return MIN(ret, cap);
+}
+
+
+@interface PDFBenchmarkCorpus()
+    -(NSUInteger)branching;
+    -(NSUInteger)spanOfLevel:(NSUInteger)level;
+    -(NSUInteger)countOfLevel:(NSUInteger)level;
+    -(NSUInteger)objectNumberOfNodeAtLevel:(NSUInteger)level Index:(NSUInteger)index;
+    -(NSString*)bodyOfNodeAtLevel:(NSUInteger)level Index:(NSUInteger)index Revision:(NSUInteger)revision;
+    -(void)writeBytes:(const void*)bytes Length:(NSUInteger)length;
+    -(void)writeString:(NSString*)str;
+    -(void)writeObjectWithNumber:(NSUInteger)number Body:(NSString*)body;
+    -(void)writeStreamWithNumber:(NSUInteger)number Dictionary:(NSString*)dictionary Data:(NSData*)data;
+    -(void)writeImage;
+    -(void)writeFieldsInObjectStreams;
+    -(NSUInteger)writeCrossReferenceForNumbers:(NSIndexSet*)numbers Prev:(NSUInteger)prev;
+@end
+
+
+@implementation PDFBenchmarkCorpus
+{
+    FILE* _file;
+    NSUInteger _offset;
+    BOOL _failed;
+    NSUInteger _branching;
+    NSUInteger* _firstNumbers;
+    NSUInteger _firstStreamNumber;
+    NSUInteger _size;
+    PDFBenchmarkCorpusEntry* _entries;
+}
+
+
++(PDFBenchmarkCorpus*)corpusWithName:(NSString*)name FieldCount:(NSUInteger)fieldCount Depth:(NSUInteger)depth
+{
+    PDFBenchmarkCorpus* ret = [[PDFBenchmarkCorpus alloc] init];
+    ret.name = name;
+    ret.fieldCount = fieldCount;
+    ret.depth = MAX(depth, 1);
+    return ret;
+}
+
+
++(NSArray*)standardCorpus
+{
+    NSMutableArray* ret = [NSMutableArray array];
+
+    [ret addObject:[PDFBenchmarkCorpus corpusWithName:@"flat-1k" FieldCount:1000 Depth:1]];
+    [ret addObject:[PDFBenchmarkCorpus corpusWithName:@"flat-10k" FieldCount:10000 Depth:1]];
+    [ret addObject:[PDFBenchmarkCorpus corpusWithName:@"flat-100k" FieldCount:100000 Depth:1]];
+    [ret addObject:[PDFBenchmarkCorpus corpusWithName:@"deep-10k" FieldCount:10000 Depth:16]];
+
+    PDFBenchmarkCorpus* revisions = [PDFBenchmarkCorpus corpusWithName:@"revisions-10k" FieldCount:10000 Depth:3];
+    revisions.revisionCount = 200;
+    [ret addObject:revisions];
+
+    PDFBenchmarkCorpus* xrefStreams = [PDFBenchmarkCorpus corpusWithName:@"xrefstream-10k" FieldCount:10000 Depth:3];
+    xrefStreams.usesCrossReferenceStreams = YES;
+    xrefStreams.revisionCount = 20;
+    [ret addObject:xrefStreams];
+
+    PDFBenchmarkCorpus* binary = [PDFBenchmarkCorpus corpusWithName:@"binary-1k" FieldCount:1000 Depth:1];
+    binary.binaryStreamLength = 32*1024*1024;
+    [ret addObject:binary];
+
+    return [NSArray arrayWithArray:ret];
+}
+
+
+-(NSString*)nameOfFieldAtIndex:(NSUInteger)index
+{
+    _branching = [self branching];
+    NSMutableString* ret = [NSMutableString string];
+    for(NSUInteger level = 1 ; level < _depth ; level++)
+    {
+        [ret appendFormat:@"g%u.",(unsigned int)(index/[self spanOfLevel:level])];
+    }
+    [ret appendFormat:@"f%u",(unsigned int)index];
+    return ret;
+}
+
+
+-(BOOL)writeToPath:(NSString*)path
+{
+    _file = fopen([path fileSystemRepresentation], "wb");
+    if(_file == NULL)return NO;
+    _offset = 0;
+    _failed = NO;
+
+    // Objects are numbered level by level, so the terminal fields come last and are contiguous.
+    _branching = [self branching];
+    _firstNumbers = calloc(_depth+1, sizeof(NSUInteger));
+    NSUInteger next = (_binaryStreamLength?PDFBenchmarkCorpusImageNumber+1:PDFBenchmarkCorpusImageNumber);
+    for(NSUInteger level = 1 ; level <= _depth ; level++)
+    {
+        _firstNumbers[level] = next;
+        next += [self countOfLevel:level];
+    }
+    NSUInteger nodeCount = next-_firstNumbers[1];
+    _firstStreamNumber = next;
+    if(_usesCrossReferenceStreams)next += (nodeCount+PDFBenchmarkCorpusObjectsPerStream-1)/PDFBenchmarkCorpusObjectsPerStream;
+    _size = next;
+    _entries = calloc(_size+_revisionCount+1, sizeof(PDFBenchmarkCorpusEntry));
+
+    // The comment after the header holds bytes above 127, marking the file as binary.
+    const unsigned char header[] = "%PDF-1.5\n%\xE2\xE3\xCF\xD3\n";
+    [self writeBytes:header Length:sizeof(header)-1];
+
+    NSMutableString* fields = [NSMutableString string];
+    for(NSUInteger i = 0 ; i < [self countOfLevel:1] ; i++)[fields appendFormat:@"%u 0 R ",(unsigned int)[self objectNumberOfNodeAtLevel:1 Index:i]];
+    NSMutableString* annots = [NSMutableString string];
+    for(NSUInteger i = 0 ; i < _fieldCount ; i++)[annots appendFormat:@"%u 0 R ",(unsigned int)[self objectNumberOfNodeAtLevel:_depth Index:i]];
+    NSString* resources = (_binaryStreamLength?[NSString stringWithFormat:@"/Resources << /XObject << /Im0 %u 0 R >> >> ",PDFBenchmarkCorpusImageNumber]:@"");
+
+    [self writeObjectWithNumber:1 Body:@"<< /Type /Catalog /Pages 2 0 R /AcroForm 3 0 R >>"];
+    [self writeObjectWithNumber:2 Body:[NSString stringWithFormat:@"<< /Type /Pages /Kids [%u 0 R] /Count 1 >>",PDFBenchmarkCorpusPageNumber]];
+    [self writeObjectWithNumber:3 Body:[NSString stringWithFormat:@"<< /Fields [%@] /DA (/Helv 0 Tf 0 g) >>",fields]];
+    [self writeObjectWithNumber:PDFBenchmarkCorpusPageNumber Body:[NSString stringWithFormat:@"<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] %@/Contents 5 0 R /Annots [%@] >>",resources,annots]];
+    [self writeStreamWithNumber:5 Dictionary:@"" Data:[@"q Q\n" dataUsingEncoding:NSASCIIStringEncoding]];
+    if(_binaryStreamLength)[self writeImage];
+
+    if(_usesCrossReferenceStreams)[self writeFieldsInObjectStreams];
+    else
+    {
+        for(NSUInteger level = 1 ; level <= _depth ; level++)
+        {
+            for(NSUInteger i = 0 ; i < [self countOfLevel:level] ; i++)
+            {
+                [self writeObjectWithNumber:[self objectNumberOfNodeAtLevel:level Index:i] Body:[self bodyOfNodeAtLevel:level Index:i Revision:0]];
+            }
+        }
+    }
+
+    NSUInteger prev = [self writeCrossReferenceForNumbers:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, _size)] Prev:NSNotFound];
+
+    // Each revision rewrites its fields in place of the originals, as an incremental save does.
+    NSUInteger step = MIN(_fieldCount, PDFBenchmarkCorpusRevisionStep);
+    for(NSUInteger revision = 1 ; revision <= _revisionCount && step > 0 ; revision++)
+    {
+        NSMutableIndexSet* numbers = [NSMutableIndexSet indexSet];
+        for(NSUInteger i = revision%step ; i < _fieldCount ; i += step)
+        {
+            NSUInteger number = [self objectNumberOfNodeAtLevel:_depth Index:i];
+            [self writeObjectWithNumber:number Body:[self bodyOfNodeAtLevel:_depth Index:i Revision:revision]];
+            [numbers addIndex:number];
+        }
+        prev = [self writeCrossReferenceForNumbers:numbers Prev:prev];
+    }
+
+    free(_firstNumbers);
+    free(_entries);
+    _firstNumbers = NULL;
+    _entries = NULL;
+
+    if(fclose(_file) != 0)_failed = YES;
+    _file = NULL;
+    return (_failed == NO);
+}
+
+
+#pragma mark - Hidden
+
+
+// The smallest number of kids per non-terminal field that fits every field in the requested depth.
+
+-(NSUInteger)branching
+{
+    if(_depth < 2 || _fieldCount < 2)return 2;
+    NSUInteger ret = 2;
+    while(PDFBenchmarkCorpusPower(ret, _depth-1, _fieldCount) < _fieldCount)ret++;
+    return ret;
+}
+
+
+// The number of terminal fields under each field of a level. Levels are numbered from 1, the top level, to depth, the terminal fields.
+
+-(NSUInteger)spanOfLevel:(NSUInteger)level
+{
+    return MAX(PDFBenchmarkCorpusPower(_branching, _depth-level, _fieldCount), 1);
+}
+
+
+-(NSUInteger)countOfLevel:(NSUInteger)level
+{
+    NSUInteger span = [self spanOfLevel:level];
+    return (_fieldCount+span-1)/span;
+}
+
+
+-(NSUInteger)objectNumberOfNodeAtLevel:(NSUInteger)level Index:(NSUInteger)index
+{
+    return _firstNumbers[level]+index;
+}
+
+
+-(NSString*)bodyOfNodeAtLevel:(NSUInteger)level Index:(NSUInteger)index Revision:(NSUInteger)revision
+{
+    NSMutableString* ret = [NSMutableString stringWithString:@"<< "];
+
+    if(level < _depth)
+    {
+        [ret appendFormat:@"/T (g%u) /Kids [",(unsigned int)index];
+        NSUInteger span = [self spanOfLevel:level];
+        NSUInteger kidSpan = [self spanOfLevel:level+1];
+        NSUInteger last = MIN([self countOfLevel:level+1], ((index+1)*span+kidSpan-1)/kidSpan);
+        for(NSUInteger kid = index*span/kidSpan ; kid < last ; kid++)[ret appendFormat:@"%u 0 R ",(unsigned int)[self objectNumberOfNodeAtLevel:level+1 Index:kid]];
+        [ret appendString:@"] "];
+    }
+    else
+    {
+        NSString* value = (revision?[NSString stringWithFormat:@"Value %u revision %u",(unsigned int)index,(unsigned int)revision]:[NSString stringWithFormat:@"Value %u",(unsigned int)index]);
+        NSUInteger column = index%20;
+        NSUInteger row = (index/20)%25;
+        [ret appendFormat:@"/FT /Tx /T (f%u) /V (%@) /Type /Annot /Subtype /Widget /F 4 /P %u 0 R /Rect [%u %u %u %u] /DA (/Helv 10 Tf 0 g) ",(unsigned int)index,value,PDFBenchmarkCorpusPageNumber,(unsigned int)(16+column*29),(unsigned int)(20+row*30),(unsigned int)(42+column*29),(unsigned int)(40+row*30)];
+    }
+
+    if(level > 1)
+    {
+        NSUInteger parent = index*[self spanOfLevel:level]/[self spanOfLevel:level-1];
+        [ret appendFormat:@"/Parent %u 0 R ",(unsigned int)[self objectNumberOfNodeAtLevel:level-1 Index:parent]];
+    }
+
+    [ret appendString:@">>"];
+    return ret;
+}
+
+
+-(void)writeBytes:(const void*)bytes Length:(NSUInteger)length
+{
+    if(_failed || length == 0)return;
+    if(fwrite(bytes, 1, length, _file) != length)_failed = YES;
+    _offset += length;
+}
+
+
+-(void)writeString:(NSString*)str
+{
+    const char* ascii = [str UTF8String];
+    [self writeBytes:ascii Length:strlen(ascii)];
+}
+
+
+-(void)writeObjectWithNumber:(NSUInteger)number Body:(NSString*)body
+{
+    _entries[number] = (PDFBenchmarkCorpusEntry){1, _offset, 0};
+    [self writeString:[NSString stringWithFormat:@"%u 0 obj\n%@\nendobj\n",(unsigned int)number,body]];
+}
+
+
+-(void)writeStreamWithNumber:(NSUInteger)number Dictionary:(NSString*)dictionary Data:(NSData*)data
+{
+    _entries[number] = (PDFBenchmarkCorpusEntry){1, _offset, 0};
+    [self writeString:[NSString stringWithFormat:@"%u 0 obj\n<< %@/Length %u >>\nstream\n",(unsigned int)number,dictionary,(unsigned int)[data length]]];
+    [self writeBytes:[data bytes] Length:[data length]];
+    [self writeString:@"\nendstream\nendobj\n"];
+}
+
+
+// A grayscale image of random bytes, compressed so that reading it exercises the decoder.
+
+-(void)writeImage
+{
+    NSUInteger height = (_binaryStreamLength+PDFBenchmarkCorpusImageWidth-1)/PDFBenchmarkCorpusImageWidth;
+    NSMutableData* pixels = [NSMutableData dataWithLength:height*PDFBenchmarkCorpusImageWidth];
+    arc4random_buf([pixels mutableBytes], [pixels length]);
+
+    uLongf length = compressBound([pixels length]);
+    NSMutableData* deflated = [NSMutableData dataWithLength:length];
+    if(compress2([deflated mutableBytes], &length, [pixels bytes], [pixels length], Z_DEFAULT_COMPRESSION) != Z_OK)
+    {
+        _failed = YES;
+        return;
+    }
+    [deflated setLength:length];
+
+    NSString* dictionary = [NSString stringWithFormat:@"/Type /XObject /Subtype /Image /Width %u /Height %u /ColorSpace /DeviceGray /BitsPerComponent 8 /Filter /FlateDecode ",PDFBenchmarkCorpusImageWidth,(unsigned int)height];
+    [self writeStreamWithNumber:PDFBenchmarkCorpusImageNumber Dictionary:dictionary Data:deflated];
+}
+
+
+-(void)writeFieldsInObjectStreams
+{
+    NSUInteger stream = _firstStreamNumber;
+    NSMutableString* offsets = [NSMutableString string];
+    NSMutableData* objects = [NSMutableData data];
+    NSUInteger count = 0;
+
+    for(NSUInteger level = 1 ; level <= _depth ; level++)
+    {
+        for(NSUInteger i = 0 ; i < [self countOfLevel:level] ; i++)
+        {
+            NSUInteger number = [self objectNumberOfNodeAtLevel:level Index:i];
+            NSData* body = [[[self bodyOfNodeAtLevel:level Index:i Revision:0] stringByAppendingString:@"\n"] dataUsingEncoding:NSUTF8StringEncoding];
+            [offsets appendFormat:@"%u %u ",(unsigned int)number,(unsigned int)[objects length]];
+            [objects appendData:body];
+
+            BOOL last = (level == _depth && i+1 == [self countOfLevel:level]);
+            if(++count < PDFBenchmarkCorpusObjectsPerStream && last == NO)continue;
+
+            // The entries of the packed objects are set after the stream, which records its own entry.
+            NSMutableData* data = [NSMutableData dataWithData:[offsets dataUsingEncoding:NSASCIIStringEncoding]];
+            NSUInteger first = [data length];
+            [data appendData:objects];
+
+            uLongf length = compressBound([data length]);
+            NSMutableData* deflated = [NSMutableData dataWithLength:length];
+            if(compress2([deflated mutableBytes], &length, [data bytes], [data length], Z_DEFAULT_COMPRESSION) != Z_OK)
+            {
+                _failed = YES;
+                return;
+            }
+            [deflated setLength:length];
+
+            [self writeStreamWithNumber:stream Dictionary:[NSString stringWithFormat:@"/Type /ObjStm /N %u /First %u /Filter /FlateDecode ",(unsigned int)count,(unsigned int)first] Data:deflated];
+            for(NSUInteger j = 0 ; j < count ; j++)_entries[number+1-count+j] = (PDFBenchmarkCorpusEntry){2, stream, j};
+
+            stream++;
+            count = 0;
+            [offsets setString:@""];
+            [objects setLength:0];
+        }
+    }
+}
+
+
+// Writes a cross-reference section for numbers, as a table or as a stream, and returns its offset.
+
+-(NSUInteger)writeCrossReferenceForNumbers:(NSIndexSet*)numbers Prev:(NSUInteger)prev
+{
+    NSUInteger ret = _offset;
+    NSString* prevEntry = (prev != NSNotFound?[NSString stringWithFormat:@"/Prev %u ",(unsigned int)prev]:@"");
+
+    if(_usesCrossReferenceStreams)
+    {
+        NSUInteger number = _size++;
+        _entries[number] = (PDFBenchmarkCorpusEntry){1, ret, 0};
+        NSMutableIndexSet* allNumbers = [numbers mutableCopy];
+        [allNumbers addIndex:number];
+
+        NSMutableString* index = [NSMutableString string];
+        [allNumbers enumerateRangesUsingBlock:^(NSRange range, BOOL* stop)
+        {
+            [index appendFormat:@"%u %u ",(unsigned int)range.location,(unsigned int)range.length];
+        }];
+
+        NSMutableData* data = [NSMutableData dataWithCapacity:[allNumbers count]*7];
+        [allNumbers enumerateIndexesUsingBlock:^(NSUInteger n, BOOL* stop)
+        {
+            PDFBenchmarkCorpusEntry entry = (n == 0?(PDFBenchmarkCorpusEntry){0, 0, 65535}:_entries[n]);
+            unsigned char bytes[7] = {entry.type, (entry.field2>>24)&0xFF, (entry.field2>>16)&0xFF, (entry.field2>>8)&0xFF, entry.field2&0xFF, (entry.field3>>8)&0xFF, entry.field3&0xFF};
+            [data appendBytes:bytes length:7];
+        }];
+
+        [self writeStreamWithNumber:number Dictionary:[NSString stringWithFormat:@"/Type /XRef /Size %u /W [1 4 2] /Index [%@] /Root 1 0 R %@",(unsigned int)_size,index,prevEntry] Data:data];
+    }
+    else
+    {
+        NSMutableString* table = [NSMutableString stringWithString:@"xref\n"];
+        [numbers enumerateRangesUsingBlock:^(NSRange range, BOOL* stop)
+        {
+            [table appendFormat:@"%u %u\n",(unsigned int)range.location,(unsigned int)range.length];
+            for(NSUInteger n = range.location ; n < NSMaxRange(range) ; n++)
+            {
+                if(n == 0)[table appendString:@"0000000000 65535 f\r\n"];
+                else [table appendFormat:@"%010u 00000 n\r\n",(unsigned int)_entries[n].field2];
+            }
+        }];
+        [table appendFormat:@"trailer\n<< /Size %u /Root 1 0 R %@>>\n",(unsigned int)_size,prevEntry];
+        [self writeString:table];
+    }
+
+    [self writeString:[NSString stringWithFormat:@"startxref\n%u\n%%%%EOF\n",(unsigned int)ret]];
+    return ret;
+}
+
+
+@end
@@ -0,0 +1,175 @@
+#import <XCTest/XCTest.h>
+#import "PDFBenchmarkCorpus.h"
+#import "PDFDocument.h"
+#import "PDFFormContainer.h"
+#import "PDFForm.h"
+#import "PDFFormDataWriter.h"
+#import "PDFChromeTraceSink.h"
+
+// Each phase is run this many times and the fastest run is reported.
+#define PDFBenchmarkIterations 3
+
+// Lookups and value changes are made on this many fields spread evenly through the document.
+#define PDFBenchmarkSampleSize 1000
+
+
+/** The benchmark suite times the main operations of ILPDFKit on the documents of [PDFBenchmarkCorpus standardCorpus].
+ It only runs when the PDF_BENCHMARK environment variable is set, so regular test runs stay fast:
+
+     PDF_BENCHMARK=1 xcodebuild test -project PDFSampleApp.xcodeproj -scheme PDFSampleApp -destination 'platform=iOS Simulator,name=iPhone Retina (4-inch)'
+
+ PDF_BENCHMARK_CORPUS may hold a comma separated list of corpus names to run. The results are written as JSON to PDF_BENCHMARK_RESULTS, or to PDFBenchmarkResults.json in the temporary directory, so two runs can be compared with any JSON tool. All times are in seconds. If PDF_BENCHMARK_TRACE holds a path, a Chrome trace of the whole run is written to it.
+ */
+@interface PDFBenchmarkTests : XCTestCase
+@end
+
+
+@interface PDFBenchmarkTests()
+    -(NSDictionary*)runCorpus:(PDFBenchmarkCorpus*)corpus AtPath:(NSString*)path;
+    -(NSDictionary*)timePhasesOfCorpus:(PDFBenchmarkCorpus*)corpus AtPath:(NSString*)path Names:(NSArray*)names;
+@end
+
+
+@implementation PDFBenchmarkTests
+
+
+-(void)testBenchmarks
+{
+    NSDictionary* environment = [[NSProcessInfo processInfo] environment];
+    if(environment[@"PDF_BENCHMARK"] == nil)
+    {
+        NSLog(@"Benchmarks skipped. Set PDF_BENCHMARK to run them.");
+        return;
+    }
+
+    NSArray* selected = [environment[@"PDF_BENCHMARK_CORPUS"] componentsSeparatedByString:@","];
+    NSString* directory = [NSTemporaryDirectory() stringByAppendingPathComponent:@"PDFBenchmarkCorpus"];
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:NULL];
+
+    PDFChromeTraceSink* sink = (environment[@"PDF_BENCHMARK_TRACE"]?[[PDFChromeTraceSink alloc] init]:nil);
+    [PDFTrace setSink:sink];
+
+    NSMutableArray* results = [NSMutableArray array];
+    for(PDFBenchmarkCorpus* corpus in [PDFBenchmarkCorpus standardCorpus])
+    {
+        if(selected && [selected containsObject:corpus.name] == NO)continue;
+
+        NSString* path = [directory stringByAppendingPathComponent:[corpus.name stringByAppendingPathExtension:@"pdf"]];
+        XCTAssertTrue([corpus writeToPath:path], @"Could not write %@",corpus.name);
+
+        NSDictionary* result = [self runCorpus:corpus AtPath:path];
+        if(result)[results addObject:result];
+        [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+    }
+
+    [PDFTrace setSink:nil];
+    if(sink)XCTAssertTrue([sink writeToPath:environment[@"PDF_BENCHMARK_TRACE"]], @"Could not write the trace");
+
+    NSProcessInfo* info = [NSProcessInfo processInfo];
+    NSDictionary* run = @{
+        @"date": [NSString stringWithFormat:@"%.0f",[[NSDate date] timeIntervalSince1970]],
+        @"system": [info operatingSystemVersionString],
+        @"processors": @([info processorCount]),
+        @"memory": @([info physicalMemory]),
+        @"iterations": @(PDFBenchmarkIterations),
+        @"corpus": results
+    };
+
+    NSString* output = environment[@"PDF_BENCHMARK_RESULTS"];
+    if(output == nil)output = [NSTemporaryDirectory() stringByAppendingPathComponent:@"PDFBenchmarkResults.json"];
+
+    NSData* json = [NSJSONSerialization dataWithJSONObject:run options:NSJSONWritingPrettyPrinted error:NULL];
+    XCTAssertTrue([json writeToFile:output atomically:YES], @"Could not write results to %@",output);
+    NSLog(@"Benchmark results written to %@",output);
+}
+
+
+#pragma mark - Hidden
+
+
+-(NSDictionary*)runCorpus:(PDFBenchmarkCorpus*)corpus AtPath:(NSString*)path
+{
+    NSMutableArray* names = [NSMutableArray arrayWithCapacity:PDFBenchmarkSampleSize];
+    NSUInteger step = MAX(corpus.fieldCount/PDFBenchmarkSampleSize, 1);
+    for(NSUInteger i = 0 ; i < corpus.fieldCount && [names count] < PDFBenchmarkSampleSize ; i += step)[names addObject:[corpus nameOfFieldAtIndex:i]];
+
+    NSMutableDictionary* best = nil;
+    for(NSUInteger iteration = 0 ; iteration < PDFBenchmarkIterations ; iteration++)
+    {
+        @autoreleasepool
+        {
+            NSDictionary* times = [self timePhasesOfCorpus:corpus AtPath:path Names:names];
+            if(times == nil)return nil;
+
+            if(best == nil)best = [times mutableCopy];
+            else for(NSString* phase in times)best[phase] = @(MIN([best[phase] doubleValue], [times[phase] doubleValue]));
+        }
+    }
+
+    NSDictionary* attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:path error:NULL];
+    return @{
+        @"name": corpus.name,
+        @"fields": @(corpus.fieldCount),
+        @"depth": @(corpus.depth),
+        @"revisions": @(corpus.revisionCount),
+        @"crossReferenceStreams": @(corpus.usesCrossReferenceStreams),
+        @"binaryStreamLength": @(corpus.binaryStreamLength),
+        @"bytes": @([attributes fileSize]),
+        @"phases": best
+    };
+}
+
+
+// One pass over the phases, each timed separately on the same document.
+
+-(NSDictionary*)timePhasesOfCorpus:(PDFBenchmarkCorpus*)corpus AtPath:(NSString*)path Names:(NSArray*)names
+{
+    NSMutableDictionary* ret = [NSMutableDictionary dictionary];
+    NSString* savePath = [path stringByAppendingPathExtension:@"saved.pdf"];
+    NSString* exportPath = [path stringByAppendingPathExtension:@"xfdf"];
+
+    NSTimeInterval start = [[NSProcessInfo processInfo] systemUptime];
+    PDFDocument* document = [[PDFDocument alloc] initWithPath:path];
+    PDFFormContainer* forms = document.forms;
+    ret[@"open"] = @([[NSProcessInfo processInfo] systemUptime]-start);
+
+    NSUInteger count = 0;
+    start = [[NSProcessInfo processInfo] systemUptime];
+    for(PDFForm* form in forms)
+    {
+        if(form.name && form.value)count++;
+    }
+    ret[@"enumerate"] = @([[NSProcessInfo processInfo] systemUptime]-start);
+    XCTAssertEqual(count, corpus.fieldCount, @"%@ has %u fields with values",corpus.name,(unsigned int)count);
+    if(count != corpus.fieldCount)return nil;
+
+    NSUInteger found = 0;
+    start = [[NSProcessInfo processInfo] systemUptime];
+    for(NSString* name in names)found += [[forms formsWithName:name] count];
+    ret[@"lookup"] = @([[NSProcessInfo processInfo] systemUptime]-start);
+    XCTAssertEqual(found, [names count], @"%@ lookups failed",corpus.name);
+
+    start = [[NSProcessInfo processInfo] systemUptime];
+    for(NSString* name in names)[forms setValue:@"Benchmark" ForFormWithName:name];
+    ret[@"set"] = @([[NSProcessInfo processInfo] systemUptime]-start);
+
+    start = [[NSProcessInfo processInfo] systemUptime];
+    BOOL saved = [document saveFormsToPath:savePath];
+    ret[@"save"] = @([[NSProcessInfo processInfo] systemUptime]-start);
+    XCTAssertTrue(saved, @"%@ could not be saved",corpus.name);
+
+    start = [[NSProcessInfo processInfo] systemUptime];
+    NSOutputStream* stream = [NSOutputStream outputStreamToFileAtPath:exportPath append:NO];
+    [stream open];
+    BOOL exported = [[[PDFFormDataWriter alloc] initWithOutputStream:stream] writeXFDFForForms:forms];
+    [stream close];
+    ret[@"export"] = @([[NSProcessInfo processInfo] systemUptime]-start);
+    XCTAssertTrue(exported, @"%@ could not be exported",corpus.name);
+
+    [[NSFileManager defaultManager] removeItemAtPath:savePath error:NULL];
+    [[NSFileManager defaultManager] removeItemAtPath:exportPath error:NULL];
+    return ret;
+}
+
+
+@end
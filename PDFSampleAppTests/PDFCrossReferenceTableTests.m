@@ -0,0 +1,129 @@
+#import <XCTest/XCTest.h>
+#import "PDFTestFile.h"
+#import "PDFCrossReferenceTable.h"
+#import "PDFDocument.h"
+#import "PDFDictionary.h"
+#import "PDFObjectStream.h"
+
+
+/** Tests of the cross-reference index on hand-built files: classic tables, cross-reference streams, hybrid files and incremental updates.
+ */
+@interface PDFCrossReferenceTableTests : XCTestCase
+@end
+
+
+@interface PDFCrossReferenceTableTests()
+    -(PDFTestFile*)hybridFile;
+@end
+
+
+@implementation PDFCrossReferenceTableTests
+
+
+-(void)testHybridFileReadsCompressedObject
+{
+    PDFTestFile* file = [self hybridFile];
+    PDFCrossReferenceTable* table = [[PDFCrossReferenceTable alloc] initWithData:file.data Document:nil];
+
+    PDFCrossReferenceEntry entry = [table entryForObjectWithNumber:4];
+    XCTAssertEqual(entry.type, PDFCrossReferenceEntryTypeCompressed);
+    XCTAssertEqual(entry.offset, (NSUInteger)6);
+    XCTAssertEqual(entry.index, (NSUInteger)0);
+
+    PDFDocument* document = [[PDFDocument alloc] initWithData:file.data];
+    NSString* code = [document codeForObjectWithNumber:4 GenerationNumber:0];
+    XCTAssertTrue([code rangeOfString:@"(old)"].location != NSNotFound, @"Read %@",code);
+}
+
+
+-(void)testUpdateOfCompressedObjectInHybridFile
+{
+    PDFTestFile* file = [self hybridFile];
+    NSUInteger prev = [[[[PDFCrossReferenceTable alloc] initWithData:file.data Document:nil].sectionOffsets firstObject] unsignedIntegerValue];
+
+    // The update redefines the compressed object as a plain one, as an incremental save does.
+    [file appendObjectWithNumber:4 Body:@"<< /V (new) >>"];
+    NSMutableIndexSet* numbers = [NSMutableIndexSet indexSetWithIndex:0];
+    [numbers addIndex:4];
+    [file appendCrossReferenceTableForNumbers:numbers Trailer:[NSString stringWithFormat:@"/Size 8 /Root 1 0 R /Prev %u",(unsigned int)prev]];
+
+    PDFCrossReferenceTable* table = [[PDFCrossReferenceTable alloc] initWithData:file.data Document:nil];
+    XCTAssertEqual([table.sectionOffsets count], (NSUInteger)2);
+    XCTAssertEqual([table entryForObjectWithNumber:4].type, PDFCrossReferenceEntryTypeInUse);
+    XCTAssertEqual([table offsetForObjectWithNumber:4 GenerationNumber:0], [file offsetOfObjectWithNumber:4]);
+
+    PDFDocument* document = [[PDFDocument alloc] initWithData:file.data];
+    NSString* code = [document codeForObjectWithNumber:4 GenerationNumber:0];
+    XCTAssertTrue([code rangeOfString:@"(new)"].location != NSNotFound, @"Read %@",code);
+}
+
+
+-(void)testMalformedSubsectionsAreRejected
+{
+    // A negative first number, a first number past any file and a count larger than the table are each rejected without allocating entries for them.
+    for(NSString* subsection in @[@"-1 1",@"1000000000 1",@"1 -1",@"1 100000"])
+    {
+        PDFTestFile* file = [[PDFTestFile alloc] init];
+        [file appendObjectWithNumber:1 Body:@"<< /Type /Catalog >>"];
+        NSUInteger offset = [file.data length];
+        [file appendString:[NSString stringWithFormat:@"xref\n%@\n0000000015 00000 n\r\ntrailer\n<< /Size 2 /Root 1 0 R >>\n",subsection]];
+        [file appendStartxref:offset];
+
+        PDFCrossReferenceTable* table = [[PDFCrossReferenceTable alloc] initWithData:file.data Document:nil];
+        XCTAssertEqual([table.sectionOffsets count], (NSUInteger)0, @"Read subsection %@",subsection);
+        XCTAssertEqual(table.count, (NSUInteger)0);
+    }
+
+    // The same bounds apply to the 'Index' of a cross-reference stream.
+    for(NSString* index in @[@"[-1 1]",@"[1000000000 1]"])
+    {
+        PDFTestFile* file = [[PDFTestFile alloc] init];
+        [file appendObjectWithNumber:1 Body:@"<< /Type /Catalog >>"];
+        const unsigned char entries[] = {1, 0, 15, 0};
+        [file appendStreamWithNumber:2 Dictionary:[NSString stringWithFormat:@"/Type /XRef /Size 3 /W [1 2 1] /Index %@ /Root 1 0 R",index] Data:[NSData dataWithBytes:entries length:sizeof(entries)]];
+        [file appendStartxref:[file offsetOfObjectWithNumber:2]];
+
+        PDFCrossReferenceTable* table = [[PDFCrossReferenceTable alloc] initWithData:file.data Document:nil];
+        XCTAssertEqual([table.sectionOffsets count], (NSUInteger)0, @"Read index %@",index);
+        XCTAssertEqual(table.count, (NSUInteger)0);
+    }
+}
+
+
+-(void)testMalformedObjectStreamCountIsRejected
+{
+    NSData* data = [@"4 0 << /V (old) >>" dataUsingEncoding:NSASCIIStringEncoding];
+    PDFDictionary* dictionary = [[PDFDictionary alloc] initWithPDFRepresentation:@"<< /Type /ObjStm /N 1 /First 4 >>" Document:nil];
+    XCTAssertEqual([[PDFObjectStream alloc] initWithData:data Dictionary:dictionary].count, (NSUInteger)1);
+
+    // A negative or huge 'N' cannot fit in the header, and is rejected before anything is allocated for it.
+    for(NSString* count in @[@"-1",@"2",@"4611686018427387904"])
+    {
+        dictionary = [[PDFDictionary alloc] initWithPDFRepresentation:[NSString stringWithFormat:@"<< /Type /ObjStm /N %@ /First 4 >>",count] Document:nil];
+        XCTAssertNil([[PDFObjectStream alloc] initWithData:data Dictionary:dictionary], @"Read N %@",count);
+    }
+}
+
+
+#pragma mark - Hidden
+
+
+// A hybrid file: object 4 is stored in object stream 6, listed as free by the table and described by cross-reference stream 7, which the 'XRefStm' entry points to.
+
+-(PDFTestFile*)hybridFile
+{
+    PDFTestFile* ret = [[PDFTestFile alloc] init];
+    [ret appendObjectWithNumber:1 Body:@"<< /Type /Catalog /Pages 2 0 R >>"];
+    [ret appendObjectWithNumber:2 Body:@"<< /Type /Pages /Kids [] /Count 0 >>"];
+    [ret appendStreamWithNumber:6 Dictionary:@"/Type /ObjStm /N 1 /First 4" Data:[@"4 0 << /V (old) >>" dataUsingEncoding:NSASCIIStringEncoding]];
+
+    const unsigned char entries[] = {2, 0, 6, 0};
+    [ret appendStreamWithNumber:7 Dictionary:@"/Type /XRef /Size 8 /W [1 2 1] /Index [4 1]" Data:[NSData dataWithBytes:entries length:sizeof(entries)]];
+
+    NSString* trailer = [NSString stringWithFormat:@"/Size 8 /Root 1 0 R /XRefStm %u",(unsigned int)[ret offsetOfObjectWithNumber:7]];
+    [ret appendCrossReferenceTableForNumbers:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 8)] Trailer:trailer];
+    return ret;
+}
+
+
+@end
@@ -0,0 +1,190 @@
+#import <XCTest/XCTest.h>
+#import "PDFTestFile.h"
+#import "PDFDocument.h"
+#import "PDFFileDataSource.h"
+#import "PDFMappedFile.h"
+#import "PDFFormContainer.h"
+
+
+/** Tests of reading files by range: the file data source, the merging and read-ahead of PDFMappedFile, and documents that read only the bytes they need.
+ */
+@interface PDFDataSourceTests : XCTestCase
+@end
+
+
+@interface PDFDataSourceTests()
+    -(NSString*)temporaryPath;
+    -(NSString*)pathOfCountingBytesWithLength:(NSUInteger)length;
+    -(PDFTestFile*)paddedForm;
+@end
+
+
+@implementation PDFDataSourceTests
+
+
+-(void)testFileDataSourceReadsExactRanges
+{
+    NSString* path = [self pathOfCountingBytesWithLength:1000];
+    PDFFileDataSource* source = [[PDFFileDataSource alloc] initWithPath:path];
+    XCTAssertEqual([source length], (NSUInteger)1000);
+
+    NSData* data = [source dataWithRange:NSMakeRange(300, 4)];
+    const unsigned char expected[] = {44, 45, 46, 47};
+    XCTAssertEqualObjects(data, [NSData dataWithBytes:expected length:sizeof(expected)]);
+    XCTAssertNil([source dataWithRange:NSMakeRange(990, 20)]);
+
+    XCTAssertEqual(source.numberOfReads, (NSUInteger)1);
+    XCTAssertEqual(source.numberOfBytesRead, (NSUInteger)4);
+    [source resetStatistics];
+    XCTAssertEqual(source.numberOfReads, (NSUInteger)0);
+    XCTAssertEqual(source.numberOfBytesRead, (NSUInteger)0);
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+
+-(void)testMappedFileMergesNearbyRanges
+{
+    NSString* path = [self pathOfCountingBytesWithLength:200000];
+    PDFFileDataSource* source = [[PDFFileDataSource alloc] initWithPath:path];
+    PDFMappedFile* file = [[PDFMappedFile alloc] initWithDataSource:source];
+    file.readAheadLength = 0;
+    XCTAssertEqual(source.numberOfReads, (NSUInteger)0);
+
+    // Ranges a kilobyte apart are fetched as one read, gap included.
+    XCTAssertTrue([file loadRanges:@[[NSValue valueWithRange:NSMakeRange(0, 100)],[NSValue valueWithRange:NSMakeRange(1000, 100)]]]);
+    XCTAssertEqual(source.numberOfReads, (NSUInteger)1);
+    XCTAssertEqual(source.numberOfBytesRead, (NSUInteger)1100);
+
+    // Bytes already present are not fetched again.
+    unsigned char bytes[4];
+    XCTAssertEqual([file getBytes:bytes Range:NSMakeRange(500, 4)], (NSUInteger)4);
+    XCTAssertEqual(bytes[0], (unsigned char)(500%256));
+    XCTAssertEqual(source.numberOfReads, (NSUInteger)1);
+
+    // Distant ranges are fetched separately.
+    XCTAssertTrue([file loadRanges:@[[NSValue valueWithRange:NSMakeRange(50000, 10)],[NSValue valueWithRange:NSMakeRange(150000, 10)]]]);
+    XCTAssertEqual(source.numberOfReads, (NSUInteger)3);
+    XCTAssertEqual(source.numberOfBytesRead, (NSUInteger)1120);
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+
+-(void)testMappedFileReadsAhead
+{
+    NSString* path = [self pathOfCountingBytesWithLength:200000];
+    PDFFileDataSource* source = [[PDFFileDataSource alloc] initWithPath:path];
+    PDFMappedFile* file = [[PDFMappedFile alloc] initWithDataSource:source];
+    file.readAheadLength = 1000;
+
+    XCTAssertTrue([file loadRange:NSMakeRange(10000, 10)]);
+    XCTAssertEqual(source.numberOfBytesRead, (NSUInteger)1010);
+
+    // Bytes within the read-ahead are present, and the read-ahead stops at the end of the file.
+    XCTAssertTrue([file loadRange:NSMakeRange(10500, 500)]);
+    XCTAssertEqual(source.numberOfReads, (NSUInteger)1);
+    XCTAssertTrue([file loadRange:NSMakeRange(199990, 10)]);
+    XCTAssertEqual(source.numberOfBytesRead, (NSUInteger)1020);
+
+    const unsigned char* bytes = [[file data] bytes];
+    XCTAssertEqual(bytes[10999], (unsigned char)(10999%256));
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+
+-(void)testMappedDataReadsOriginalInPlace
+{
+    NSData* original = [@"original" dataUsingEncoding:NSASCIIStringEncoding];
+    PDFMappedFile* file = [[PDFMappedFile alloc] initWithData:original];
+    XCTAssertTrue([file data] == original);
+
+    // After an append, each part is read where it is and the whole reads as one.
+    XCTAssertTrue([file appendData:[@" update" dataUsingEncoding:NSASCIIStringEncoding]]);
+    NSData* data = [file data];
+    XCTAssertEqual([data length], (NSUInteger)15);
+    unsigned char bytes[6];
+    XCTAssertEqual([file getBytes:bytes Range:NSMakeRange(5, 6)], (NSUInteger)6);
+    XCTAssertEqual(memcmp(bytes, "nal up", 6), 0);
+    XCTAssertEqualObjects([data subdataWithRange:NSMakeRange(0, 8)], original);
+    XCTAssertEqualObjects([file appendedData], [@" update" dataUsingEncoding:NSASCIIStringEncoding]);
+    XCTAssertEqualObjects(data, [@"original update" dataUsingEncoding:NSASCIIStringEncoding]);
+}
+
+
+-(void)testDocumentReadsFieldWithoutFetchingWholeFile
+{
+    NSString* path = [self temporaryPath];
+    PDFTestFile* file = [self paddedForm];
+    XCTAssertTrue([file.data writeToFile:path atomically:NO]);
+
+    PDFFileDataSource* source = [[PDFFileDataSource alloc] initWithPath:path];
+    PDFDocument* document = [[PDFDocument alloc] initWithDataSource:source];
+    NSString* code = [document codeForObjectWithNumber:4 GenerationNumber:0];
+    XCTAssertTrue([code rangeOfString:@"(value)"].location != NSNotFound, @"Read %@",code);
+    XCTAssertTrue(source.numberOfBytesRead < [file.data length]/2, @"Read %u of %u bytes",(unsigned int)source.numberOfBytesRead,(unsigned int)[file.data length]);
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+
+-(void)testSavingDocumentOfDataSourceWritesWholeFile
+{
+    NSString* path = [self temporaryPath];
+    NSString* savePath = [self temporaryPath];
+    PDFTestFile* file = [self paddedForm];
+    XCTAssertTrue([file.data writeToFile:path atomically:NO]);
+
+    PDFDocument* document = [[PDFDocument alloc] initWithDataSource:[[PDFFileDataSource alloc] initWithPath:path]];
+    [document.forms setValue:@"changed" ForFormWithName:@"name"];
+    XCTAssertTrue([document saveFormsToPath:savePath]);
+
+    // The saved file is the original file followed by the update.
+    NSData* saved = [NSData dataWithContentsOfFile:savePath];
+    XCTAssertTrue([saved length] > [file.data length]);
+    XCTAssertEqualObjects([saved subdataWithRange:NSMakeRange(0, [file.data length])], file.data);
+
+    PDFDocument* reread = [[PDFDocument alloc] initWithPath:savePath];
+    XCTAssertEqualObjects([reread.forms valueForFormWithName:@"name"], @"changed");
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+    [[NSFileManager defaultManager] removeItemAtPath:savePath error:NULL];
+}
+
+
+#pragma mark - Hidden
+
+
+-(NSString*)temporaryPath
+{
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"PDFDataSourceTests-%@.pdf",[[NSUUID UUID] UUIDString]]];
+}
+
+
+// A file whose byte at offset i is i modulo 256.
+
+-(NSString*)pathOfCountingBytesWithLength:(NSUInteger)length
+{
+    NSMutableData* data = [NSMutableData dataWithLength:length];
+    unsigned char* bytes = [data mutableBytes];
+    for(NSUInteger i = 0 ; i < length ; i++)bytes[i] = (unsigned char)(i%256);
+
+    NSString* ret = [self temporaryPath];
+    [data writeToFile:ret atomically:NO];
+    return ret;
+}
+
+
+// A one page form preceded by a megabyte stream that nothing references, so reading the field needs only the end of the file.
+
+-(PDFTestFile*)paddedForm
+{
+    PDFTestFile* ret = [[PDFTestFile alloc] init];
+    [ret appendStreamWithNumber:6 Dictionary:@"" Data:[NSMutableData dataWithLength:1 << 20]];
+    [ret appendObjectWithNumber:1 Body:@"<< /Type /Catalog /Pages 2 0 R /AcroForm 3 0 R >>"];
+    [ret appendObjectWithNumber:2 Body:@"<< /Type /Pages /Kids [5 0 R] /Count 1 >>"];
+    [ret appendObjectWithNumber:3 Body:@"<< /Fields [4 0 R] /DA (/Helv 0 Tf 0 g) >>"];
+    [ret appendObjectWithNumber:4 Body:@"<< /FT /Tx /T (name) /V (value) /Type /Annot /Subtype /Widget /F 4 /P 5 0 R /Rect [100 700 300 720] /DA (/Helv 10 Tf 0 g) >>"];
+    [ret appendObjectWithNumber:5 Body:@"<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Annots [4 0 R] >>"];
+    [ret appendCrossReferenceTableForNumbers:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 7)] Trailer:@"/Size 7 /Root 1 0 R"];
+    return ret;
+}
+
+
+@end
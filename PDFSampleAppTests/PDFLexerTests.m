@@ -0,0 +1,40 @@
+#import <XCTest/XCTest.h>
+#import "PDFLexer.h"
+
+
+/** Tests of the tokens PDFLexer reads at the edges of its data.
+ */
+@interface PDFLexerTests : XCTestCase
+@end
+
+
+@implementation PDFLexerTests
+
+
+-(void)testStringEndingInBackslashStaysInRange
+{
+    // The backslash is the last byte of the range, so the escaped byte after it must not be read.
+    NSData* data = [@"(ab\\)" dataUsingEncoding:NSASCIIStringEncoding];
+    PDFLexer* lexer = [[PDFLexer alloc] initWithData:data Range:NSMakeRange(0, 4)];
+
+    PDFToken token = [lexer nextToken];
+    XCTAssertEqual(token.type, PDFTokenTypeString);
+    XCTAssertEqual(token.offset+token.length, (NSUInteger)4);
+    XCTAssertEqual(lexer.position, (NSUInteger)4);
+    XCTAssertEqual([lexer nextToken].type, PDFTokenTypeEnd);
+}
+
+
+-(void)testEscapedParenthesisDoesNotCloseString
+{
+    NSData* data = [@"(a\\)b) 1" dataUsingEncoding:NSASCIIStringEncoding];
+    PDFLexer* lexer = [[PDFLexer alloc] initWithData:data];
+
+    PDFToken token = [lexer nextToken];
+    XCTAssertEqual(token.type, PDFTokenTypeString);
+    XCTAssertEqual(token.length, (NSUInteger)6);
+    XCTAssertEqual([lexer nextToken].type, PDFTokenTypeNumber);
+}
+
+
+@end
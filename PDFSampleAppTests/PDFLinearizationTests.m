@@ -0,0 +1,144 @@
+#import <XCTest/XCTest.h>
+#import "PDFTestFile.h"
+#import "PDFDocument.h"
+#import "PDFDictionary.h"
+#import "PDFLinearization.h"
+#import "PDFFormContainer.h"
+
+
+/** Tests of saving linearized files and reading them back: the linearization dictionary, the hint tables, the first page and the end of the linearization on update.
+ */
+@interface PDFLinearizationTests : XCTestCase
+@end
+
+
+@interface PDFLinearizationTests()
+    -(PDFTestFile*)threePageForm;
+    -(NSString*)linearizedPathForFile:(PDFTestFile*)file;
+@end
+
+
+@implementation PDFLinearizationTests
+
+
+-(void)testLinearizationReadsBack
+{
+    NSString* path = [self linearizedPathForFile:[self threePageForm]];
+    NSData* data = [NSData dataWithContentsOfFile:path];
+    PDFLinearization* linearization = [[PDFLinearization alloc] initWithData:data];
+    XCTAssertNotNil(linearization);
+
+    XCTAssertEqual(linearization.fileLength, [data length]);
+    XCTAssertEqual(linearization.numberOfPages, (NSUInteger)3);
+    XCTAssertTrue(linearization.firstPageEndOffset <= [data length]);
+    XCTAssertTrue(linearization.firstPageCrossReferenceOffset < linearization.hintStreamRange.location);
+    XCTAssertTrue(NSMaxRange(linearization.hintStreamRange) <= linearization.firstPageEndOffset);
+
+    // The first page object is named by the dictionary and listed by the first-page section.
+    PDFDocument* document = [[PDFDocument alloc] initWithPath:path];
+    NSString* code = [document codeForObjectWithNumber:linearization.firstPageObjectNumber GenerationNumber:0];
+    XCTAssertTrue([code rangeOfString:@"/Annots"].location != NSNotFound, @"Read %@",code);
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+
+-(void)testHintTablesLocatePages
+{
+    NSString* path = [self linearizedPathForFile:[self threePageForm]];
+    NSData* data = [NSData dataWithContentsOfFile:path];
+    PDFLinearization* linearization = [[PDFLinearization alloc] initWithData:data];
+
+    NSUInteger previousEnd = 0;
+    for(NSUInteger i = 0 ; i < 3 ; i++)
+    {
+        NSRange range = [linearization rangeOfPageAtIndex:i];
+        XCTAssertTrue(range.location != NSNotFound, @"Page %u is not described",(unsigned int)i);
+        XCTAssertTrue(range.location >= previousEnd && NSMaxRange(range) <= [data length]);
+        previousEnd = NSMaxRange(range);
+
+        // Each page range starts with its page object.
+        NSString* start = [[NSString alloc] initWithData:[data subdataWithRange:NSMakeRange(range.location, MIN(range.length, (NSUInteger)64))] encoding:NSASCIIStringEncoding];
+        XCTAssertTrue([start rangeOfString:@" obj"].location != NSNotFound, @"Page %u starts with %@",(unsigned int)i,start);
+    }
+
+    // The first page holds its page object, content stream and widget. The font shared by the other pages is stored after them.
+    XCTAssertTrue([linearization numberOfObjectsOfPageAtIndex:0] >= 3);
+    XCTAssertEqual([linearization numberOfObjectsOfPageAtIndex:1], (NSUInteger)2);
+    XCTAssertEqual([linearization numberOfObjectsOfPageAtIndex:2], (NSUInteger)2);
+    XCTAssertEqual([linearization rangeOfPageAtIndex:3].location, (NSUInteger)NSNotFound);
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+
+-(void)testFirstPageOfLinearizedFile
+{
+    NSString* path = [self linearizedPathForFile:[self threePageForm]];
+    PDFDocument* document = [[PDFDocument alloc] initWithPath:path];
+    XCTAssertNotNil(document.linearization);
+
+    PDFDictionary* page = [document firstPageDictionary];
+    XCTAssertNotNil(page);
+    XCTAssertEqualObjects([page objectForKey:@"Type"], @"Page");
+    XCTAssertEqual([[document widgetAnnotationsOfFirstPage] count], (NSUInteger)1);
+
+    XCTAssertEqual([document numberOfPages], (NSUInteger)3);
+    XCTAssertEqualObjects([document.forms valueForFormWithName:@"name"], @"before");
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+
+-(void)testUpdateEndsLinearization
+{
+    NSString* path = [self linearizedPathForFile:[self threePageForm]];
+    PDFDocument* document = [[PDFDocument alloc] initWithPath:path];
+    XCTAssertNotNil(document.linearization);
+
+    [document.forms setValue:@"after" ForFormWithName:@"name"];
+    XCTAssertTrue([document saveFormsToDocumentData]);
+    XCTAssertNil(document.linearization);
+    XCTAssertNil([[PDFLinearization alloc] initWithData:document.documentData]);
+
+    // The file still reads as an ordinary file, with the update.
+    PDFDocument* updated = [[PDFDocument alloc] initWithData:document.documentData];
+    XCTAssertEqualObjects([updated.forms valueForFormWithName:@"name"], @"after");
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+
+#pragma mark - Hidden
+
+
+// A three page form. The text field is on the first page, and the second and third pages share a font, so the hint tables hold a shared object.
+
+-(PDFTestFile*)threePageForm
+{
+    PDFTestFile* ret = [[PDFTestFile alloc] init];
+    NSData* content = [@"BT /F1 12 Tf 72 720 Td (Page) Tj ET" dataUsingEncoding:NSASCIIStringEncoding];
+    [ret appendObjectWithNumber:1 Body:@"<< /Type /Catalog /Pages 2 0 R /AcroForm 3 0 R >>"];
+    [ret appendObjectWithNumber:2 Body:@"<< /Type /Pages /Kids [5 0 R 7 0 R 9 0 R] /Count 3 >>"];
+    [ret appendObjectWithNumber:3 Body:@"<< /Fields [4 0 R] /DA (/Helv 0 Tf 0 g) >>"];
+    [ret appendObjectWithNumber:4 Body:@"<< /FT /Tx /T (name) /V (before) /Type /Annot /Subtype /Widget /F 4 /P 5 0 R /Rect [100 700 300 720] /DA (/Helv 10 Tf 0 g) >>"];
+    [ret appendObjectWithNumber:5 Body:@"<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Contents 6 0 R /Annots [4 0 R] >>"];
+    [ret appendStreamWithNumber:6 Dictionary:@"" Data:content];
+    [ret appendObjectWithNumber:7 Body:@"<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Contents 8 0 R /Resources << /Font << /F1 11 0 R >> >> >>"];
+    [ret appendStreamWithNumber:8 Dictionary:@"" Data:content];
+    [ret appendObjectWithNumber:9 Body:@"<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Contents 10 0 R /Resources << /Font << /F1 11 0 R >> >> >>"];
+    [ret appendStreamWithNumber:10 Dictionary:@"" Data:content];
+    [ret appendObjectWithNumber:11 Body:@"<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>"];
+    [ret appendCrossReferenceTableForNumbers:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 12)] Trailer:@"/Size 12 /Root 1 0 R"];
+    return ret;
+}
+
+
+// Saves file as a linearized file in the temporary directory and returns its path.
+
+-(NSString*)linearizedPathForFile:(PDFTestFile*)file
+{
+    NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"PDFLinearizationTests-%@.pdf",[[NSUUID UUID] UUIDString]]];
+    PDFDocument* document = [[PDFDocument alloc] initWithData:file.data];
+    XCTAssertTrue([document saveLinearizedToPath:path]);
+    return path;
+}
+
+
+@end
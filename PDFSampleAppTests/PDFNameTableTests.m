@@ -0,0 +1,64 @@
+#import <XCTest/XCTest.h>
+#import "PDFTestFile.h"
+#import "PDFDocument.h"
+#import "PDFDictionary.h"
+#import "PDFNameTable.h"
+
+
+/** Tests of name interning: constants, the per-document tables and the shared table of objects without a document.
+ */
+@interface PDFNameTableTests : XCTestCase
+@end
+
+
+@implementation PDFNameTableTests
+
+
+-(void)testEqualNamesAreTheSameObject
+{
+    PDFNameTable* table = [[PDFNameTable alloc] init];
+    const char bytes[] = "CustomName";
+    NSString* first = [table atomForBytes:bytes Length:strlen(bytes)];
+    NSString* second = [table atomForCString:bytes];
+    NSString* third = [table atomForName:[NSString stringWithFormat:@"Custom%@",@"Name"]];
+    XCTAssertEqualObjects(first, @"CustomName");
+    XCTAssertTrue(first == second && second == third);
+    XCTAssertEqual(table.count, (NSUInteger)1);
+
+    // Constants are returned as themselves and are not stored again.
+    XCTAssertTrue([table atomForBytes:"Widget" Length:6] == PDFNameWidget);
+    XCTAssertEqual(table.count, (NSUInteger)1);
+}
+
+
+-(void)testSharedTableDoesNotGrow
+{
+    PDFNameTable* shared = [PDFNameTable tableForDocument:nil];
+    XCTAssertTrue([shared atomForCString:"FT"] == PDFNameFT);
+
+    NSString* name = [shared atomForCString:"Unknown"];
+    XCTAssertEqualObjects(name, @"Unknown");
+    XCTAssertEqual(shared.count, (NSUInteger)0);
+}
+
+
+-(void)testDocumentsInternTheirOwnNames
+{
+    PDFTestFile* file = [[PDFTestFile alloc] init];
+    [file appendObjectWithNumber:1 Body:@"<< /Type /Catalog /Pages 2 0 R /Custom /Value >>"];
+    [file appendObjectWithNumber:2 Body:@"<< /Type /Pages /Kids [] /Count 0 /Custom /Value >>"];
+    [file appendCrossReferenceTableForNumbers:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 3)] Trailer:@"/Size 3 /Root 1 0 R"];
+
+    PDFDocument* document = [[PDFDocument alloc] initWithData:file.data];
+    PDFDictionary* catalog = [[PDFDictionary alloc] initWithPDFRepresentation:[document codeForObjectWithNumber:1 GenerationNumber:0] Document:document];
+    PDFDictionary* pages = [[PDFDictionary alloc] initWithPDFRepresentation:[document codeForObjectWithNumber:2 GenerationNumber:0] Document:document];
+    XCTAssertTrue([catalog objectForKey:@"Custom"] == [pages objectForKey:@"Custom"]);
+    XCTAssertTrue([document.nameTable atomForName:@"Value"] == [catalog objectForKey:@"Custom"]);
+
+    PDFDocument* other = [[PDFDocument alloc] initWithData:file.data];
+    XCTAssertTrue(other.nameTable != document.nameTable);
+    XCTAssertEqual(other.nameTable.count, (NSUInteger)0);
+}
+
+
+@end
@@ -1,34 +0,0 @@
-//
-//  PDFSampleAppTests.m
-//  PDFSampleAppTests
-//
-//  Created by Derek Blair on 2013-10-06.
-//  Copyright (c) 2013 IweLabs. All rights reserved.
-//
-
-#import <XCTest/XCTest.h>
-
-@interface PDFSampleAppTests : XCTestCase
-
-@end
-
-@implementation PDFSampleAppTests
-
-- (void)setUp
-{
-    [super setUp];
-    // Put setup code here. This method is called before the invocation of each test method in the class.
-}
-
-- (void)tearDown
-{
-    // Put teardown code here. This method is called after the invocation of each test method in the class.
-    [super tearDown];
-}
-
-- (void)testExample
-{
-    XCTFail(@"No implementation for \"%s\"", __PRETTY_FUNCTION__);
-}
-
-@end
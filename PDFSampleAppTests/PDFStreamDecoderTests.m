@@ -0,0 +1,133 @@
+#import <XCTest/XCTest.h>
+#import "PDFStreamDecoder.h"
+#import "PDFDictionary.h"
+#import <zlib.h>
+
+
+/** Tests of the streaming decoders on known encodings of each filter, on filter chains and on PNG predictors.
+ */
+@interface PDFStreamDecoderTests : XCTestCase
+@end
+
+
+@interface PDFStreamDecoderTests()
+    -(NSData*)decodedData:(NSData*)data Filters:(NSArray*)filters Parameters:(NSArray*)parameters;
+    -(NSData*)deflatedData:(NSData*)data;
+@end
+
+
+@implementation PDFStreamDecoderTests
+
+
+-(void)testFilterNamesAreComparedByValue
+{
+    // A name built at run time, as read from JSON or XML, is not the same object as the constant.
+    NSString* name = [NSString stringWithFormat:@"%@Decode",@"Flate"];
+    XCTAssertTrue([PDFStreamDecoder supportsFilter:name]);
+    XCTAssertFalse([PDFStreamDecoder supportsFilter:@"JBIG2Decode"]);
+
+    NSData* plain = [@"Hello, World" dataUsingEncoding:NSASCIIStringEncoding];
+    XCTAssertEqualObjects([self decodedData:[self deflatedData:plain] Filters:@[name] Parameters:nil], plain);
+}
+
+
+-(void)testASCIIHexDecode
+{
+    NSData* encoded = [@"48 65 6c 6C6F>" dataUsingEncoding:NSASCIIStringEncoding];
+    XCTAssertEqualObjects([self decodedData:encoded Filters:@[@"ASCIIHexDecode"] Parameters:nil], [@"Hello" dataUsingEncoding:NSASCIIStringEncoding]);
+
+    // An odd final digit is followed by an implied 0.
+    encoded = [@"4>" dataUsingEncoding:NSASCIIStringEncoding];
+    const unsigned char expected[] = {0x40};
+    XCTAssertEqualObjects([self decodedData:encoded Filters:@[@"AHx"] Parameters:nil], [NSData dataWithBytes:expected length:1]);
+}
+
+
+-(void)testASCII85Decode
+{
+    NSData* encoded = [@"87cURDZ~>" dataUsingEncoding:NSASCIIStringEncoding];
+    XCTAssertEqualObjects([self decodedData:encoded Filters:@[@"ASCII85Decode"] Parameters:nil], [@"Hello" dataUsingEncoding:NSASCIIStringEncoding]);
+
+    const unsigned char zeros[4] = {0,0,0,0};
+    encoded = [@"z~>" dataUsingEncoding:NSASCIIStringEncoding];
+    XCTAssertEqualObjects([self decodedData:encoded Filters:@[@"A85"] Parameters:nil], [NSData dataWithBytes:zeros length:4]);
+}
+
+
+-(void)testRunLengthDecode
+{
+    const unsigned char encoded[] = {4, 'H', 'e', 'l', 'l', 'o', 252, '!', 128};
+    NSData* decoded = [self decodedData:[NSData dataWithBytes:encoded length:sizeof(encoded)] Filters:@[@"RunLengthDecode"] Parameters:nil];
+    XCTAssertEqualObjects(decoded, [@"Hello!!!!!" dataUsingEncoding:NSASCIIStringEncoding]);
+}
+
+
+-(void)testLZWDecode
+{
+    // The example of the PDF Reference, section 3.3.3.
+    const unsigned char encoded[] = {0x80, 0x0B, 0x60, 0x50, 0x22, 0x0C, 0x0C, 0x85, 0x01};
+    NSData* decoded = [self decodedData:[NSData dataWithBytes:encoded length:sizeof(encoded)] Filters:@[@"LZWDecode"] Parameters:nil];
+    XCTAssertEqualObjects(decoded, [@"-----A---B" dataUsingEncoding:NSASCIIStringEncoding]);
+}
+
+
+-(void)testFilterChain
+{
+    NSMutableData* plain = [NSMutableData dataWithLength:100000];
+    unsigned char* bytes = [plain mutableBytes];
+    for(NSUInteger i = 0 ; i < [plain length] ; i++)bytes[i] = (unsigned char)(i*7/13);
+
+    NSData* deflated = [self deflatedData:plain];
+    NSMutableString* hex = [NSMutableString stringWithCapacity:2*[deflated length]+1];
+    const unsigned char* deflatedBytes = [deflated bytes];
+    for(NSUInteger i = 0 ; i < [deflated length] ; i++)[hex appendFormat:@"%02X",deflatedBytes[i]];
+    [hex appendString:@">"];
+
+    NSData* decoded = [self decodedData:[hex dataUsingEncoding:NSASCIIStringEncoding] Filters:@[@"ASCIIHexDecode",@"FlateDecode"] Parameters:nil];
+    XCTAssertEqualObjects(decoded, plain);
+}
+
+
+-(void)testPNGUpPredictor
+{
+    // Two rows of three bytes, each row stored as its difference from the row above.
+    const unsigned char predicted[] = {2, 1, 2, 3, 2, 3, 4, 5};
+    const unsigned char expected[] = {1, 2, 3, 4, 6, 8};
+    PDFDictionary* parameters = [[PDFDictionary alloc] initWithPDFRepresentation:@"<< /Predictor 12 /Columns 3 >>" Document:nil];
+
+    NSData* decoded = [self decodedData:[self deflatedData:[NSData dataWithBytes:predicted length:sizeof(predicted)]] Filters:@[@"FlateDecode"] Parameters:@[parameters]];
+    XCTAssertEqualObjects(decoded, [NSData dataWithBytes:expected length:sizeof(expected)]);
+}
+
+
+-(void)testCorruptDataFails
+{
+    const unsigned char garbage[] = {0x12, 0x34, 0x56, 0x78, 0x9A};
+    PDFStreamDecoder* decoder = [[PDFStreamDecoder alloc] initWithData:[NSData dataWithBytes:garbage length:sizeof(garbage)] Filters:@[@"FlateDecode"] DecodeParameters:nil];
+    XCTAssertNil([decoder readDataOfMaximumLength:NSNotFound]);
+    XCTAssertTrue(decoder.failed);
+}
+
+
+#pragma mark - Hidden
+
+
+-(NSData*)decodedData:(NSData*)data Filters:(NSArray*)filters Parameters:(NSArray*)parameters
+{
+    PDFStreamDecoder* decoder = [[PDFStreamDecoder alloc] initWithData:data Filters:filters DecodeParameters:parameters];
+    XCTAssertNotNil(decoder, @"No decoder for %@",filters);
+    return [decoder readDataOfMaximumLength:NSNotFound];
+}
+
+
+-(NSData*)deflatedData:(NSData*)data
+{
+    uLongf length = compressBound([data length]);
+    NSMutableData* ret = [NSMutableData dataWithLength:length];
+    if(compress2([ret mutableBytes], &length, [data bytes], [data length], Z_DEFAULT_COMPRESSION) != Z_OK)return nil;
+    [ret setLength:length];
+    return ret;
+}
+
+
+@end
@@ -0,0 +1,76 @@
+#import <Foundation/Foundation.h>
+
+
+/** The PDFTestFile class builds small PDF files in memory for the unit tests.
+ Like PDFBenchmarkCorpus, it writes the file byte by byte, without CoreGraphics or ILPDFKit, so each test controls exactly which objects, streams and cross-reference sections the parser sees.
+
+     PDFTestFile* file = [[PDFTestFile alloc] init];
+     [file appendObjectWithNumber:1 Body:@"<< /Type /Catalog /Pages 2 0 R >>"];
+     [file appendObjectWithNumber:2 Body:@"<< /Type /Pages /Kids [] /Count 0 >>"];
+     [file appendCrossReferenceTableForNumbers:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 3)] Trailer:@"/Size 3 /Root 1 0 R"];
+ */
+@interface PDFTestFile : NSObject
+
+
+/** The bytes written so far, starting with the header.
+ */
+@property(nonatomic,readonly) NSMutableData* data;
+
+
+/** Creates a file with a one page form holding a single text field, object 4, whose value is value.
+
+ @param value The value of the field.
+ @return The file. Objects 1 to 5 are the catalog, the page tree, the form, the field and the page.
+ */
++(PDFTestFile*)formWithFieldValue:(NSString*)value;
+
+
+/** The offset of the latest definition of an object.
+
+ @param number The object number.
+ @return The offset, or NSNotFound if the object has not been written.
+ */
+-(NSUInteger)offsetOfObjectWithNumber:(NSUInteger)number;
+
+
+/** Appends text.
+
+ @param str The text, which must be ASCII.
+ */
+-(void)appendString:(NSString*)str;
+
+
+/** Appends an object and records its offset.
+
+ @param number The object number.
+ @param body The code of the object, between 'obj' and 'endobj'.
+ */
+-(void)appendObjectWithNumber:(NSUInteger)number Body:(NSString*)body;
+
+
+/** Appends a stream object and records its offset.
+
+ @param number The object number.
+ @param dictionary The entries of the stream dictionary other than 'Length'.
+ @param data The stream data, as stored.
+ */
+-(void)appendStreamWithNumber:(NSUInteger)number Dictionary:(NSString*)dictionary Data:(NSData*)data;
+
+
+/** Appends a classic cross-reference table, its trailer and 'startxref'.
+
+ @param numbers The object numbers the table lists. Numbers that have not been written, including 0, are listed as free.
+ @param trailer The entries of the trailer dictionary.
+ @return The offset of the table.
+ */
+-(NSUInteger)appendCrossReferenceTableForNumbers:(NSIndexSet*)numbers Trailer:(NSString*)trailer;
+
+
+/** Appends 'startxref' and the end of file marker.
+
+ @param offset The offset of the newest cross-reference section.
+ */
+-(void)appendStartxref:(NSUInteger)offset;
+
+
+@end
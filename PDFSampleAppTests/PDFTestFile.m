@@ -0,0 +1,95 @@
+#import "PDFTestFile.h"
+
+
+@implementation PDFTestFile
+{
+    NSMutableDictionary* _offsets;
+}
+
+
+-(id)init
+{
+    self = [super init];
+    if(self != nil)
+    {
+        _data = [[NSMutableData alloc] init];
+        _offsets = [[NSMutableDictionary alloc] init];
+
+        // The comment after the header holds bytes above 127, marking the file as binary.
+        const unsigned char header[] = "%PDF-1.5\n%\xE2\xE3\xCF\xD3\n";
+        [_data appendBytes:header length:sizeof(header)-1];
+    }
+    return self;
+}
+
+
++(PDFTestFile*)formWithFieldValue:(NSString*)value
+{
+    PDFTestFile* ret = [[PDFTestFile alloc] init];
+    [ret appendObjectWithNumber:1 Body:@"<< /Type /Catalog /Pages 2 0 R /AcroForm 3 0 R >>"];
+    [ret appendObjectWithNumber:2 Body:@"<< /Type /Pages /Kids [5 0 R] /Count 1 >>"];
+    [ret appendObjectWithNumber:3 Body:@"<< /Fields [4 0 R] /DA (/Helv 0 Tf 0 g) >>"];
+    [ret appendObjectWithNumber:4 Body:[NSString stringWithFormat:@"<< /FT /Tx /T (name) /V (%@) /Type /Annot /Subtype /Widget /F 4 /P 5 0 R /Rect [100 700 300 720] /DA (/Helv 10 Tf 0 g) >>",value]];
+    [ret appendObjectWithNumber:5 Body:@"<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Annots [4 0 R] >>"];
+    [ret appendCrossReferenceTableForNumbers:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 6)] Trailer:@"/Size 6 /Root 1 0 R"];
+    return ret;
+}
+
+
+-(NSUInteger)offsetOfObjectWithNumber:(NSUInteger)number
+{
+    NSNumber* ret = _offsets[@(number)];
+    return (ret?[ret unsignedIntegerValue]:NSNotFound);
+}
+
+
+-(void)appendString:(NSString*)str
+{
+    [_data appendData:[str dataUsingEncoding:NSASCIIStringEncoding]];
+}
+
+
+-(void)appendObjectWithNumber:(NSUInteger)number Body:(NSString*)body
+{
+    _offsets[@(number)] = @([_data length]);
+    [self appendString:[NSString stringWithFormat:@"%u 0 obj\n%@\nendobj\n",(unsigned int)number,body]];
+}
+
+
+-(void)appendStreamWithNumber:(NSUInteger)number Dictionary:(NSString*)dictionary Data:(NSData*)data
+{
+    _offsets[@(number)] = @([_data length]);
+    [self appendString:[NSString stringWithFormat:@"%u 0 obj\n<< %@ /Length %u >>\nstream\n",(unsigned int)number,dictionary,(unsigned int)[data length]]];
+    [_data appendData:data];
+    [self appendString:@"\nendstream\nendobj\n"];
+}
+
+
+-(NSUInteger)appendCrossReferenceTableForNumbers:(NSIndexSet*)numbers Trailer:(NSString*)trailer
+{
+    NSUInteger ret = [_data length];
+    NSMutableString* table = [NSMutableString stringWithString:@"xref\n"];
+    [numbers enumerateRangesUsingBlock:^(NSRange range, BOOL* stop)
+    {
+        [table appendFormat:@"%u %u\n",(unsigned int)range.location,(unsigned int)range.length];
+        for(NSUInteger n = range.location ; n < NSMaxRange(range) ; n++)
+        {
+            NSUInteger offset = (n == 0?NSNotFound:[self offsetOfObjectWithNumber:n]);
+            if(offset == NSNotFound)[table appendString:@"0000000000 65535 f\r\n"];
+            else [table appendFormat:@"%010u 00000 n\r\n",(unsigned int)offset];
+        }
+    }];
+    [table appendFormat:@"trailer\n<< %@ >>\n",trailer];
+    [self appendString:table];
+    [self appendStartxref:ret];
+    return ret;
+}
+
+
+-(void)appendStartxref:(NSUInteger)offset
+{
+    [self appendString:[NSString stringWithFormat:@"startxref\n%u\n%%%%EOF\n",(unsigned int)offset]];
+}
+
+
+@end